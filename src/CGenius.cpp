@@ -42,6 +42,7 @@
 #include <base/GsLogging.h>
 
 #include "engine/CGameLauncher.h"
+#include "engine/keen/dreams/dreamsbench.h"
 
 #include "sdl/audio/Audio.h"
 
@@ -103,6 +104,14 @@ int main(int argc, char *argv[])
     }
 
 
+    // The Keen Dreams benchmark runs without window and sound device
+    if( dreams::isBenchmarkRequested(argc, argv) )
+    {
+        const int result = dreams::runBenchmark(argc, argv);
+        UnInitThreadPool();
+        return result;
+    }
+
     // Init Video Driver with SDL all together
     if( !gVideoDriver.init() )
     {
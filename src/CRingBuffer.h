@@ -5,196 +5,243 @@
  *      Author: gerstrong
  *
  *  This small class handles a data structure called ring buffer.
- *  This is very useful for audio implementations, because in many
- *  cases you have a buffer which is read and converted to another buffer
- *  which is the waveform for the audio hardware. As those buffers
- *  have different sizes, there are a least two pointers and/or one
- *  size variable we need to handle the data transfer correctly.
+ *  It sits between a thread which produces data (a decoder or synthesizer)
+ *  and one which consumes it (mostly the audio callback).
  *
- *  Those pointers must be verified all the in order to avoid overflows
- *  The ring buffer implementation ensures that this never happens.
+ *  Exactly one thread may write and exactly one thread may read at the same time.
+ *  Neither of them ever blocks or takes a lock, so it is safe to be used
+ *  in the audio callback. The read and the write index are kept on different
+ *  cache lines, so both sides don't slow each other down.
  *
- *  This class manages those pointers and also the memory allocation, deallocation.
- *
- *  Now there are two uses of this class. One is similar to the list structure.
- *  You read one element and if it gets to the end of the buffer
- *  it will return to the start.
- *
- *  The second choice is to read arrays from the buffer.
- *  In that case you have to read slices. (See below)
+ *  There are two ways to use it. push() and pop() copy whole arrays in and out.
+ *  If the data can be produced or consumed in place, writeSpans() and readSpans()
+ *  hand out the (at most two) contiguous parts of the ring, which are then
+ *  released with commitWrite() or commitRead().
  */
 
 #ifndef CRINGBUFFER_H_
 #define CRINGBUFFER_H_
 
-// TODO: It is more of a container. We should rename that to Ring or RingComposite or similar.
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <cstddef>
 
 template <typename T>
-class RingBuffer {
+class RingBuffer
+{
 public:
 
-	RingBuffer():
-        mp_start(nullptr),
-        mp_cur(nullptr),
-        mp_end(nullptr),
-		m_size(0)
-	{}
+    /// A contiguous part of the ring
+    struct Span
+    {
+        T *data = nullptr;
+        size_t size = 0;
+    };
+
+    /// What is available may wrap around the end of the storage, so it comes in two parts
+    struct Spans
+    {
+        Span first;
+        Span second;
+
+        size_t size() const
+        {   return first.size + second.size;   }
+    };
+
+    RingBuffer() {}
+
+    explicit RingBuffer(const size_t capacity)
+    {   reserve(capacity);  }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    /**
+     * Allocates the storage for capacity elements and drops anything in it.
+     * Neither the reader nor the writer may use the ring meanwhile.
+     */
+    bool reserve(const size_t capacity)
+    {
+        mpData.reset( (capacity > 0) ? new T[capacity] : nullptr );
+        mCapacity = capacity;
+        mIndexRange = 2*capacity;
+        reset();
+        return (capacity > 0);
+    }
+
+    /**
+     * Frees the storage. Neither the reader nor the writer may use the ring meanwhile.
+     */
+    void clear()
+    {
+        mpData.reset();
+        mCapacity = 0;
+        mIndexRange = 0;
+        reset();
+    }
+
+    /**
+     * Drops everything which has not been read yet, but keeps the storage.
+     * Neither the reader nor the writer may use the ring meanwhile.
+     */
+    void reset()
+    {
+        mWriteIndex.store(0, std::memory_order_relaxed);
+        mReadIndex.store(0, std::memory_order_relaxed);
+        mCachedReadIndex = 0;
+        mCachedWriteIndex = 0;
+    }
+
+    size_t capacity() const
+    {   return mCapacity;   }
+
 
-	~RingBuffer()
-	{
-		if(!empty())
-			clear();
-	}
+    /// Elements which can be written right now. Call it from the writer.
+    size_t writeAvailable()
+    {
+        const size_t w = mWriteIndex.load(std::memory_order_relaxed);
+        mCachedReadIndex = mReadIndex.load(std::memory_order_acquire);
+        return mCapacity - distance(mCachedReadIndex, w);
+    }
 
+    /// Elements which can be read right now. Call it from the reader.
+    size_t readAvailable()
+    {
+        const size_t r = mReadIndex.load(std::memory_order_relaxed);
+        mCachedWriteIndex = mWriteIndex.load(std::memory_order_acquire);
+        return distance(r, mCachedWriteIndex);
+    }
 
 
-    void operator=(RingBuffer &&second)
+    /**
+     * The free parts of the ring, together not more than maxElems elements.
+     * Fill them, then call commitWrite() with the number of elements written.
+     */
+    Spans writeSpans(const size_t maxElems)
     {
-        mp_start = second.mp_start;
-        mp_cur = second.mp_start;
-        mp_end = second.mp_end;
-        m_size = second.m_size;
+        const size_t w = mWriteIndex.load(std::memory_order_relaxed);
+        size_t count = mCapacity - distance(mCachedReadIndex, w);
 
-        second.mp_start = nullptr;
-        second.mp_cur = nullptr;
-        second.mp_end = nullptr;
-        second.m_size = 0;
+        // Only look at the reader's index if the cached one doesn't leave enough space
+        if(count < maxElems)
+            count = writeAvailable();
+
+        return spansAt(w, std::min(count, maxElems));
+    }
+
+    /// Publishes count elements which have been written into the spans
+    void commitWrite(const size_t count)
+    {
+        const size_t w = mWriteIndex.load(std::memory_order_relaxed);
+        mWriteIndex.store(advance(w, count), std::memory_order_release);
     }
 
-	/**
-	 * Allocates memory for the Ring buffer
-	 */
-	bool reserve(unsigned int size)
-	{
-		if(!empty())
-		{
-			// TODO: throw exception here! This must never happen!
-			return false;
-		}
-
-		m_size = size;
-		if(m_size == 0)
-			return false;
-		mp_cur = new T[m_size];
-		mp_start = mp_cur;
-		mp_end = mp_start + m_size;
-
-		return true;
-	}
-
-
-	/**
-	 * Clears the buffer without checking if ever was reserved. Be careful!
-	 */
-	void clear()
-	{
-		delete [] mp_start;
-        mp_start = nullptr;
-		m_size = 0;
-	}
-
-
-	/**
-	 * Just checks and tells if the ring buffer is actually empty or not reserved
-	 */
-	bool empty()
-	{
-        return (m_size == 0 || mp_start == nullptr);
-	}
-
-	/**
-	 * Just tell whether the buffer of the as at the initial pointer which must be the same as at the end, because
-	 * until this call, the pointer was rewound.
-	 */
-	bool atStart()
-	{	return (mp_cur == mp_start);	}
-
-	/**
-	 * Although a ring doesn't have a start, this function will set the pointer to first data chunk that on what it
-	 * was initialized
-	 */
-	void gotoStart()
-	{	mp_cur=mp_start;	}
-
-	/**
-	 * Just return the absolute start of the pointer.
-	 */
-	T *getStartPtr()
-	{	return mp_start;	}
-
-	/**
-	 * Just return the absolute end of the pointer.
-	 */
-	T *getLastElem()
-	{	return mp_end-1;	}
-
-
-	/**
-	 * This will get the next Element in the ring. Similar to the front function of std::list, but it's a ring.
-	 * This will copy the data to the data type variable you are using, so please don't use too big datastructures for this
-	 * if you need fast code.
-	 */
-	T getNextElement()
-	{
-		const T data = *mp_cur;
-		this->operator ++();
-		return data;
-	}
-
-
-	/**
-	 * This function will give you a pointer the current data position within the ring
-	 * It will also tell you how many Elements of that data type (n_elem) you can use to read.
-	 * If it could read all the elements it will return the same number you entered.
-	 * If not, it will return the number of read elements, which will be smaller.
-	 * That happens, when the ring buffer gets near to the pointers end and might overflow.
-	 * This function will avoid such danger. If the function didn't read the desired elements, just use it again
-	 * with the number of remaining elements.
-	 *
-	 * This function will not read data, because it might slow down the code. For reading and writing the
-	 * using the read pointer you must care yourself.
-	 */
-	unsigned int getSlicePtr(T *&data, const unsigned int n_elem)
-	{
-		data = mp_cur;
-
-		if(mp_cur + n_elem <= mp_end) // All elements can be read
-			return n_elem;
-		else // you cannot read all the elements, return a lower number of readable elements
-			return mp_end-mp_cur;
-	}
-
-
-	/**
-	 * Just makes the current pointer in the ring buffer go further...
-	 */
-	void operator+=(const unsigned int n_elem)
-				{
-		if(mp_cur + n_elem < mp_end)
-			mp_cur += n_elem;
-		else
-		{
-			// Hey, we are a ring. End of the data? Go to the start!
-			const unsigned int newpos = n_elem-(mp_end-mp_cur);
-			mp_cur = mp_start + newpos;
-		}
-				}
-
-	/**
-	 * increment pointer by one element or go the start if cur == end ptr
-	 */
-	void operator++()
-	{
-		mp_cur++;
-
-		if( mp_cur == mp_end )
-			mp_cur = mp_start;
-	}
+    /**
+     * The filled parts of the ring, together not more than maxElems elements.
+     * Once they are consumed, call commitRead() with the number of elements used.
+     */
+    Spans readSpans(const size_t maxElems)
+    {
+        const size_t r = mReadIndex.load(std::memory_order_relaxed);
+        size_t count = distance(r, mCachedWriteIndex);
+
+        if(count < maxElems)
+            count = readAvailable();
 
+        return spansAt(r, std::min(count, maxElems));
+    }
+
+    /// Gives count consumed elements back to the writer
+    void commitRead(const size_t count)
+    {
+        const size_t r = mReadIndex.load(std::memory_order_relaxed);
+        mReadIndex.store(advance(r, count), std::memory_order_release);
+    }
+
+
+    /**
+     * Appends up to count elements
+     * \return number of elements actually written
+     */
+    size_t push(const T *src, const size_t count)
+    {
+        const Spans spans = writeSpans(count);
+
+        std::copy(src, src + spans.first.size, spans.first.data);
+        std::copy(src + spans.first.size, src + spans.size(), spans.second.data);
+
+        commitWrite(spans.size());
+        return spans.size();
+    }
+
+    /**
+     * Takes up to count elements out of the ring
+     * \return number of elements actually read
+     */
+    size_t pop(T *dst, const size_t count)
+    {
+        const Spans spans = readSpans(count);
+
+        std::copy(spans.first.data, spans.first.data + spans.first.size, dst);
+        std::copy(spans.second.data, spans.second.data + spans.second.size, dst + spans.first.size);
+
+        commitRead(spans.size());
+        return spans.size();
+    }
 
 private:
-	T *mp_start, *mp_cur, *mp_end;
-	unsigned int m_size;
+
+    // The indices run modulo twice the capacity. That tells a full ring from an empty one
+    // and they never overflow, which would break the positions if the capacity
+    // is not a power of two.
+    size_t advance(const size_t index, const size_t count) const
+    {
+        const size_t next = index + count;
+        return (next >= mIndexRange) ? next - mIndexRange : next;
+    }
+
+    // Elements from one index up to another
+    size_t distance(const size_t from, const size_t to) const
+    {
+        return (to >= from) ? to - from : to + mIndexRange - from;
+    }
+
+    Spans spansAt(const size_t index, const size_t count) const
+    {
+        Spans spans;
+
+        if(count == 0)
+            return spans;
+
+        const size_t pos = (index >= mCapacity) ? index - mCapacity : index;
+        const size_t first = std::min(count, mCapacity - pos);
+
+        spans.first.data = mpData.get() + pos;
+        spans.first.size = first;
+        spans.second.data = mpData.get();
+        spans.second.size = count - first;
+
+        return spans;
+    }
+
+    static const size_t CacheLineSize = 64;
+
+    std::unique_ptr<T[]> mpData;
+    size_t mCapacity = 0;
+    size_t mIndexRange = 0;
+
+    // Written by the writer only. The cached read index saves touching the reader's line every time.
+    char mPadWriter[CacheLineSize];
+    std::atomic<size_t> mWriteIndex{0};
+    size_t mCachedReadIndex = 0;
+
+    // Written by the reader only
+    char mPadReader[CacheLineSize];
+    std::atomic<size_t> mReadIndex{0};
+    size_t mCachedWriteIndex = 0;
+
+    char mPadEnd[CacheLineSize];
 };
 
 #endif /* CRINGBUFFER_H_ */
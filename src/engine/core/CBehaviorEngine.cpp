@@ -19,7 +19,12 @@
 
 void CBehaviorEngine::setMessage(const std::string &name, const std::string &message)
 {	
-  stringmap[name] = message;	
+  mMessages.set(name, message);
+}
+
+void CBehaviorEngine::setMessages(const MessageTable &messages)
+{
+  mMessages.merge(messages);
 }
 
 /**
@@ -77,18 +82,22 @@ std::vector<CTileProperties> &CBehaviorEngine::getTileProperties(size_t tmnum)
     return m_TileProperties[tmnum];
 }
 
-// returns a pointer to the string with name 'name'
+// returns a copy of the string with name 'name'
 std::string CBehaviorEngine::getString(const std::string& name)
 {
-	std::string text;
-	std::map<std::string, std::string>::iterator it = stringmap.find(name);
+	size_t length = 0;
+	const char *text = mMessages.find(name.c_str(), &length);
 
-	if( it != stringmap.end() )
-		text = it->second;
-	else
-		text = "";
+	if( text )
+		return std::string(text, length);
 
-	return text;
+	return "";
+}
+
+const char *CBehaviorEngine::getMessage(const char *name) const
+{
+	const char *text = mMessages.find(name);
+	return text ? text : "";
 }
 
 size_t CBehaviorEngine::getEpisode()
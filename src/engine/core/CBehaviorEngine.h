@@ -23,6 +23,7 @@
 #include "engine/keen/galaxy/res/EGAStructs.h"
 #include <base/Configurator.h>
 #include "fileio/CTileProperties.h"
+#include "fileio/MessageTable.h"
 #include "CPhysicsSettings.h"
 #include <base/TypeDefinitions.h>
 #include <base/GsEvent.h>
@@ -79,6 +80,11 @@ public:
 	void setMessage(const std::string &name,
 					const std::string &message);
 
+	/**
+	 * \brief Copies all the messages of the table into the engine, replacing those of the same name
+	 */
+	void setMessages(const MessageTable &messages);
+
 	bool readTeleporterTable(byte *p_exedata);
 
 	std::vector<CTileProperties> &getTileProperties(size_t tmnum = 1);
@@ -89,6 +95,13 @@ public:
 
 	std::string getString(const std::string& name);
 
+	/**
+	 * \brief Same as getString, but without allocating anything. Use this where texts are
+	 *        looked up often. The returned text stays valid until the messages are changed again.
+	 * \return pointer to the text or an empty string if there is no text with that name
+	 */
+	const char *getMessage(const char *name) const;
+
 	// This function evaluates if the used engine is galaxy or vorticon
 	EngineType getEngine();
 	size_t getEpisode();
@@ -134,7 +147,7 @@ private:
 	std::vector<CTileProperties> m_TileProperties[2];
     CPhysicsSettings m_PhysicsSettings;
 
-	std::map<std::string,std::string> stringmap;
+	MessageTable mMessages;
 	std::vector<stTeleporterTable> m_TeleporterTable; // Teleporter table used for the destinations
 													  // used by Episode 1 especially
 	int numStrings;
@@ -13,11 +13,13 @@
 #include "base/utils/StringUtils.h"
 #include <base/GsLogging.h>
 #include "engine/core/CBehaviorEngine.h"
+#include "fileio/CExeFile.h"
 
 #include <cstring>
 
-CMessages::CMessages(unsigned char *p_exebuf, char episode, bool demo, int version) :
-	mp_exe(p_exebuf),
+CMessages::CMessages(CExeFile &ExeFile, char episode, bool demo, int version) :
+	mExeFile(ExeFile),
+	mp_exe(ExeFile.getRawData()),
 	mOffset(0)
 {
 	m_episode = episode;
@@ -329,6 +331,14 @@ bool CMessages::extractEp6DemoStrings(std::map<std::string, std::string>& String
 
 bool CMessages::extractGlobalStrings()
 {
+	// Same exe data as last time? Then the strings have already been extracted
+	if(const MessageTable *cached = mExeFile.getCachedMessages())
+	{
+		gBehaviorEngine.setMessages(*cached);
+		gLogging.ftextOut("Loaded %d strings from the message cache.<br>", cached->size());
+		return !cached->empty();
+	}
+
 	std::map<std::string, std::string> StringMap; // Structure which stores all the extracted string
 
 	// Here we begin to extract all the proper Strings
@@ -462,13 +472,17 @@ bool CMessages::extractGlobalStrings()
 
 	// Now pass all the Map to the global text structure
 	// Still a bad idea, because it's global string.
+	MessageTable messages;
+	for( const auto &strPair : StringMap )
+	{
+		messages.set(strPair.first, strPair.second);
+	}
+
+	mExeFile.cacheMessages(messages);
+
 	if(!StringMap.empty())
 	{
-		std::map<std::string, std::string>::iterator i;
-		for( i = StringMap.begin() ; i != StringMap.end() ; i++ )
-		{
-			gBehaviorEngine.setMessage(i->first, i->second);
-		}
+		gBehaviorEngine.setMessages(messages);
 		gLogging.ftextOut("Loaded %d strings from the exe-file.<br>", StringMap.size());
 		return true;
 	}
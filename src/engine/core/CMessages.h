@@ -11,9 +11,11 @@
 #include <string>
 #include <map>
 
+class CExeFile;
+
 class CMessages {
 public:	
-	CMessages(unsigned char *p_exebuf, char episode, bool demo, int version);
+	CMessages(CExeFile &ExeFile, char episode, bool demo, int version);
 	
 	bool extractGlobalStrings();
 	
@@ -37,6 +39,7 @@ private:
 	bool extractEp6Strings(std::map<std::string, std::string>& StringMap);
 	bool extractEp6DemoStrings(std::map<std::string, std::string>& StringMap);
 
+	CExeFile &mExeFile;
 	unsigned char *mp_exe;
 	char m_episode;
 	bool m_demo;
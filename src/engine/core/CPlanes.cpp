@@ -6,6 +6,7 @@
  */
 
 #include "CPlanes.h"
+#include "EGAPlanar.h"
 #include <stdio.h>
 
 
@@ -57,18 +58,88 @@ void CPlanes::setOffsets(unsigned long p1, unsigned long p2, unsigned long p3,
 	    getbit_bitmask[i] = 128;
 }
 /**
- * This functions read one plane of graphics to a designated pointer which is derived by
- * a SDL-Surface normally
+ * \brief	Reads count bits of plane p in a row and ORs them into pixels.
+ *			The bits before and after the byte aligned part go through getbit(),
+ *			the aligned bytes are expanded eight pixels at a time.
  */
-void CPlanes::readPlane(uint32_t p, uint8_t *pixels, uint16_t width, uint16_t height)
+void CPlanes::readBits(uint32_t p, uint8_t *pixels, size_t count)
+{
+	if(!getbit_bitmask[p])
+	{
+		getbit_bitmask[p] = 128;
+		getbit_bytepos[p]++;
+	}
+
+	while(count > 0 && getbit_bitmask[p] != 128)
+	{
+		*pixels++ |= (getbit(p) << p);
+		count--;
+	}
+
+	const size_t numBytes = count/8;
+	if(numBytes > 0)
+	{
+		planar::orPlane(pixels, m_dataptr + getbit_bytepos[p], numBytes, p);
+		getbit_bytepos[p] += numBytes;
+		pixels += 8*numBytes;
+		count -= 8*numBytes;
+	}
+
+	while(count > 0)
+	{
+		*pixels++ |= (getbit(p) << p);
+		count--;
+	}
+}
+
+/**
+ * \brief	Reads count bits of each of the four colour planes in a row.
+ *			If all of them start at a byte boundary, this is done in one pass.
+ */
+void CPlanes::readAllBits(uint8_t *pixels, size_t count)
 {
-    for(uint16_t y=0 ; y<height ; y++)
+	for(int p=0 ; p<4 ; p++)
 	{
-        for(uint16_t x=0 ; x<width ; x++)
+		if(!getbit_bitmask[p])
 		{
-			pixels[y*width + x] |= (getbit(p) << p);
+			getbit_bitmask[p] = 128;
+			getbit_bytepos[p]++;
 		}
 	}
+
+	const bool aligned = getbit_bitmask[0] == 128 && getbit_bitmask[1] == 128 &&
+						 getbit_bitmask[2] == 128 && getbit_bitmask[3] == 128;
+
+	if(!aligned)
+	{
+		for(uint32_t p=0 ; p<4 ; p++)
+			readBits(p, pixels, count);
+		return;
+	}
+
+	const size_t numBytes = count/8;
+	const uint8_t * const planes[4] = { m_dataptr + getbit_bytepos[0],
+										m_dataptr + getbit_bytepos[1],
+										m_dataptr + getbit_bytepos[2],
+										m_dataptr + getbit_bytepos[3] };
+
+	planar::toChunky(pixels, planes, numBytes);
+
+	for(uint32_t p=0 ; p<4 ; p++)
+	{
+		getbit_bytepos[p] += numBytes;
+		readBits(p, pixels + 8*numBytes, count - 8*numBytes);
+	}
+}
+
+/**
+ * This functions read one plane of graphics to a designated pointer which is derived by
+ * a SDL-Surface normally
+ */
+void CPlanes::readPlane(uint32_t p, uint8_t *pixels, uint16_t width, uint16_t height)
+{
+	// The rows are stored one after another, so this is one long run of bits
+	readBits(p, pixels, size_t(width)*height);
 }
 
 /**
@@ -79,19 +150,36 @@ void CPlanes::readPlane(uint32_t p, uint8_t *pixels, uint16_t width, uint16_t he
 void CPlanes::readPlaneofTiles(uint32_t p, uint8_t *pixels, uint16_t columns,
                                 uint16_t tilesize, uint16_t numtiles)
 {
-    uint8_t *u_offset;
     for(uint32_t t=0;t<numtiles;t++)
 	{
+		uint8_t *tileOrigin = pixels +
+							  tilesize*tilesize*columns*(t/columns) +
+							  tilesize*(t%columns);
+
         for(uint32_t y=0;y<tilesize;y++)
 		{
-            for(uint32_t x=0;x<tilesize;x++)
-			{
-				u_offset = pixels +
-						   tilesize*tilesize*columns*(t/columns) +
-						   tilesize*(t%columns) +
-						   tilesize*columns*y + x;
-				*u_offset |= (getbit(p) << p);
-			}
+			readBits(p, tileOrigin + tilesize*columns*y, tilesize);
+		}
+	}
+}
+
+void CPlanes::readPlanes(uint8_t *pixels, uint16_t width, uint16_t height)
+{
+	readAllBits(pixels, size_t(width)*height);
+}
+
+void CPlanes::readPlanesofTiles(uint8_t *pixels, uint16_t columns,
+								uint16_t tilesize, uint16_t numtiles)
+{
+	for(uint32_t t=0;t<numtiles;t++)
+	{
+		uint8_t *tileOrigin = pixels +
+							  tilesize*tilesize*columns*(t/columns) +
+							  tilesize*(t%columns);
+
+		for(uint32_t y=0;y<tilesize;y++)
+		{
+			readAllBits(tileOrigin + tilesize*columns*y, tilesize);
 		}
 	}
 }
@@ -6,6 +6,7 @@
  */
 
 #include <base/TypeDefinitions.h>
+#include <cstddef>
 
 #ifndef CPLANES_H_
 #define CPLANES_H_
@@ -20,8 +21,17 @@ public:
     void readPlane(uint32_t p, uint8_t *pixels, uint16_t width, uint16_t height);
     void readPlaneofTiles(uint32_t p, uint8_t *pixels, uint16_t columns,
                                 uint16_t tilesize, uint16_t numtiles);
+
+    // Same as readPlane and readPlaneofTiles, but all four colour planes are read at once.
+    // The pixels have to be cleared before.
+    void readPlanes(uint8_t *pixels, uint16_t width, uint16_t height);
+    void readPlanesofTiles(uint8_t *pixels, uint16_t columns,
+                           uint16_t tilesize, uint16_t numtiles);
 	
 private:
+	void readBits(uint32_t p, uint8_t *pixels, size_t count);
+	void readAllBits(uint8_t *pixels, size_t count);
+
 	unsigned long getbit_bytepos[5];
 	unsigned char getbit_bitmask[5];
 	
@@ -0,0 +1,395 @@
+/*
+ * EGAPlanar.cpp
+ *
+ *  Created on: 18.10.2026
+ *
+ *  See EGAPlanar.h. There are three kernels: a portable one driven by a
+ *  lookup table which expands one plane byte into eight pixel bytes at once,
+ *  and SSE2 and NEON ones which test the bits of 16 pixels in parallel.
+ *  All of them produce exactly the same output.
+ */
+
+#include "EGAPlanar.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PLANAR_USE_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PLANAR_USE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace planar
+{
+
+namespace
+{
+
+/**
+ * Every entry has the eight bits of its index spread over eight bytes,
+ * stored in memory order, so the leftmost pixel (bit 7) lands at the lowest address.
+ * The values are 0 or 1 per byte, so shifting the whole word by up to 7 never
+ * carries into the neighbour pixel.
+ */
+struct ExpandTable
+{
+    ExpandTable()
+    {
+        for(unsigned int value = 0 ; value < 256 ; value++)
+        {
+            uint8_t bytes[8];
+            for(unsigned int b = 0 ; b < 8 ; b++)
+            {
+                bytes[b] = (value >> (7-b)) & 1;
+            }
+            memcpy(&entry[value], bytes, sizeof(bytes));
+        }
+    }
+
+    uint64_t entry[256];
+};
+
+const uint64_t *expandTable()
+{
+    static const ExpandTable table;
+    return table.entry;
+}
+
+/// Table driven conversion of the bytes [start, end) of all four planes
+void toChunkyTable(uint8_t *dst,
+                   const uint8_t * const planes[4],
+                   const size_t start,
+                   const size_t end)
+{
+    const uint64_t *exp = expandTable();
+
+    for(size_t i = start ; i < end ; i++)
+    {
+        const uint64_t pixels =  exp[planes[0][i]]        |
+                                (exp[planes[1][i]] << 1)  |
+                                (exp[planes[2][i]] << 2)  |
+                                (exp[planes[3][i]] << 3);
+        memcpy(dst + 8*i, &pixels, sizeof(pixels));
+    }
+}
+
+/// Table driven masking of the bytes [start, end), where a set bit means transparent
+void applyMaskTable(uint8_t *dst,
+                    const uint8_t *mask,
+                    const size_t start,
+                    const size_t end,
+                    const uint8_t maskIndex)
+{
+    const uint64_t *exp = expandTable();
+    const uint64_t fill = 0x0101010101010101ULL * maskIndex;
+
+    for(size_t i = start ; i < end ; i++)
+    {
+        // 0x01 -> 0xFF per byte of the pixels the mask covers
+        const uint64_t covered = exp[mask[i]] * 0xFF;
+
+        uint64_t pixels;
+        memcpy(&pixels, dst + 8*i, sizeof(pixels));
+        pixels = (pixels & ~covered) | (fill & covered);
+        memcpy(dst + 8*i, &pixels, sizeof(pixels));
+    }
+}
+
+
+#if defined(PLANAR_USE_SSE2)
+
+const size_t SIMD_BLOCK = 16;
+
+/**
+ * Spreads the 16 bytes at src over 8 vectors. Each vector holds the
+ * bits of two source bytes as 0x00 or 0xFF per pixel.
+ */
+inline void expandBlock(const uint8_t *src, __m128i out[8])
+{
+    const __m128i bits = _mm_setr_epi8(char(0x80), 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                       char(0x80), 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+
+    const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+    const __m128i lo  = _mm_unpacklo_epi8(value, value);
+    const __m128i hi  = _mm_unpackhi_epi8(value, value);
+    const __m128i q[4] = { _mm_unpacklo_epi16(lo, lo), _mm_unpackhi_epi16(lo, lo),
+                           _mm_unpacklo_epi16(hi, hi), _mm_unpackhi_epi16(hi, hi) };
+
+    for(int k = 0 ; k < 4 ; k++)
+    {
+        const __m128i a = _mm_unpacklo_epi32(q[k], q[k]);
+        const __m128i b = _mm_unpackhi_epi32(q[k], q[k]);
+        out[2*k]   = _mm_cmpeq_epi8(_mm_and_si128(a, bits), bits);
+        out[2*k+1] = _mm_cmpeq_epi8(_mm_and_si128(b, bits), bits);
+    }
+}
+
+void toChunkySimd(uint8_t *dst,
+                  const uint8_t * const planes[4],
+                  const uint8_t *mask,
+                  const size_t numBlocks,
+                  const uint8_t maskIndex)
+{
+    const __m128i fill = _mm_set1_epi8(char(maskIndex));
+
+    for(size_t blk = 0 ; blk < numBlocks ; blk++)
+    {
+        const size_t off = blk*SIMD_BLOCK;
+        __m128i acc[8], bitsOfPlane[8];
+
+        expandBlock(planes[0] + off, bitsOfPlane);
+        const __m128i one = _mm_set1_epi8(1);
+        for(int k = 0 ; k < 8 ; k++)
+            acc[k] = _mm_and_si128(bitsOfPlane[k], one);
+
+        for(int p = 1 ; p < 4 ; p++)
+        {
+            const __m128i planeBit = _mm_set1_epi8(char(1<<p));
+            expandBlock(planes[p] + off, bitsOfPlane);
+            for(int k = 0 ; k < 8 ; k++)
+                acc[k] = _mm_or_si128(acc[k], _mm_and_si128(bitsOfPlane[k], planeBit));
+        }
+
+        if(mask)
+        {
+            expandBlock(mask + off, bitsOfPlane);
+            for(int k = 0 ; k < 8 ; k++)
+            {
+                acc[k] = _mm_or_si128(_mm_andnot_si128(bitsOfPlane[k], acc[k]),
+                                      _mm_and_si128(bitsOfPlane[k], fill));
+            }
+        }
+
+        __m128i *out = reinterpret_cast<__m128i*>(dst + 8*off);
+        for(int k = 0 ; k < 8 ; k++)
+            _mm_storeu_si128(out + k, acc[k]);
+    }
+}
+
+#elif defined(PLANAR_USE_NEON)
+
+const size_t SIMD_BLOCK = 2;
+
+void toChunkySimd(uint8_t *dst,
+                  const uint8_t * const planes[4],
+                  const uint8_t *mask,
+                  const size_t numBlocks,
+                  const uint8_t maskIndex)
+{
+    static const uint8_t bitsArr[16] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                         0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
+    const uint8x16_t bits = vld1q_u8(bitsArr);
+    const uint8x16_t fill = vdupq_n_u8(maskIndex);
+
+    for(size_t blk = 0 ; blk < numBlocks ; blk++)
+    {
+        const size_t off = blk*SIMD_BLOCK;
+        uint8x16_t acc = vdupq_n_u8(0);
+
+        for(int p = 0 ; p < 4 ; p++)
+        {
+            const uint8x16_t value = vcombine_u8(vdup_n_u8(planes[p][off]),
+                                                 vdup_n_u8(planes[p][off+1]));
+            acc = vorrq_u8(acc, vandq_u8(vtstq_u8(value, bits), vdupq_n_u8(uint8_t(1<<p))));
+        }
+
+        if(mask)
+        {
+            const uint8x16_t value = vcombine_u8(vdup_n_u8(mask[off]),
+                                                 vdup_n_u8(mask[off+1]));
+            acc = vbslq_u8(vtstq_u8(value, bits), fill, acc);
+        }
+
+        vst1q_u8(dst + 8*off, acc);
+    }
+}
+
+#endif
+
+}
+
+
+void toChunky(uint8_t *dst,
+              const uint8_t * const planes[4],
+              const size_t numBytes)
+{
+    size_t done = 0;
+
+#if defined(PLANAR_USE_SSE2) || defined(PLANAR_USE_NEON)
+    const size_t numBlocks = numBytes/SIMD_BLOCK;
+    toChunkySimd(dst, planes, nullptr, numBlocks, 0);
+    done = numBlocks*SIMD_BLOCK;
+#endif
+
+    toChunkyTable(dst, planes, done, numBytes);
+}
+
+
+void toChunkyMasked(uint8_t *dst,
+                    const uint8_t * const planes[4],
+                    const uint8_t *mask,
+                    const size_t numBytes,
+                    const uint8_t maskIndex)
+{
+    size_t done = 0;
+
+#if defined(PLANAR_USE_SSE2) || defined(PLANAR_USE_NEON)
+    const size_t numBlocks = numBytes/SIMD_BLOCK;
+    toChunkySimd(dst, planes, mask, numBlocks, maskIndex);
+    done = numBlocks*SIMD_BLOCK;
+#endif
+
+    toChunkyTable(dst, planes, done, numBytes);
+    applyMaskTable(dst, mask, done, numBytes, maskIndex);
+}
+
+
+void toPalettised(uint32_t *dst,
+                  const uint8_t * const planes[4],
+                  const size_t numBytes,
+                  const uint32_t *palette)
+{
+    // Go through a small buffer which stays in the L1 cache
+    const size_t CHUNK = 64;
+    uint8_t indices[8*CHUNK];
+
+    for(size_t start = 0 ; start < numBytes ; start += CHUNK)
+    {
+        const size_t len = (numBytes-start < CHUNK) ? (numBytes-start) : CHUNK;
+        const uint8_t * const chunkPlanes[4] = { planes[0]+start, planes[1]+start,
+                                                 planes[2]+start, planes[3]+start };
+        toChunky(indices, chunkPlanes, len);
+        palettise(dst + 8*start, indices, 8*len, palette);
+    }
+}
+
+
+void orPlane(uint8_t *dst,
+             const uint8_t *src,
+             const size_t numBytes,
+             const unsigned int plane)
+{
+    const uint64_t *exp = expandTable();
+
+    for(size_t i = 0 ; i < numBytes ; i++)
+    {
+        uint64_t pixels;
+        memcpy(&pixels, dst + 8*i, sizeof(pixels));
+        pixels |= exp[src[i]] << plane;
+        memcpy(dst + 8*i, &pixels, sizeof(pixels));
+    }
+}
+
+
+void palettise(uint32_t *dst,
+               const uint8_t *src,
+               const size_t count,
+               const uint32_t *palette)
+{
+    size_t i = 0;
+
+    for( ; i+4 <= count ; i += 4)
+    {
+        dst[i]   = palette[src[i]];
+        dst[i+1] = palette[src[i+1]];
+        dst[i+2] = palette[src[i+2]];
+        dst[i+3] = palette[src[i+3]];
+    }
+
+    for( ; i < count ; i++)
+    {
+        dst[i] = palette[src[i]];
+    }
+}
+
+
+
+void widen(uint32_t *dst,
+           const uint32_t *src,
+           const size_t count,
+           const unsigned int factor)
+{
+    if(factor == 1)
+    {
+        memcpy(dst, src, count*sizeof(uint32_t));
+        return;
+    }
+
+    size_t i = 0;
+
+#if defined(PLANAR_USE_SSE2) || defined(PLANAR_USE_NEON)
+    if(factor == 2)
+    {
+        for( ; i+4 <= count ; i += 4)
+        {
+#if defined(PLANAR_USE_SSE2)
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+2*i), _mm_unpacklo_epi32(pixels, pixels));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst+2*i+4), _mm_unpackhi_epi32(pixels, pixels));
+#else
+            const uint32x4_t pixels = vld1q_u32(src+i);
+            const uint32x4x2_t pairs = vzipq_u32(pixels, pixels);
+            vst1q_u32(dst+2*i, pairs.val[0]);
+            vst1q_u32(dst+2*i+4, pairs.val[1]);
+#endif
+        }
+    }
+    else
+    {
+        // Four copies are stored at once. With factor 3 that spills into the next
+        // pixel, which is written afterwards, so the last pixel is left to the loop
+        // below. Bigger factors end with a store overlapping the one before.
+        for( ; i+1 < count ; i++)
+        {
+            uint32_t *out = dst + factor*i;
+            const size_t lastStore = (factor < 4) ? 0 : factor-4;
+#if defined(PLANAR_USE_SSE2)
+            const __m128i pixel = _mm_set1_epi32(int(src[i]));
+            for(size_t k = 0 ; k+4 <= factor ; k += 4)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out+k), pixel);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out+lastStore), pixel);
+#else
+            const uint32x4_t pixel = vdupq_n_u32(src[i]);
+            for(size_t k = 0 ; k+4 <= factor ; k += 4)
+                vst1q_u32(out+k, pixel);
+            vst1q_u32(out+lastStore, pixel);
+#endif
+        }
+    }
+#endif
+
+    for( ; i < count ; i++)
+    {
+        uint32_t *out = dst + factor*i;
+        for(unsigned int k = 0 ; k < factor ; k++)
+        {
+            out[k] = src[i];
+        }
+    }
+}
+
+
+void stretch(uint32_t *dst,
+             const uint32_t *src,
+             const uint16_t *columns,
+             const size_t count)
+{
+    size_t i = 0;
+
+    for( ; i+4 <= count ; i += 4)
+    {
+        dst[i]   = src[columns[i]];
+        dst[i+1] = src[columns[i+1]];
+        dst[i+2] = src[columns[i+2]];
+        dst[i+3] = src[columns[i+3]];
+    }
+
+    for( ; i < count ; i++)
+    {
+        dst[i] = src[columns[i]];
+    }
+}
+
+}
@@ -0,0 +1,90 @@
+/*
+ * EGAPlanar.h
+ *
+ *  Created on: 18.10.2026
+ *
+ *  Shared planar to chunky conversion for EGA graphics.
+ *  The Vorticon latches, the Galaxy EGAGRAPH data and the RefKeen
+ *  video memory all store images as four separate bitplanes
+ *  (and sometimes a fifth mask plane). These routines convert one
+ *  row of those planes at a time into 8-bit colour indices or into
+ *  palettised 32-bit pixels, and enlarge rows of those pixels.
+ */
+
+#ifndef EGAPLANAR_H_
+#define EGAPLANAR_H_
+
+#include <cstdint>
+#include <cstddef>
+
+namespace planar
+{
+
+/**
+ * \brief   Expands numBytes bytes of each of the four planes into 8*numBytes
+ *          colour indices (0-15). The most significant bit is the leftmost pixel.
+ * \param   dst       destination of 8*numBytes indices
+ * \param   planes    pointers to the bytes of plane 0 to 3 of the row
+ * \param   numBytes  number of bytes to convert of every plane
+ */
+void toChunky(uint8_t *dst,
+              const uint8_t * const planes[4],
+              const size_t numBytes);
+
+/**
+ * \brief   Same as toChunky, but every pixel whose bit is set in the mask plane
+ *          is replaced by maskIndex. This is the layout of Galaxy sprites and masked tiles.
+ */
+void toChunkyMasked(uint8_t *dst,
+                    const uint8_t * const planes[4],
+                    const uint8_t *mask,
+                    const size_t numBytes,
+                    const uint8_t maskIndex);
+
+/**
+ * \brief   Expands numBytes bytes of the four planes directly into 32-bit pixels
+ *          looking up every colour index in palette (at least 16 entries).
+ */
+void toPalettised(uint32_t *dst,
+                  const uint8_t * const planes[4],
+                  const size_t numBytes,
+                  const uint32_t *palette);
+
+/**
+ * \brief   Expands numBytes bytes of one plane and ORs the bit of every pixel
+ *          shifted by plane into dst. Used where planes are read one after another.
+ */
+void orPlane(uint8_t *dst,
+             const uint8_t *src,
+             const size_t numBytes,
+             const unsigned int plane);
+
+/**
+ * \brief   Maps count colour indices to 32-bit pixels through palette.
+ */
+void palettise(uint32_t *dst,
+               const uint8_t *src,
+               const size_t count,
+               const uint32_t *palette);
+
+/**
+ * \brief   Writes each of count pixels factor times in a row, so dst gets
+ *          factor*count pixels. Enlarges a row by whole pixels.
+ */
+void widen(uint32_t *dst,
+           const uint32_t *src,
+           const size_t count,
+           const unsigned int factor);
+
+/**
+ * \brief   Sets dst[x] to src[columns[x]] for count pixels. Enlarges a row
+ *          by any ratio, columns tells which source pixel every one shows.
+ */
+void stretch(uint32_t *dst,
+             const uint32_t *src,
+             const uint16_t *columns,
+             const size_t count);
+
+}
+
+#endif /* EGAPLANAR_H_ */
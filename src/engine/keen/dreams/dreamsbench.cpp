@@ -0,0 +1,289 @@
+#include "dreamsbench.h"
+
+#include "dreamsengine.h"
+#include "dreamsdosintro.h"
+
+#include <base/GsEvent.h>
+#include <base/GsLogging.h>
+#include <fileio/KeenFiles.h>
+#include "sdl/audio/Audio.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#define REFKEEN_VER_KDREAMS_ANYEGA_ALL
+
+extern "C"
+{
+
+#include "../../refkeen/kdreams/kd_def.h"
+
+extern int gDreamsForceClose;
+
+}
+
+void GamePlayStart();
+void GamePlayStartLevel();
+void PlayLoopInit();
+void processLevelcomplete();
+
+
+namespace dreams
+{
+
+namespace
+{
+
+const char *BenchArg = "--dreams-bench";
+
+// TimeCount runs at about 70 Hz
+const unsigned int TicsPerSecond = 70;
+
+// IN_StartDemoPlayback takes the size as a word
+const size_t MaxDemoSize = 0xFFFE;
+
+struct BenchSettings
+{
+    std::string gameDir;
+    std::string demoFile;
+    unsigned int frames = 2000;
+    unsigned int ticsPerFrame = 2; // MINTICS, so the game refreshes as often as it ever does
+    bool shiftOnDraw = false;
+};
+
+void printUsage()
+{
+    printf("Usage: CGenius %s <game dir> [options]\n\n", BenchArg);
+    printf("Options:\n");
+    printf("  --demo <file>     demo to play, pairs of (count, input) bytes the way\n");
+    printf("                    IN_StartDemoRecord stores them (default: a made up one)\n");
+    printf("  --frames <n>      stop after that many frames (default: 2000)\n");
+    printf("  --tics <n>        tics the timer moves per frame (default: 2)\n");
+    printf("  --shift-on-draw   shift the sprites while drawing them instead of\n");
+    printf("                    keeping shifted copies (default: off)\n");
+}
+
+bool parseArgs(const int argc, char *argv[], BenchSettings &settings)
+{
+    for(int i = 1 ; i < argc ; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = (i+1 < argc);
+
+        if(arg == BenchArg && hasValue)
+            settings.gameDir = argv[++i];
+        else if(arg == "--demo" && hasValue)
+            settings.demoFile = argv[++i];
+        else if(arg == "--frames" && hasValue)
+            settings.frames = unsigned(atoi(argv[++i]));
+        else if(arg == "--tics" && hasValue)
+            settings.ticsPerFrame = unsigned(atoi(argv[++i]));
+        else if(arg == "--shift-on-draw")
+            settings.shiftOnDraw = true;
+        else
+            return false;
+    }
+
+    return !settings.gameDir.empty() && settings.frames > 0 && settings.ticsPerFrame > 0;
+}
+
+// Input byte the way IN_ReadControl decodes it
+uint8_t demoInput(const int dx, const int dy, const unsigned int buttons)
+{
+    return uint8_t((dy+1) | ((dx+1) << 2) | (buttons << 4));
+}
+
+// Keen walks around, mostly to the right, and jumps or throws now and then.
+// The input comes from a small LCG, so every run plays the same.
+std::vector<uint8_t> makeSyntheticDemo(const unsigned int frames)
+{
+    std::vector<uint8_t> demo;
+    unsigned int state = 1;
+    unsigned int reads = 0;
+
+    while(reads <= frames && demo.size()+2 <= MaxDemoSize)
+    {
+        state = state*1103515245u + 12345u;
+        const unsigned int rnd = state >> 8;
+
+        const int dx = (rnd%4 == 0) ? -1 : ((rnd%4 == 1) ? 0 : 1);
+        const int dy = ((rnd>>2)%8 == 0) ? -1 : 0;
+        const unsigned int buttons = ((rnd>>5)%4 == 0) ? ((rnd>>7)%3 + 1) : 0;
+        const unsigned int count = 4 + (rnd>>9)%60;    // the input is read count+1 times
+
+        demo.push_back(uint8_t(count));
+        demo.push_back(demoInput(dx, dy, buttons));
+        reads += count+1;
+    }
+
+    return demo;
+}
+
+bool loadDemo(const std::string &filename, std::vector<uint8_t> &demo)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if(!file)
+        return false;
+
+    demo.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return demo.size() >= 2 && demo.size() <= MaxDemoSize;
+}
+
+void printModule(const char *name, const double seconds, const double totalSeconds)
+{
+    const double percent = (totalSeconds > 0.0) ? 100.0*seconds/totalSeconds : 0.0;
+    printf("%-10s %12.3f %8.1f\n", name, seconds*1000.0, percent);
+    gLogging.ftextOut("  %s: %.3f ms (%.1f %%)<br>", name, seconds*1000.0, percent);
+}
+
+}
+
+
+bool isBenchmarkRequested(const int argc, char *argv[])
+{
+    for(int i = 1 ; i < argc ; i++)
+    {
+        if(strcmp(argv[i], BenchArg) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+
+int runBenchmark(const int argc, char *argv[])
+{
+    BenchSettings settings;
+    if(!parseArgs(argc, argv, settings))
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<uint8_t> demo;
+    if(settings.demoFile.empty())
+    {
+        demo = makeSyntheticDemo(settings.frames);
+    }
+    else if(!loadDemo(settings.demoFile, demo))
+    {
+        printf("Could not read the demo \"%s\".\n", settings.demoFile.c_str());
+        return 1;
+    }
+
+    if(!gKeenFiles.exeFile.readData(7, settings.gameDir))
+    {
+        printf("No Keen Dreams found in \"%s\".\n", settings.gameDir.c_str());
+        return 1;
+    }
+    gKeenFiles.gameDir = settings.gameDir;
+
+    // Nothing may wait for the real time: The sound is mixed right here
+    // and TimeCount only moves when the frame loop says so.
+    gSound.initNullSink();
+    BE_ST_SetVirtualTimer(true);
+
+    DreamsEngine engine(false, settings.gameDir);
+    engine.setupRefKeen();
+
+    // Both ways of drawing the sprites give the same video memory, only the speed differs
+    shiftspritesondraw = settings.shiftOnDraw;
+
+    InitGame();
+    GamePlayStart();
+    GamePlayStartLevel();
+    PlayLoopInit();
+
+    // The scenes would react on these, the frame loop below does that itself
+    gEventManager.clear();
+
+    IN_StartDemoPlayback(demo.data(), id0_word_t(demo.size()));
+
+    const SDL_AudioSpec &audioSpec = gSound.getAudioSpec();
+    const Uint32 bytesPerSample = audioSpec.channels * ((audioSpec.format == AUDIO_U8) ? 1 : 2);
+    Uint64 tics = 0;
+    Uint64 samplesMixed = 0;
+    unsigned int frame = 0;
+
+    BE_ST_ProfileEnable(true);
+    const auto start = std::chrono::steady_clock::now();
+
+    for( ; frame < settings.frames ; frame++)
+    {
+        // Another read after the end of the demo would quit the game
+        if(DemoMode != demo_Playback || gDreamsForceClose || gamestate.lives < 0)
+            break;
+
+        if(playstate == resetgame || playstate == victorious)
+            break;
+
+        const exittype lastPlaystate = playstate;
+
+        BE_ST_AdvanceVirtualTimer(settings.ticsPerFrame);
+        PlayLoop();
+        PlayLoopRender();
+
+        // What DreamsGamePlay does on CompleteLevel and GoIntoPlayLoop
+        if(playstate == levelcomplete)
+        {
+            processLevelcomplete();
+            GamePlayStartLevel();
+            PlayLoopInit();
+        }
+        else if(lastPlaystate == died && playstate == notdone)
+        {
+            PlayLoopInit();
+        }
+
+        gEventManager.clear();
+
+        tics += settings.ticsPerFrame;
+        const Uint64 samplesDue = tics*audioSpec.freq/TicsPerSecond;
+
+        BE_ST_ProfileEnter(BE_ST_PROFILE_AUDIO);
+        gSound.mixNullSink(Uint32(samplesDue-samplesMixed)*bytesPerSample);
+        BE_ST_ProfileLeave();
+
+        samplesMixed = samplesDue;
+    }
+
+    const auto stop = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(stop - start).count();
+    const double fps = (seconds > 0.0) ? frame/seconds : 0.0;
+    const uint32_t checksum = BE_ST_EGAChecksumGFX();
+
+    printf("Frames: %u in %.3f ms, %.1f fps, %u tics per frame (%s)\n",
+           frame, seconds*1000.0, fps, settings.ticsPerFrame,
+           (DemoMode == demo_Playback) ? "frame limit" : "end of the demo");
+    printf("Sprites: %s\n\n", settings.shiftOnDraw ? "shifted on draw" : "shifted copies");
+    gLogging.ftextOut("Dreams benchmark: %u frames, %.1f fps<br>", frame, fps);
+
+    printf("%-10s %12s %8s\n", "module", "ms", "%");
+
+    static const char *moduleNames[BE_ST_PROFILE_LAST] = { "id_rf", "id_vw", "id_ca", "audio" };
+    double moduleSeconds = 0.0;
+    for(int module = 0 ; module < BE_ST_PROFILE_LAST ; module++)
+    {
+        const double spent = BE_ST_ProfileGetNanos(BE_ST_ProfileModule_T(module))/1e9;
+        printModule(moduleNames[module], spent, seconds);
+        moduleSeconds += spent;
+    }
+    printModule("other", seconds-moduleSeconds, seconds);
+
+    printf("\nVideo memory checksum: %08X\n", checksum);
+    gLogging.ftextOut("Dreams benchmark: video memory checksum %08X<br>", checksum);
+
+    BE_ST_ProfileEnable(false);
+    BE_ST_SetVirtualTimer(false);
+    IN_StopDemo();
+
+    return 0;
+}
+
+}
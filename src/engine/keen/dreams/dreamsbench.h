@@ -0,0 +1,37 @@
+/*
+ * dreamsbench.h
+ *
+ *  Created on: 18.10.2026
+ *
+ *  Plays Keen Dreams from demo input without window and sound device,
+ *  as fast as the RefKeen code can go.
+ */
+
+#ifndef DREAMSBENCH_H
+#define DREAMSBENCH_H
+
+namespace dreams
+{
+
+/**
+ * @brief isBenchmarkRequested  Tells whether CG was started with --dreams-bench
+ */
+bool isBenchmarkRequested(const int argc, char *argv[]);
+
+/**
+ * @brief runBenchmark  Runs the game loop of a new game from a demo. The EGA emulation only draws
+ *                      into memory, the sound is mixed into nothing after every frame and the
+ *                      emulated timer moves by a fixed number of tics per frame.
+ *                      Tells the frames per second, the time spent in id_rf, id_vw, id_ca and the
+ *                      audio emulation, and a checksum of the video memory after the last frame.
+ *
+ *                      --dreams-bench <game dir> [--demo <file>] [--frames <n>] [--tics <n>]
+ *                                     [--shift-on-draw]
+ *
+ * @return exit code for main
+ */
+int runBenchmark(const int argc, char *argv[]);
+
+}
+
+#endif // DREAMSBENCH_H
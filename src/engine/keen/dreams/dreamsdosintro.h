@@ -6,6 +6,11 @@
 namespace dreams
 {
 
+/**
+ * @brief InitGame  Starts up the id managers and caches the chunks every part of the game needs
+ */
+void InitGame();
+
 /**
  * @brief The DreamsDosIntro class  Portion of the text dialog where a lot of main game data loading is executed as well.
  *
@@ -8,6 +8,7 @@
 #include <fileio/CExeFile.h>
 #include <fileio/KeenFiles.h>
 #include <fileio/CPatcher.h>
+#include <fileio/CConfiguration.h>
 #include <base/video/CVideoDriver.h>
 #include <base/CInput.h>
 #include <SDL.h>
@@ -398,7 +399,7 @@ void DreamsEngine::applyScreenMode()
 }
 
 
-void DreamsEngine::start()
+void DreamsEngine::setupRefKeen()
 {
     CExeFile &ExeFile = gKeenFiles.exeFile;
 
@@ -422,15 +423,29 @@ void DreamsEngine::start()
 
     dreamsengine_datapath = const_cast<char*>(mDataPath.c_str());
 
-    // This function extracts the embedded files. TODO: We should integrate that to our existing system
-    // Load the Resources
-    loadResources();
-
     //RefKeen_Patch_id_ca();
     //RefKeen_Patch_id_us();
     RefKeen_Patch_id_rf();
     setupObjOffset();
 
+    // Shifting the sprites while they are drawn saves the memory of the shifted copies.
+    // It's off unless shiftspritesondraw is set in the Dreams section of the configuration.
+    CConfiguration Configuration(CONFIGFILENAME);
+    bool shiftOnDraw = false;
+    if(Configuration.Parse())
+        Configuration.ReadKeyword("Dreams", "shiftspritesondraw", &shiftOnDraw, false);
+    shiftspritesondraw = shiftOnDraw;
+}
+
+
+void DreamsEngine::start()
+{
+    setupRefKeen();
+
+    // This function extracts the embedded files. TODO: We should integrate that to our existing system
+    // Load the Resources
+    loadResources();
+
     mpScene.reset( new DreamsDosIntro );
 
     gGameStateChange = GSS_INTRO_TEXT;
@@ -523,7 +538,33 @@ void DreamsEngine::render()
     }
 
     SDL_Surface *blitSfc = gVideoDriver.getBlitSurface();
-    BEL_ST_UpdateHostDisplay(blitSfc);
+
+    // RefKeen only writes the lines which have changed, so it draws into a surface of its own.
+    // Menus and overlays drawn onto the blit surface would stay there otherwise.
+    if(!mpRefKeenSurface ||
+       mpRefKeenSurface->w != blitSfc->w ||
+       mpRefKeenSurface->h != blitSfc->h)
+    {
+        SDL_PixelFormat *format = blitSfc->format;
+
+        mpRefKeenSurface.reset( SDL_CreateRGBSurface( SDL_SWSURFACE,
+                    blitSfc->w,
+                    blitSfc->h,
+                    32,
+                    format->Rmask,
+                    format->Gmask,
+                    format->Bmask,
+                    format->Amask ), &SDL_FreeSurface );
+
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+        SDL_SetSurfaceBlendMode(mpRefKeenSurface.get(), SDL_BLENDMODE_NONE);
+#else
+        SDL_SetAlpha(mpRefKeenSurface.get(), 0, 0);
+#endif
+    }
+
+    BEL_ST_UpdateHostDisplay(mpRefKeenSurface.get());
+    BlitSurface(mpRefKeenSurface.get(), NULL, blitSfc, NULL);
 }
 
 }
@@ -75,6 +75,12 @@ public:
     void applyScreenMode();
 
 
+    /**
+     * @brief setupRefKeen  Patches and extracts the game data and points the RefKeen code to it.
+     *                      Does not load anything yet, that happens when the first scene starts.
+     */
+    void setupRefKeen();
+
     /**
      * @brief start Starts the Dreams engine which refers to accessing RefKeen code
      */
@@ -110,6 +116,11 @@ private:
      * @brief mpScene   A flexible pointer to a class instance in which different functionalities can projected
      */
     std::unique_ptr<GsEngine> mpScene;
+
+    /**
+     * @brief mpRefKeenSurface  What RefKeen has drawn. It's blit onto the blit surface every frame.
+     */
+    std::shared_ptr<SDL_Surface> mpRefKeenSurface;
 };
 
 }
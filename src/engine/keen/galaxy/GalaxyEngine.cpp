@@ -49,6 +49,12 @@ bool setupAudio()
     if(audio->loadSoundData(0))
     {
         gSound.setupSoundData(audio->sndSlotMapGalaxy[ep], audio);
+
+        // Keen's own sounds are heard in every level, so have them ready early
+        gSound.prefetchSounds( { SOUND_KEEN_WALK, SOUND_KEEN_WALK2, SOUND_KEEN_JUMP,
+                                 SOUND_KEEN_LAND, SOUND_KEEN_FIRE, SOUND_KEEN_POGO,
+                                 SOUND_KEEN_FALL, SOUND_GUN_CLICK, SOUND_SHOT_HIT,
+                                 SOUND_GET_BONUS, SOUND_GET_ITEM } );
         return true;
     }
 
@@ -206,7 +212,7 @@ bool GalaxyEngine::loadResources( const Uint8 flags )
             if( (mFlags & LOADSTR) == LOADSTR )
             {
                 // load the strings.
-                CMessages Messages(p_exedata, Episode, ExeFile.isDemo(), version);
+                CMessages Messages(ExeFile, Episode, ExeFile.isDemo(), version);
                 Messages.extractGlobalStrings();
                 mLoader.setPermilage(450);
             }
@@ -28,6 +28,8 @@
 #include "../common/ai/CSpriteItem.h"
 
 #include <fstream>
+#include <algorithm>
+#include <cstring>
 
 namespace galaxy
 {
@@ -60,77 +62,90 @@ size_t CMapLoaderGalaxy::getMapheadOffset()
 }
 
 
-size_t findInStream(std::ifstream &stream, const std::string &sig)
+// Reads little endian values out of the loaded GAMEMAPS or MAPHEAD data
+static word getWord(const byte *ptr)
 {
-  const size_t start = stream.tellg();
-    
-  while(!stream.eof())
-  {	
-	auto it = sig.begin();
-	for( size_t s=0 ; it != sig.end() ; it++, s++ )
-	{
-	  char c = stream.get();
-	  
-	  if( sig[s] != c )
-	    break;
-	}
-	
-	if( it == sig.end() )
-	  break;
-  }
-  
-  size_t pos;
-  
-  if(stream.eof())
-    pos = std::string::npos;
-  else
-    pos = stream.tellg();
-  
-  stream.seekg(start);
-  
-  return pos;
+    return word(ptr[0] | (ptr[1]<<8));
+}
+
+static longword getLongWord(const byte *ptr)
+{
+    return longword(ptr[0]) | (longword(ptr[1])<<8) |
+          (longword(ptr[2])<<16) | (longword(ptr[3])<<24);
 }
 
+/*
+ *			  Plane Offsets:  Long[3]   Offset within GAMEMAPS to the start of the plane.  The first offset is for the background plane, the
+ *                           second for the foreground plane, and the third for the info plane (see below).
+ *			  Plane Lengths:  Word[3]   Length (in bytes) of the compressed plane data.  The first length is for the background plane, the
+ *                           second for the foreground plane, and the third for the info plane (see below).
+ *			  Width:          Word      Level width (in tiles).
+ *			  Height:         Word      Level height (in tiles).  Together with Width, this can be used to calculate the uncompressed
+ *										size of plane data, by multiplying Width by Height and multiplying the result by sizeof(Word).
+ *			  Name:           Byte[16]  Null-terminated string specifying the name of the level.  This name is used only by TED5, not by Keen.
+ *			  Signature:      Byte[4]   Marks the end of the Level Header.  Always "!ID!".
+ */
+const size_t levelHeaderSigPos = 3*sizeof(longword) + 3*sizeof(word) +
+                                 2*sizeof(word) + 16*sizeof(byte);
+const size_t levelHeaderSize = levelHeaderSigPos + 4*sizeof(byte);
+
+static const char levelHeaderSig[] = "!ID!";
+
 
-bool CMapLoaderGalaxy::gotoNextSignature(std::ifstream &MapFile)
+/**
+ * @brief findLevelHeader   Returns where the header of a level starts. Normally MAPHEAD
+ *                          points right to it, which we verify by its "!ID!" signature.
+ *                          Some mods were saved with editors that don't follow that, so
+ *                          as fallback the data is searched for the next signature.
+ */
+size_t CMapLoaderGalaxy::findLevelHeader(const std::vector<byte> &mapData, const size_t levelOffset)
 {
-  // try the original "!ID!" Sig...
-	size_t pos = findInStream(MapFile, "!ID!");
-	MapFile.seekg( pos, std::ios::beg );
-	
-	if(pos != std::string::npos)
-	  return true;
+    if(levelOffset + levelHeaderSize <= mapData.size() &&
+       memcmp(&mapData[levelOffset + levelHeaderSigPos], levelHeaderSig, 4) == 0)
+    {
+        return levelOffset;
+    }
+
+    if(levelOffset < mapData.size())
+    {
+        const auto it = std::search(mapData.begin() + levelOffset, mapData.end(),
+                                    levelHeaderSig, levelHeaderSig+4);
+
+        // The header must fit in front of the signature
+        const size_t sigPos = size_t(it - mapData.begin());
+        if(it != mapData.end() && sigPos >= levelHeaderSigPos)
+        {
+            return sigPos - levelHeaderSigPos;
+        }
+    }
 
 	gLogging.textOut("Warning! Your are opening a map which is not correctly signed. Some Mods, using different Editors, have that issue!!");
     gLogging.textOut("If you are playing a mod it might okay though. If it's an original game, it is tainted and you should get a better copy. Continuing...");
-	
-	return false;	
+
+    return levelOffset;
 }
 
 // never allow more than 100 bytes of uncompressed data. Anything larger is assumed to de too large
 const size_t fileSizeLimit = 100 * 1024 * 1024;
 
-bool CMapLoaderGalaxy::unpackPlaneData( std::ifstream &mapFile,
+bool CMapLoaderGalaxy::unpackPlaneData( const std::vector<byte> &mapData,
                                         CMap &Map,
                                         const size_t planeNumber,
                                         longword offset,
                                         longword length,
                                         word magic_word)
 {
-    size_t initial_pos = mapFile.tellg();
-
     std::vector<word> plane;
 
-    mapFile.seekg(offset);
-
-	std::vector<byte> Carmack_Plane;	
-
-	for(size_t i=0 ; i<length ; i++)
+    if(length < 2 || offset > mapData.size() || length > mapData.size() - offset)
     {
-        Carmack_Plane.push_back( mapFile.get() );
+        gLogging.textOut( "\nERROR: Plane data at " + itoa(offset) + " exceeds the GAMEMAPS file.<br>");
+        return false;
     }
 
-	size_t decarmacksize = (Carmack_Plane.at(1)<<8)+Carmack_Plane.at(0);
+    const byte *Carmack_Plane = &mapData[offset];
+
+	size_t decarmacksize = (Carmack_Plane[1]<<8)+Carmack_Plane[0];
 
 	
     if(decarmacksize > fileSizeLimit)
@@ -143,8 +158,9 @@ bool CMapLoaderGalaxy::unpackPlaneData( std::ifstream &mapFile,
 	// Now use the Carmack Decompression
 	CCarmack Carmack;
     std::vector<byte> RLE_Plane;
+    RLE_Plane.reserve(decarmacksize);
 
-	Carmack.expand(RLE_Plane, Carmack_Plane);
+	Carmack.expand(RLE_Plane, Carmack_Plane, length);
 	
     if( decarmacksize > RLE_Plane.size() )
     {
@@ -152,10 +168,7 @@ bool CMapLoaderGalaxy::unpackPlaneData( std::ifstream &mapFile,
                      " bytes Expected " + itoa(decarmacksize) + " bytes. Trying to reconstruct level anyway!<br>");
 	  
         // Fill it up with zeroes...
-        while( decarmacksize > RLE_Plane.size() )
-        {
-          RLE_Plane.push_back(0);
-        }
+        RLE_Plane.resize(decarmacksize, 0);
     }
 		
 	
@@ -164,22 +177,18 @@ bool CMapLoaderGalaxy::unpackPlaneData( std::ifstream &mapFile,
     	// Now use the RLE Decompression
     	CRLE RLE;
         size_t derlesize = (RLE_Plane[0]<<8) + RLE_Plane[1];           // Bytes already swapped
+        plane.reserve(derlesize/2);
         RLE.expand(plane, RLE_Plane, magic_word);
 
-        word *ptr = Map.getData(planeNumber);
-        for(size_t y=0; y<Map.m_height ; ++y)
-    	{
-            const int stride = y*Map.m_width;
-
-            for(size_t x=0; x<Map.m_width ; ++x)
-    		{
-                const int offset = stride+x;
-                const word tile = plane.at(offset);
+        const size_t numTiles = Map.m_width*Map.m_height;
+        if( plane.size() < numTiles )
+        {
+            gLogging.textOut( "\nERROR Plane Uncompress RLE got only "+ itoa(plane.size()) +" of " + itoa(numTiles) + " tiles<br>");
+            return false;
+        }
 
-                *ptr = tile;
-    			ptr++;
-    		}
-    	}
+        word *ptr = Map.getData(planeNumber);
+        std::copy(plane.begin(), plane.begin()+numTiles, ptr);
 
         if( derlesize/2 != plane.size() )
         {
@@ -193,8 +202,6 @@ bool CMapLoaderGalaxy::unpackPlaneData( std::ifstream &mapFile,
         return false;
     }
 
-    mapFile.seekg(initial_pos);
-
     return true;
 }
 
@@ -236,56 +243,35 @@ bool CMapLoaderGalaxy::loadMap(CMap &Map, Uint8 level)
 
     // Get the magic number of the level data from MAPHEAD Located in the EXE-File.
     // This is used for the decompression.
-    magic_word = READWORD(Maphead);
+    magic_word = getWord(Maphead);
 
     // Get location of the level data from MAPHEAD Located in the EXE-File.
-    Maphead += level*sizeof(longword);
-    level_offset = READLONGWORD(Maphead);
+    level_offset = getLongWord(Maphead + sizeof(word) + level*sizeof(longword));
 
     // Open the Gamemaps file
     std::string gamemapfile = gKeenFiles.gamemapsFilename;
 
-    std::ifstream MapFile;
-    if(OpenGameFileR(MapFile, getResourceFilename(gamemapfile,path,true,false), std::ios::binary))
+    const std::vector<byte> *pMapData = gKeenFiles.gameMaps(getResourceFilename(gamemapfile,path,true,false));
+    if(pMapData)
     {
+        const std::vector<byte> &mapData = *pMapData;
+
         if(level_offset == 0 && mapHeadContainer.empty())
         {
-            MapFile.close();
             gLogging.textOut("This Level doesn't exist in GameMaps");
             return false;
         }
 
-        // Then jump to that location and read the level map data
-        MapFile.seekg (level_offset, std::ios::beg);
-
-        int headbegin;
-
         // Get the level plane header
-        if(gotoNextSignature(MapFile))
-        {
-            /*
-     *			  Plane Offsets:  Long[3]   Offset within GAMEMAPS to the start of the plane.  The first offset is for the background plane, the
-     *                           second for the foreground plane, and the third for the info plane (see below).
-     *			  Plane Lengths:  Word[3]   Length (in bytes) of the compressed plane data.  The first length is for the background plane, the
-     *                           second for the foreground plane, and the third for the info plane (see below).
-     *			  Width:          Word      Level width (in tiles).
-     *			  Height:         Word      Level height (in tiles).  Together with Width, this can be used to calculate the uncompressed
-     *										size of plane data, by multiplying Width by Height and multiplying the result by sizeof(Word).
-     *			  Name:           Byte[16]  Null-terminated string specifying the name of the level.  This name is used only by TED5, not by Keen.
-     *			  Signature:      Byte[4]   Marks the end of the Level Header.  Always "!ID!".
-     */
-            int jumpback = 3*sizeof(longword) + 3*sizeof(word) +
-                    2*sizeof(word) + 16*sizeof(byte) + 4*sizeof(byte);
-
-            headbegin = static_cast<int>(MapFile.tellg()) - jumpback;
-        }
-        else
+        const size_t headbegin = findLevelHeader(mapData, level_offset);
+
+        if(headbegin + levelHeaderSigPos > mapData.size())
         {
-            MapFile.clear();
-            headbegin =  level_offset;
+            gLogging.textOut("The level header lies beyond the end of the GameMaps file");
+            return false;
         }
 
-        MapFile.seekg( headbegin, std::ios_base::beg);
+        const byte *header = &mapData[headbegin];
 
         // Get the header of level data
         longword Plane_Offset[3];
@@ -294,17 +280,17 @@ bool CMapLoaderGalaxy::loadMap(CMap &Map, Uint8 level)
         char name[17];
 
         // Get the plane offsets
-        Plane_Offset[0] = fgetl(MapFile);
-        Plane_Offset[1] = fgetl(MapFile);
-        Plane_Offset[2] = fgetl(MapFile);
+        Plane_Offset[0] = getLongWord(header);
+        Plane_Offset[1] = getLongWord(header+4);
+        Plane_Offset[2] = getLongWord(header+8);
 
         // Get the dimensions of the level
-        Plane_Length[0] = fgetw(MapFile);
-        Plane_Length[1] = fgetw(MapFile);
-        Plane_Length[2] = fgetw(MapFile);
+        Plane_Length[0] = getWord(header+12);
+        Plane_Length[1] = getWord(header+14);
+        Plane_Length[2] = getWord(header+16);
 
-        Width = fgetw(MapFile);
-        Height = fgetw(MapFile);
+        Width = getWord(header+18);
+        Height = getWord(header+20);
 
 
         if(Width>1024 || Height>1024)
@@ -315,10 +301,7 @@ bool CMapLoaderGalaxy::loadMap(CMap &Map, Uint8 level)
         }
 
 
-        for(int c=0 ; c<16 ; c++)
-        {
-            name[c] = MapFile.get();
-        }
+        memcpy(name, header+22, 16);
         name[16] = '\0';
 
         // Get and check the signature
@@ -334,13 +317,13 @@ bool CMapLoaderGalaxy::loadMap(CMap &Map, Uint8 level)
         Map.setupEmptyDataPlanes(3, Width, Height);
 
         gLogging.textOut("Decompressing the Map... plane 0 (Background)<br>" );
-        ok &= unpackPlaneData(MapFile, Map, 0, Plane_Offset[0], Plane_Length[0], magic_word);
+        ok &= unpackPlaneData(mapData, Map, 0, Plane_Offset[0], Plane_Length[0], magic_word);
 
         gLogging.textOut("Decompressing the Map... plane 1 (Foreground)<br>" );
-        ok &= unpackPlaneData(MapFile, Map, 1, Plane_Offset[1], Plane_Length[1], magic_word);
+        ok &= unpackPlaneData(mapData, Map, 1, Plane_Offset[1], Plane_Length[1], magic_word);
 
         gLogging.textOut("Decompressing the Map... plane 2 (Infolayer)<br>" );
-        ok &= unpackPlaneData(MapFile, Map, 2, Plane_Offset[2], Plane_Length[2], magic_word);
+        ok &= unpackPlaneData(mapData, Map, 2, Plane_Offset[2], Plane_Length[2], magic_word);
 
 
         Map.collectBlockersCoordiantes();
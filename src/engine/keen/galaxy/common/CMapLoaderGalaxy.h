@@ -29,7 +29,7 @@ public:
             std::vector<CInventory> &inventoryVec);
 	
 	size_t getMapheadOffset();
-	bool gotoNextSignature(std::ifstream &MapFile);
+	size_t findLevelHeader(const std::vector<byte> &mapData, const size_t levelOffset);
 	bool loadMap(CMap &Map, Uint8 level);
 	void spawnFoes(CMap &Map);
 	
@@ -56,7 +56,7 @@ protected:
 
     /**
      * @brief unpackPlaneData       Unpackes the plane data using carmack decompression routine
-     * @param MapFile
+     * @param mapData               whole content of the GAMEMAPS file
      * @param Map
      * @param planeNumber
      * @param offset
@@ -64,7 +64,7 @@ protected:
      * @param magic_word
      * @return  true, if everything went fine, otherwise false.
      */
-    bool unpackPlaneData(std::ifstream &MapFile,
+    bool unpackPlaneData(const std::vector<byte> &mapData,
             CMap &Map, const size_t planeNumber,
             longword offset, longword length,
             word magic_word);
@@ -106,6 +106,8 @@ void CAudioSettings::release()
 	mSoundblaster = ( mpSBToggle->getSelection() == "Soundblaster" ? true : false );
 
 	gSound.unloadSoundData();
+	// The music thread must not produce anything while the format changes
+	gMusicPlayer.stopRendering();
 	gSound.destroy();
 	gSound.setSettings(mAudioSpec, mSoundblaster);
 	gSound.init();
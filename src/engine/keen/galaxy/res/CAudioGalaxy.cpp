@@ -380,21 +380,21 @@ bool CAudioGalaxy::LoadFromAudioCK(const unsigned int dictOffset)
         audiostarthedptr = reinterpret_cast<uint32_t*>(ExeFile.getHeaderData());
         audioendhedptr = audiostarthedptr + ExeFile.getExeDataSize()/sizeof(uint32_t);
 
-        uint32_t *audiohedptr = audiostarthedptr;
+        uint32_t *audiohedptr = audioendhedptr;
         uint32_t number_of_audiorecs = 0;
-        for( ; audiohedptr < audioendhedptr ; audiohedptr++ )
+
+        // The last entry of the AUDIOHED is the size of the audio file. Look it up and go back to the first entry
+        size_t audiohedEndOffset = 0;
+        if( ExeFile.getSignatureIndex().findAlignedLongWord(audiofilecompsize, audiohedEndOffset) )
         {
-            if(*audiohedptr == audiofilecompsize)
+            audiohedptr = audiostarthedptr + audiohedEndOffset/sizeof(uint32_t);
+
+            for( ; audiohedptr > audiostarthedptr ; audiohedptr-- )
             {
-                for( const uint32_t *startptr = (uint32_t*) (void*) ExeFile.getHeaderData() ;
-                     audiohedptr > startptr ; audiohedptr-- )
-                {
-                    // Get the number of Audio files we have
-                    number_of_audiorecs++;
-                    if(*audiohedptr == 0x0)
-                        break;
-                }
-                break;
+                // Get the number of Audio files we have
+                number_of_audiorecs++;
+                if(*audiohedptr == 0x0)
+                    break;
             }
         }
 
@@ -516,9 +516,8 @@ bool CAudioGalaxy::LoadFromAudioCK(const unsigned int dictOffset)
 
             if(snd>=al_snd_start)
             {
-                const bool ok = readISFintoWaveForm( m_soundslot[snd],
-                                                     imfdataPtr,
-                                                     (audioSpec.format == AUDIO_S16) ? 2 : 1 );
+                // Rendered on demand, when it is played for the first time
+                const bool ok = storeISF( snd, imfdataPtr, outsize );
                 if(!ok)
                 {
                     gLogging << "Sound " << snd << " could not be read!<br>";
@@ -538,6 +537,9 @@ bool CAudioGalaxy::LoadFromAudioCK(const unsigned int dictOffset)
         }
     }
 
+    // Reuse the effects rendered by an earlier launch if possible
+    openEffectCache(gKeenFiles.gameDir);
+
     return true;
 }
 
@@ -546,11 +548,6 @@ bool CAudioGalaxy::LoadFromAudioCK(const unsigned int dictOffset)
  */
 bool CAudioGalaxy::loadSoundData(const unsigned int dictOffset)
 {       
-    COPLEmulator &OPLEmulator = gSound.getOPLEmulatorRef();
-
-    OPLEmulator.shutdown();
-    OPLEmulator.init();
-
     const bool ok = LoadFromAudioCK(dictOffset);
 
 	if(!ok)
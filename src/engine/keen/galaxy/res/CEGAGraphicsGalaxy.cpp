@@ -26,6 +26,7 @@
 #include "fileio/CTileLoader.h"
 #include "engine/core/CSpriteObject.h"
 #include "engine/core/CPlanes.h"
+#include "engine/core/EGAPlanar.h"
 #include <fstream>
 #include <cstring>
 #include <string>
@@ -304,74 +305,23 @@ extractPicture(SDL_Surface *sfc,
 
     if(!data.empty())
     {
-        // Decode the bitmap data
-        for(size_t p = 0; p < 4; p++)
+        // Decode the bitmap data row by row. Masked pictures have the mask
+        // stored as first plane followed by the four colour planes
+        const size_t planeSize = Width * Height;
+        const Uint8 *base = &data[0];
+        const Uint8 *colorBase = masked ? base + planeSize : base;
+
+        for(size_t y = 0; y < Height; y++)
         {
-            Uint8* pixel = (Uint8*) sfc->pixels;
+            Uint8* pixel = (Uint8*) sfc->pixels + y*Width*8;
+            const Uint8 *rowPlanes[4];
+            for(size_t p = 0; p < 4; p++)
+                rowPlanes[p] = colorBase + p*planeSize + y*Width;
 
-            // get location of plane p
             if(masked)
-            {
-                Uint8* pointer = &data[0] + (p+1) * Width * Height;
-
-                // now try to extract the bits and pass it to the SDL-Surface
-                for(size_t y = 0; y < Height; y++)
-                {
-                    for(size_t x = 0; x < Width; x++)
-                    {
-                        for(Uint8 b=0 ; b<8 ; b++)
-                        {
-                            Uint8 bit = getBit(*pointer, 7-b);
-                            *pixel |= (bit<<p);
-                            pixel++;
-                        }
-                        pointer++;
-                    }
-                }
-            }
+                planar::toChunkyMasked(pixel, rowPlanes, base + y*Width, Width, 16);
             else
-            {
-                Uint8* pointer = &data[0] + p * Width * Height;
-
-                // now try to extract the bits and pass it to the SDL-Surface
-                for(size_t y = 0; y < Height; y++)
-                {
-                    for(size_t x = 0; x < Width; x++)
-                    {
-                        for(Uint8 b=0 ; b<8 ; b++)
-                        {
-                            Uint8 bit = getBit(*pointer, 7-b);
-                            *pixel |= (bit<<p);
-                            pixel++;
-                        }
-                        pointer++;
-                    }
-                }
-            }
-        }
-
-        if(masked)
-        {
-            // This stuff is for reading the mask and apply it to the pixel map
-            Uint8 *pointer = &data[0];
-            Uint8* pixel = (Uint8*) sfc->pixels;
-
-            // now try to extract the bits and pass it to the SDL-Surface
-            for(size_t y = 0; y < Height; y++)
-            {
-                for(size_t x = 0; x < Width; x++)
-                {
-                    for(Uint8 b=0 ; b<8 ; b++)
-                    {
-                        Uint8 bit = getBit(*pointer, 7-b);
-                        if(bit == 1)
-                            *pixel = 16;
-
-                        pixel++;
-                    }
-                    pointer++;
-                }
-            }
+                planar::toChunky(pixel, rowPlanes, Width);
         }
     }
 
@@ -387,30 +337,23 @@ void CEGAGraphicsGalaxy::extractTile(SDL_Surface *sfc, std::vector<unsigned char
 {
     if(!data.empty())
     {
-        // Decode the image data
-        for(size_t p = 0; p < 4; p++)
+        // Decode the lines of the bitmap data
+        const size_t rowBytes = size/8;
+        const size_t tileoff = usetileoffset ? (tile*4*columns*rowBytes*size) : 0;
+        const Uint8 *base = &(data[0]) + tileoff;
+
+        for(size_t y = 0; y < size; y++)
         {
-            // Decode the lines of the bitmap data
-            size_t tileoff = usetileoffset ? (tile*4*columns*(size/8)*size) : 0;
-            Uint8 *pointer = &(data[0]) + tileoff + p * (size/8) * size;
-            for(size_t y = 0; y < size; y++)
-            {
-                Uint8 *pixel = (Uint8*)sfc->pixels +
-                        size*(tile%columns) +
-                        size*size*columns*(tile/columns) +
-                        (size*columns*y);
-                for(size_t x = 0; x < (size/8); x++)
-                {
-                    Uint8 bit,b;
-                    for(b=0 ; b<8 ; b++)
-                    {
-                        bit = getBit(*pointer, 7-b);
-                        *pixel |= (bit<<p);
-                        pixel++;
-                    }
-                    pointer++;
-                }
-            }
+            Uint8 *pixel = (Uint8*)sfc->pixels +
+                    size*(tile%columns) +
+                    size*size*columns*(tile/columns) +
+                    (size*columns*y);
+
+            const Uint8 *rowPlanes[4];
+            for(size_t p = 0; p < 4; p++)
+                rowPlanes[p] = base + p*rowBytes*size + y*rowBytes;
+
+            planar::toChunky(pixel, rowPlanes, rowBytes);
         }
     }
 }
@@ -424,52 +367,23 @@ void CEGAGraphicsGalaxy::extractMaskedTile(SDL_Surface *sfc, std::vector<unsigne
 {
     if(!data.empty())
     {
-        // Decode the image data
-        size_t tileoff = usetileoffset ? (tile*5*columns*(size/8)*size) : 0;
-        for(size_t p = 0; p < 4; p++)
-        {
-            // Decode the lines of the bitmap data
-            Uint8 *pointer = &(data[0]) + tileoff + (p+1) * (size/8) * size;
-            for(size_t y = 0; y < size; y++)
-            {
-                Uint8 *pixel = (Uint8*)sfc->pixels +
-                        size*(tile%columns) +
-                        size*size*columns*(tile/columns) +
-                        (size*columns*y);
-                for(size_t x = 0; x < (size/8); x++)
-                {
-                    Uint8 bit,b;
-                    for(b=0 ; b<8 ; b++)
-                    {
-                        bit = getBit(*pointer, 7-b);
-                        *pixel |= (bit<<p);
-                        pixel++;
-                    }
-                    pointer++;
-                }
-            }
-        }
+        // Decode the image data, the mask comes first followed by the four planes
+        const size_t rowBytes = size/8;
+        const size_t tileoff = usetileoffset ? (tile*5*columns*rowBytes*size) : 0;
+        const Uint8 *base = &(data[0]) + tileoff;
 
-        // now apply the mask!
-        Uint8 *pointer = &(data[0]) + tileoff;
         for(size_t y = 0; y < size; y++)
         {
             Uint8 *pixel = (Uint8*)sfc->pixels +
                     size*(tile%columns) +
                     size*size*columns*(tile/columns) +
                     (size*columns*y);
-            for(size_t x = 0; x < (size/8); x++)
-            {
-                Uint8 bit,b;
-                for(b=0 ; b<8 ; b++)
-                {
-                    bit = getBit(*pointer, 7-b);
-                    if(bit == 1)
-                        *pixel = 16;
-                    pixel++;
-                }
-                pointer++;
-            }
+
+            const Uint8 *rowPlanes[4];
+            for(size_t p = 0; p < 4; p++)
+                rowPlanes[p] = base + (p+1)*rowBytes*size + y*rowBytes;
+
+            planar::toChunkyMasked(pixel, rowPlanes, base + y*rowBytes, rowBytes, 16);
         }
     }
 }
@@ -1338,47 +1252,22 @@ bool CEGAGraphicsGalaxy::readSprites( const size_t numSprites,
 
         if(!data.empty())
         {
-            // Decode the image data
-            for(size_t p = 0; p < 4; p++)
-            {
-                // Decode the lines of the bitmap data
-                Uint8 *pointer = &(data[0]) + (p+1) * curSprHead.Width * curSprHead.Height;
-                for(size_t y = 0; y < curSprHead.Height; y++)
-                {
-                    Uint8 *pixel = (Uint8*)sfc->pixels +
-                            (curSprHead.Width * 8 *y);
-                    for(size_t x = 0; x < curSprHead.Width; x++)
-                    {
-                        Uint8 bit,b;
-                        for(b=0 ; b<8 ; b++)
-                        {
-                            bit = getBit(*pointer, 7-b);
-                            *pixel |= (bit<<p);
-                            pixel++;
-                        }
-                        pointer++;
-                    }
-                }
-            }
+            // Decode the image data. The mask is the first plane, the colours follow
+            const size_t planeSize = curSprHead.Width * curSprHead.Height;
+            const Uint8 *base = &(data[0]);
 
-            // now apply the mask!
-            Uint8 *pointer = &(data[0]);
             for(size_t y = 0; y < curSprHead.Height; y++)
             {
                 Uint8 *pixel = (Uint8*)sfc->pixels +
-                        (curSprHead.Width * 8*y);
-                for(size_t x = 0; x < curSprHead.Width; x++)
-                {
-                    Uint8 bit,b;
-                    for(b=0 ; b<8 ; b++)
-                    {
-                        bit = getBit(*pointer, 7-b);
-                        if(bit == 1)
-                            *pixel = 16;
-                        pixel++;
-                    }
-                    pointer++;
-                }
+                        (curSprHead.Width * 8 *y);
+
+                const Uint8 *rowPlanes[4];
+                for(size_t p = 0; p < 4; p++)
+                    rowPlanes[p] = base + (p+1)*planeSize + y*curSprHead.Width;
+
+                planar::toChunkyMasked(pixel, rowPlanes,
+                                       base + y*curSprHead.Width,
+                                       curSprHead.Width, 16);
             }
         }
         SDL_UnlockSurface(sfc);
@@ -8,6 +8,7 @@
 #include "CEGALatch.h"
 #include "fileio/ResourceMgmt.h"
 #include "fileio/lz.h"
+#include "fileio.h"
 #include "graphics/GsGraphics.h"
 #include <base/video/CVideoDriver.h>
 #include <base/TypeDefinitions.h>
@@ -19,6 +20,7 @@
 #include <SDL.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 
 CEGALatch::CEGALatch( int planesize,
 					 long bitmaptablelocation,
@@ -100,7 +102,7 @@ bool CEGALatch::loadHead( char *data, short m_episode )
 
 
 
-void CEGALatch::loadTilemap(GsTilemap &Tilemap, CPlanes &Planes, const int episode, const std::string &path)
+void CEGALatch::loadTilemap(GsTilemap &Tilemap, const std::vector<Uint8> &tilePixels, const int episode, const std::string &path)
 {
 	Tilemap.CreateSurface( gGraphics.Palette.m_Palette, SDL_SWSURFACE, m_num16tiles, 4, 13 );
 	SDL_Surface *sfc = Tilemap.getSDLSurface();
@@ -109,8 +111,11 @@ void CEGALatch::loadTilemap(GsTilemap &Tilemap, CPlanes &Planes, const int episo
 	if(SDL_MUSTLOCK(sfc))	SDL_LockSurface(sfc);
 	Uint8 *u_pixel = (Uint8*) sfc->pixels;
 
-	for(int p=0;p<4;p++)
-		Planes.readPlaneofTiles(p, u_pixel, 13, 16, m_num16tiles);
+	// The tiles have already been decoded, only copy them row by row
+	const size_t rowBytes = 13*16;
+	const size_t numRows = std::min(tilePixels.size()/rowBytes, size_t(sfc->h));
+	for(size_t y=0 ; y<numRows ; y++)
+		memcpy(u_pixel + y*sfc->pitch, tilePixels.data() + y*rowBytes, rowBytes);
 
 	if(SDL_MUSTLOCK(sfc))	SDL_UnlockSurface(sfc);
 
@@ -133,7 +138,6 @@ bool CEGALatch::loadData( const std::string &path,
                           const bool compresseddata )
 {
 	std::string filename;
-	byte *RawData;
     Uint16 width, height;
     SDL_Surface *sfc;
 
@@ -145,22 +149,34 @@ bool CEGALatch::loadData( const std::string &path,
 	if(!latchfile)
 		return false;
 
-	RawData = new byte[m_latchplanesize * 4];
+    // Read the whole file at once, all four planes go into one buffer
+    std::vector<byte> fileData;
+    const bool fileRead = freadAll(latchfile, fileData);
+    fclose(latchfile);
+
+    if(!fileRead)
+        return false;
+
+    std::vector<byte> latchData;
+
     // get the data out of the file into the memory, decompressing it if necessary.
     if (compresseddata)
     {
-		if (lz_decompress(latchfile, (unsigned char*) RawData))
+        latchData.resize(m_latchplanesize * 4, 0);
+		if (lz_decompress(fileData.data(), fileData.size(),
+                          latchData.data(), latchData.size()))
 		{
-			return 1;
+			return false;
 		}
     }
     else
     {
-    	for(int i=0 ; i<(m_latchplanesize*4) ; i++)
-    		RawData[i] = fgetc(latchfile);
+        // Files shorter than expected leave the rest empty
+        latchData.swap(fileData);
+        latchData.resize(m_latchplanesize * 4, 0);
     }
 
-    fclose(latchfile);
+    byte *RawData = latchData.data();
 
 	// these are the offsets of the different video planes as
 	// relative to each other--that is if a pixel in plane1
@@ -202,8 +218,7 @@ bool CEGALatch::loadData( const std::string &path,
 	Uint8 *pixel = (Uint8*) sfc->pixels;
 	SDL_FillRect(sfc, NULL, 0);
 
-	for(int p=0;p<4;p++)
-		Planes.readPlaneofTiles(p, pixel, 16, 8, m_fonttiles);
+	Planes.readPlanesofTiles(pixel, 16, 8, m_fonttiles);
 
 	if(SDL_MUSTLOCK(sfc)) SDL_UnlockSurface(sfc);
 
@@ -214,19 +229,16 @@ bool CEGALatch::loadData( const std::string &path,
 					 plane4 + m_tiles16location,
 					 0);
 
+	// Both tilemaps show the same tiles, so they are decoded only once
+	const size_t tileRows = (m_num16tiles+12)/13;
+	std::vector<Uint8> tilePixels(tileRows*16 * 13*16, 0);
+	Planes.readPlanesofTiles(tilePixels.data(), 13, 16, m_num16tiles);
+
 	gGraphics.freeTilemap();
 	gGraphics.createEmptyTilemaps(2);
 	
-	loadTilemap(gGraphics.getTileMap(0), Planes, episode, path);
-	
-	// prepare to ** read the 16x16 tiles **, this is for the second plane.
-	Planes.setOffsets(plane1 + m_tiles16location,
-					 plane2 + m_tiles16location,
-					 plane3 + m_tiles16location,
-					 plane4 + m_tiles16location,
-					 0);	
-	
-	loadTilemap(gGraphics.getTileMap(1), Planes, episode, path);
+	loadTilemap(gGraphics.getTileMap(0), tilePixels, episode, path);
+	loadTilemap(gGraphics.getTileMap(1), tilePixels, episode, path);
 
     gGraphics.getTileMap(0).optimizeSurface();
     gGraphics.getTileMap(1).optimizeSurface();
@@ -248,26 +260,24 @@ bool CEGALatch::loadData( const std::string &path,
 	// loaded into one continuous stream of image data, with the bitmaps[]
 	// array giving pointers to where each bitmap starts within the stream.
 
-	for(int p=0 ; p<4 ; p++)
+	// The bitmaps follow each other in every plane, so all four planes
+	// of one bitmap can be read at once
+	for(int b=0 ; b<m_bitmaps ; b++)
 	{
-		for(int b=0 ; b<m_bitmaps ; b++)
-		{
-            GsBitmap &bitmap = gGraphics.getBitmapFromId(b);
-			// this points to the location that we're currently
-			// decoding bitmap data to
+        GsBitmap &bitmap = gGraphics.getBitmapFromId(b);
+		// this points to the location that we're currently
+		// decoding bitmap data to
 
-			sfc= bitmap.getSDLSurface();
-			if(SDL_MUSTLOCK(sfc)) SDL_LockSurface(sfc);
-			Uint8* pixel = (Uint8*) sfc->pixels;
-			if(p==0)
-				SDL_FillRect(sfc, NULL, 0);
-			width = bitmap.width(); height = bitmap.height();
-			// Now read the raw data
+		sfc= bitmap.getSDLSurface();
+		if(SDL_MUSTLOCK(sfc)) SDL_LockSurface(sfc);
+		Uint8* pixel = (Uint8*) sfc->pixels;
+		SDL_FillRect(sfc, NULL, 0);
+		width = bitmap.width(); height = bitmap.height();
+		// Now read the raw data
 
-			Planes.readPlane(p, pixel, width, height);
+		Planes.readPlanes(pixel, width, height);
 
-			if(SDL_MUSTLOCK(sfc)) SDL_UnlockSurface(sfc);
-		}
+		if(SDL_MUSTLOCK(sfc)) SDL_UnlockSurface(sfc);
 	}
 
 	std::set<std::string> filelist;
@@ -287,8 +297,6 @@ bool CEGALatch::loadData( const std::string &path,
 		bitmap.loadHQBitmap(filename);
 	}
 
-	if(RawData){ delete[] RawData; RawData = NULL;}
-
     // Create an intro in case it does not exist yet
     std::string fullpath = getResourceFilename("preview.bmp", path, false);
     if( fullpath == "" )
@@ -44,7 +44,7 @@ public:
 
 private:
   
-	void loadTilemap(GsTilemap &Tilemap, CPlanes &Planes, const int episode, const std::string &path);
+	void loadTilemap(GsTilemap &Tilemap, const std::vector<Uint8> &tilePixels, const int episode, const std::string &path);
   
 	int m_num_Latches;
 	int m_latchplanesize;
@@ -15,6 +15,7 @@
 #include <base/video/CVideoDriver.h>
 #include "engine/core/spritedefines.h"
 #include "fileio/lz.h"
+#include "fileio.h"
 #include "fileio/KeenFiles.h"
 #include <fileio/ResourceMgmt.h>
 #include "engine/core/CBehaviorEngine.h"
@@ -86,7 +87,6 @@ bool CEGASprit::loadHead(char *data)
 
 bool CEGASprit::loadData(const std::string& filename, bool compresseddata)
 {
-	byte *RawData;
     SDL_Surface *sfc;
     Uint8* pixel;
     Uint32 percent = 0;
@@ -98,20 +98,32 @@ bool CEGASprit::loadData(const std::string& filename, bool compresseddata)
 	
 	gResourceLoader.setPermilage(10);
 
-	RawData = new byte[m_planesize * 5];
+    // Read the whole file at once, all five planes go into one buffer
+    std::vector<byte> fileData;
+    const bool fileRead = freadAll(latchfile, fileData);
+    fclose(latchfile);
+
+    if(!fileRead)
+        return false;
+
+    std::vector<byte> spriteData;
+
     // get the data out of the file into the memory, decompressing it if necessary.
     if (compresseddata)
     {
-		if (lz_decompress(latchfile, RawData))
-			return 1;
+        spriteData.resize(m_planesize * 5, 0);
+		if (lz_decompress(fileData.data(), fileData.size(),
+                          spriteData.data(), spriteData.size()))
+			return false;
     }
     else
     {
-    	for(int i=0 ; i<(m_planesize*5) ; i++)
-    		RawData[i] = fgetc(latchfile);
+        // Files shorter than expected leave the rest empty
+        spriteData.swap(fileData);
+        spriteData.resize(m_planesize * 5, 0);
     }
-	
-    fclose(latchfile);
+
+    byte *RawData = spriteData.data();
 
 	gResourceLoader.setPermilage(50);
 	
@@ -150,21 +162,21 @@ bool CEGASprit::loadData(const std::string& filename, bool compresseddata)
 
 	gResourceLoader.setPermilage(100);
 
-	for(int p=0 ; p<4 ; p++)
+	// The sprites follow each other in every plane, so all four colour planes
+	// of one sprite can be read at once
+	for(int s=0 ; s<m_numsprites ; s++)
 	{
-		for(int s=0 ; s<m_numsprites ; s++)
-		{
-            sfc = gGraphics.getSprite(0,s).getSDLSurface();
-			if(SDL_MUSTLOCK(sfc)) SDL_LockSurface(sfc);
-			pixel = (Uint8*) sfc->pixels;
+        sfc = gGraphics.getSprite(0,s).getSDLSurface();
+		if(SDL_MUSTLOCK(sfc)) SDL_LockSurface(sfc);
+		pixel = (Uint8*) sfc->pixels;
 
-			Planes.readPlane(p, pixel, sfc->w, sfc->h);
+		memset(pixel, 0, sfc->w*sfc->h);
+		Planes.readPlanes(pixel, sfc->w, sfc->h);
 
-			if(SDL_MUSTLOCK(sfc)) SDL_UnlockSurface(sfc);
+		if(SDL_MUSTLOCK(sfc)) SDL_UnlockSurface(sfc);
 
-			percent = (s*100)/m_numsprites;
-			gResourceLoader.setPermilage(100+percent);
-		}
+		percent = (s*100)/m_numsprites;
+		gResourceLoader.setPermilage(100+percent);
 	}
 
 	gResourceLoader.setPermilage(200);
@@ -202,8 +214,6 @@ bool CEGASprit::loadData(const std::string& filename, bool compresseddata)
 
 	gResourceLoader.setPermilage(300);
 	
-	if(RawData){ delete[] RawData; RawData = NULL;}
-	
     LoadSpecialSprites( gGraphics.getSpriteVec(0) );
 
 
@@ -68,35 +68,22 @@ mPlayerContainer(playerContainer)
 
 void CVorticonMapLoaderBase::blitPlaneToMap(std::vector<Uint16> &planeitems, const Uint16 planesize, const Uint16 planeID, const Uint16 tilemapID)
 {
-    unsigned int curmapx = 0, curmapy = 0;
-
     const unsigned int startOffest = planesize*planeID+17;
 
     // Some mods seem to incorrectly read the planes, so if there is no data left, just break wiht
     // this trick.
-    const unsigned int realSize = planeitems.size()-startOffest;
-    const unsigned int desiredSize = planesize;
-    const unsigned int obtainedSize = std::min(realSize, desiredSize);
-
-    for( size_t c=0 ; c<obtainedSize ; c++ ) // Check against Tilesize
-    {
-        int t = planeitems.at(startOffest+c);
-
-        mpMap->setTile(curmapx, curmapy, t, false, tilemapID);
-
-        curmapx++;
-        if (curmapx >= mpMap->m_width)
-        {
-            curmapx = 0;
-            curmapy++;
-            if (curmapy >= mpMap->m_height) break;
-        }
-
-        /*if(t > 255)
-        {
-            t=0; // If there are some invalid values in the file, set them to zero.
-        }*/
-    }
+    if(planeitems.size() <= startOffest)
+        return;
+
+    const size_t realSize = planeitems.size()-startOffest;
+    const size_t mapSize = size_t(mpMap->m_width)*mpMap->m_height;
+    const size_t obtainedSize = std::min(std::min(realSize, size_t(planesize)), mapSize);
+
+    // The plane is stored row by row just like the map, so it can be copied at once
+    word *mapData = mpMap->getData(tilemapID);
+    std::copy(planeitems.begin()+startOffest,
+              planeitems.begin()+startOffest+obtainedSize,
+              mapData);
 }
 
 
@@ -145,13 +132,14 @@ bool CVorticonMapLoaderBase::loadBase(  Uint8 episode,
 
 	// load the compressed data into the memory
 	std::vector<Uint8>	compdata;
-	while( !MapFile.eof() )
-	{
-		compdata.push_back(static_cast<Uint8>(MapFile.get()));
-	}
+	freadAll(MapFile, compdata);
 
 	MapFile.close();
 
+	// The former byte-wise reader also stored the EOF marker,
+	// keep that padding byte for levels which end in a partial word
+	compdata.push_back(0xFF);
+
 	CRLE RLE;
     RLE.expandSwapped(planeitems, compdata, 0xFEFE);
 
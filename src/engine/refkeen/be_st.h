@@ -78,6 +78,24 @@ void BE_ST_TimeCountWaitFromSrc(uint32_t srctimecount, int16_t timetowait);
 // Same as above, but instead waits to reach dsttimecount
 // e.g., a replacement for "while (TimeCount<dsttimecount)"
 void BE_ST_TimeCountWaitForDest(uint32_t dsttimecount);
+// (REFKEEN) With the virtual timer TimeCount only moves when it is advanced,
+// and the waits above advance it instead of sleeping (headless benchmark)
+void BE_ST_SetVirtualTimer(bool enable);
+void BE_ST_AdvanceVirtualTimer(uint32_t ticks);
+
+/*** Profiling (REFKEEN) ***/
+// Time spent in some of the id modules. While a module is entered from
+// another one, only the inner one is counted
+typedef enum {
+	BE_ST_PROFILE_RF, BE_ST_PROFILE_VW, BE_ST_PROFILE_CA, BE_ST_PROFILE_AUDIO,
+	BE_ST_PROFILE_LAST
+} BE_ST_ProfileModule_T;
+
+// Enabling (or disabling) also resets the times
+void BE_ST_ProfileEnable(bool enable);
+void BE_ST_ProfileEnter(BE_ST_ProfileModule_T module);
+void BE_ST_ProfileLeave(void);
+uint64_t BE_ST_ProfileGetNanos(BE_ST_ProfileModule_T module);
 
 /*** Graphics ***/
 //void BE_ST_InitGfx(void);
@@ -118,6 +136,8 @@ void BE_ST_EGAXorGFXByte(uint16_t destOff, uint8_t srcVal, uint16_t planeMask);
 // - All planes are updated.
 // - Only specific bits are updated in each plane's byte.
 void BE_ST_EGAOrGFXBits(uint16_t destOff, uint8_t srcVal, uint8_t bitsMask);
+// (REFKEEN) Checksum of all four planes, tells whether two runs drew the same
+uint32_t BE_ST_EGAChecksumGFX(void);
 // CGA graphics manipulations
 void BE_ST_CGAFullUpdateFromWrappedMem(const uint8_t *segPtr, const uint8_t *offInSegPtr, uint16_t byteLineWidth);
 
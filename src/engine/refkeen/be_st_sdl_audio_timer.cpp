@@ -1,25 +1,49 @@
 // TODO: Big TODO: Rework this routine so it better fits to CG.
 // A lot of stuff, especially audio is already defined at other parts
 
+#include <chrono>
+#include <thread>
+
 extern "C"
 {
 
 
+#include <string.h>
 #include "SDL.h"
 
-static uint32_t g_sdlTicksOffset = 0;
+#include "be_cross.h"
+#include "be_st.h"
+
+// All the timing is done in microseconds of a monotonic clock, so the emulated
+// PIT and retrace are not bound to the millisecond ticks of SDL_GetTicks()
+static uint64_t g_sdlMicrosOffset = 0;
 
 #define PC_PIT_RATE 1193182
+#define MICROS_PER_SEC 1000000
+
+// The OS may wake us up late, so the last part of a wait is spun instead of slept.
+// Most schedulers are that late by well under a millisecond, so a short window
+// keeps the CPU mostly idle. Define it at build time for a coarser scheduler.
+#ifndef BE_ST_SPIN_MICROS
+#define BE_ST_SPIN_MICROS 150
+#endif
 
 static uint32_t g_sdlTimeCount = 0;
 
 // A variable used for timing measurements
-static uint32_t g_sdlLastTicks;
+static uint64_t g_sdlLastMicros;
 
 
 // PIT timer divisor
 static uint32_t g_sdlScaledTimerDivisor;
 
+// (REFKEEN) With the virtual timer, TimeCount only moves when advanced. A busy
+// loop waiting for it to change gets a tick after this many reads, so it ends
+#define BE_ST_VIRTUAL_TIMER_SPIN_READS 1000
+
+static bool g_sdlVirtualTimer = false;
+static uint32_t g_sdlVirtualTimerReads;
+
 
 #if 0
 #include "be_cross.h"
@@ -627,7 +651,13 @@ void BE_ST_SetTimer(uint16_t speed, bool isALMusicOn)
 
 #endif
 
-void BEL_ST_TicksDelayWithOffset(int sdltickstowait);
+static uint64_t BEL_ST_GetMicros(void)
+{
+	static const std::chrono::steady_clock::time_point s_start = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s_start).count();
+}
+
+void BEL_ST_MicrosDelayWithOffset(int64_t microstowait);
 void BEL_ST_TimeCountWaitByPeriod(int16_t timetowait);
 
 
@@ -637,6 +667,21 @@ void BE_ST_SetTimeCount(uint32_t newcount)
 	g_sdlTimeCount = newcount;
 }
 
+void BE_ST_SetVirtualTimer(bool enable)
+{
+	g_sdlVirtualTimer = enable;
+	g_sdlVirtualTimerReads = 0;
+	// Going back to real time goes on from the current TimeCount
+	g_sdlMicrosOffset = 0;
+	g_sdlLastMicros = BEL_ST_GetMicros();
+}
+
+void BE_ST_AdvanceVirtualTimer(uint32_t ticks)
+{
+	g_sdlTimeCount += ticks;
+	g_sdlVirtualTimerReads = 0;
+}
+
 /*void BE_ST_TimeCountWaitForDest(uint32_t dsttimecount)
 {
 	BEL_ST_TimeCountWaitByPeriod((int32_t)dsttimecount-(int32_t)g_sdlTimeCount);
@@ -653,28 +698,28 @@ void BEL_ST_TimeCountWaitByPeriod(int16_t timetowait)
 	{
 		return;
 	}
-	// COMMENTED OUT - Do NOT refresh TimeCount and g_sdlLastTicks
+	if (g_sdlVirtualTimer)
+	{
+		BE_ST_AdvanceVirtualTimer(timetowait);
+		return;
+	}
+	// COMMENTED OUT - Do NOT refresh TimeCount and g_sdlLastMicros
 	//BE_ST_GetTimeCount();
 
-	// We want to find the minimal currSdlTicks value (mod 2^32) such that...
-	// ticksToWait <= (uint64_t)currSdlTicks * (uint64_t)PC_PIT_RATE / (1000*g_sdlScaledTimerDivisor) - (uint64_t)g_sdlLastTicks * (uint64_t)PC_PIT_RATE / (1000*g_sdlScaledTimerDivisor)
+	// We want to find the minimal currMicros value such that...
+	// ticksToWait <= currMicros * PC_PIT_RATE / (MICROS_PER_SEC*g_sdlScaledTimerDivisor) - g_sdlLastMicros * PC_PIT_RATE / (MICROS_PER_SEC*g_sdlScaledTimerDivisor)
 	// (WARNING: The divisions here are INTEGER divisions!)
 	// i.e.,
-	// ticksToWait + (uint64_t)g_sdlLastTicks * (uint64_t)PC_PIT_RATE / (1000*g_sdlScaledTimerDivisor) <= (uint64_t)currSdlTicks * (uint64_t)PC_PIT_RATE / (1000*g_sdlScaledTimerDivisor)
-	// That is, ignoring the types and up to the division by PC_PIT_RATE being an integer:
-	// currSdlTicks >= [ticksToWait + (uint64_t)g_sdlLastTicks * (uint64_t)PC_PIT_RATE / (1000*g_sdlScaledTimerDivisor)]*1000*g_sdlScaledTimerDivisor / PC_PIT_RATE
-	// So it may seem like we can replace ">=" with "=" and give it a go.
-	//
-	// PROBLEM: The last division IS (or at leat should be) integer. Suppose e.g., the condition is
-	// currSdlTicks >= (PC_PIT_RATE-100) / PC_PIT_RATE
-	// Then we get currSdlTicks = 0, which is not what we want (the minimal integer which is at at least this ratio as a noninteger is 1.)
+	// currMicros >= [ticksToWait + g_sdlLastMicros * PC_PIT_RATE / (MICROS_PER_SEC*g_sdlScaledTimerDivisor)]*MICROS_PER_SEC*g_sdlScaledTimerDivisor / PC_PIT_RATE
 	//
-	// SOLUTION: Add PC_PIC_RATE-1 to the numerator.
-
-	uint32_t nextSdlTicks = ((timetowait + (uint64_t)g_sdlLastTicks * (uint64_t)PC_PIT_RATE / (1000*g_sdlScaledTimerDivisor))*1000*g_sdlScaledTimerDivisor + (PC_PIT_RATE-1)) / PC_PIT_RATE;
-	// NOTE: nextSdlTicks is already adjusted in terms of offset, so we can simply reset it here
-	g_sdlTicksOffset = 0;
-	BEL_ST_TicksDelayWithOffset(nextSdlTicks-SDL_GetTicks());
+	// The last division should be rounded up, so PC_PIT_RATE-1 is added to the numerator.
+	// That's the exact moment the emulated PIT reaches the tick, so we sleep until then.
+
+	const uint64_t divisor = (uint64_t)MICROS_PER_SEC*g_sdlScaledTimerDivisor;
+	uint64_t nextMicros = ((timetowait + g_sdlLastMicros * PC_PIT_RATE / divisor)*divisor + (PC_PIT_RATE-1)) / PC_PIT_RATE;
+	// NOTE: nextMicros is already adjusted in terms of offset, so we can simply reset it here
+	g_sdlMicrosOffset = 0;
+	BEL_ST_MicrosDelayWithOffset((int64_t)(nextMicros-BEL_ST_GetMicros()));
 }
 
 
@@ -686,6 +731,13 @@ void BE_ST_WaitVBL(int16_t number)
 	// (ok, more than 7 minutes). It basically feels like a true hang,
 	// which isn't desired anyway. So we assume that number > 0.
 
+	// A refresh cycle takes about as long as a TimeCount tick
+	if (g_sdlVirtualTimer)
+	{
+		BE_ST_AdvanceVirtualTimer(number);
+		return;
+	}
+
 	// TODO (REFKEEN) Make a difference based on HW?
 
 	// Simulate waiting while in vertical retrace first, and then
@@ -693,14 +745,17 @@ void BE_ST_WaitVBL(int16_t number)
 	// to the very beginning of the next "refresh cycle".
 	// This is repeated for a total of 'length' times.
 
-	uint32_t currSdlTicks = SDL_GetTicks();
-	uint32_t nextSdlTicks = (int)number*1000000/70086 + currSdlTicks - g_sdlTicksOffset;
-	// First iteration takes a bit less time again, so we want
-	// the value "mod" about 1000/70.086 (VGA adapter);
-	// For the sake of a bit better precision we further multiply by 1000
-	nextSdlTicks -= (((uint64_t)1000*(uint64_t)nextSdlTicks) % ((uint64_t)1000000000/70086))/1000;
-	g_sdlTicksOffset = 0; // Can reset this, taking g_sdlTicksOffset into account above
-	BEL_ST_TicksDelayWithOffset(nextSdlTicks-currSdlTicks);
+	// First iteration takes a bit less time again, so we wait for the
+	// beginning of a refresh cycle of about 1000000/70.086 microseconds (VGA adapter).
+	// That is counted in nanoseconds, so the cycles don't drift apart from the
+	// microseconds we wake up at.
+	const uint64_t vblPeriodNanos = (uint64_t)1000000000000/70086;
+	uint64_t currMicros = BEL_ST_GetMicros();
+	uint64_t currNanos = (uint64_t)1000*(currMicros - g_sdlMicrosOffset);
+	uint64_t nextNanos = (currNanos/vblPeriodNanos + number)*vblPeriodNanos;
+	uint64_t nextMicros = (nextNanos + 999)/1000;
+	g_sdlMicrosOffset = 0; // Can reset this, taking g_sdlMicrosOffset into account above
+	BEL_ST_MicrosDelayWithOffset((int64_t)(nextMicros-currMicros));
 }
 
 
@@ -710,6 +765,10 @@ void BE_ST_WaitVBL(int16_t number)
 // Call during a busy loop of some unknown duration (e.g., waiting for key press/release)
 void BE_ST_ShortSleep(void)
 {
+	if (g_sdlVirtualTimer)
+	{
+		return;
+	}
 	SDL_Delay(1);
 	// TODO: Make this more efficient
     //BE_ST_PollEvents();
@@ -719,40 +778,54 @@ void BE_ST_ShortSleep(void)
 /*
 void BE_ST_Delay(uint16_t msec) // Replacement for delay from dos.h
 {
-    //BEL_ST_TicksDelayWithOffset(msec);
+    //BEL_ST_MicrosDelayWithOffset((int64_t)msec*1000);
 }
 */
 
 
-void BEL_ST_TicksDelayWithOffset(int sdltickstowait)
+// Returns when the deadline has passed, which is usually some microseconds later
+static uint64_t BEL_ST_SleepUntil(uint64_t deadline)
+{
+	uint64_t currMicros = BEL_ST_GetMicros();
+	while (currMicros < deadline)
+	{
+		const uint64_t microsLeft = deadline - currMicros;
+		if (microsLeft > BE_ST_SPIN_MICROS)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(microsLeft - BE_ST_SPIN_MICROS));
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+		currMicros = BEL_ST_GetMicros();
+	}
+	return currMicros;
+}
+
+void BEL_ST_MicrosDelayWithOffset(int64_t microstowait)
 {
-	if (sdltickstowait <= (int32_t)g_sdlTicksOffset)
+	if (microstowait <= (int64_t)g_sdlMicrosOffset)
 	{
 		// Already waited for this time earlier, no need to do so now
-		if (sdltickstowait > 0)
+		if (microstowait > 0)
 		{
-			g_sdlTicksOffset -= sdltickstowait;
+			g_sdlMicrosOffset -= microstowait;
 		}
         //BE_ST_PollEvents(); // Still safer to do this
 		return;
 	}
-	uint32_t nextSdlTicks = SDL_GetTicks() + sdltickstowait - g_sdlTicksOffset;
+	const uint64_t nextMicros = BEL_ST_GetMicros() + microstowait - g_sdlMicrosOffset;
 
     //BE_ST_PollEvents();
-	uint32_t currSdlTicks = SDL_GetTicks();
-	while ((int32_t)(currSdlTicks - nextSdlTicks) < 0)
-	{
-		SDL_Delay(1);
-        //BE_ST_PollEvents();
-		currSdlTicks = SDL_GetTicks();
-	} 
-	g_sdlTicksOffset = (currSdlTicks - nextSdlTicks);
+	// Whatever we overslept is taken from the next wait
+	g_sdlMicrosOffset = BEL_ST_SleepUntil(nextMicros) - nextMicros;
 }
 
 
 // Here, the actual rate is about 1193182Hz/speed
 // NOTE: isALMusicOn is irrelevant for Keen Dreams (even with its music code)
-void BE_ST_SetTimer(uint16_t speed, int isALMusicOn)
+void BE_ST_SetTimer(uint16_t speed, bool isALMusicOn)
 {
     //g_sdlSamplePerPart = (int32_t)speed * g_sdlAudioSpec.freq / PC_PIT_RATE;
     // In the original code, the id_sd.c:SDL_t0Service callback
@@ -765,16 +838,91 @@ void BE_ST_SetTimer(uint16_t speed, int isALMusicOn)
 
 uint32_t BE_ST_GetTimeCount(void)
 {
-    // FIXME: What happens when SDL_GetTicks() reaches the upper bound?
-    // May be challenging to fix... A proper solution should
-    // only work with *differences between SDL_GetTicks values*.
+    if (g_sdlVirtualTimer)
+    {
+        if (++g_sdlVirtualTimerReads >= BE_ST_VIRTUAL_TIMER_SPIN_READS)
+        {
+            BE_ST_AdvanceVirtualTimer(1);
+        }
+        return g_sdlTimeCount;
+    }
+
+    // The microseconds are counted from the first call in 64 bits,
+    // so unlike SDL_GetTicks() they don't wrap around while playing.
 
     // WARNING: This must have offset subtracted! (So the game "thinks" it gets the correct (but actually delayed) TimeCount value)
-    uint32_t currOffsettedSdlTicks = SDL_GetTicks() - g_sdlTicksOffset;
-    uint32_t ticksToAdd = (uint64_t)currOffsettedSdlTicks * (uint64_t)PC_PIT_RATE / (1000*g_sdlScaledTimerDivisor) - (uint64_t)g_sdlLastTicks * (uint64_t)PC_PIT_RATE / (1000*g_sdlScaledTimerDivisor);
+    const uint64_t divisor = (uint64_t)MICROS_PER_SEC*g_sdlScaledTimerDivisor;
+    uint64_t currOffsettedMicros = BEL_ST_GetMicros() - g_sdlMicrosOffset;
+    uint32_t ticksToAdd = currOffsettedMicros * PC_PIT_RATE / divisor - g_sdlLastMicros * PC_PIT_RATE / divisor;
     g_sdlTimeCount += ticksToAdd;
-    g_sdlLastTicks = currOffsettedSdlTicks;
+    g_sdlLastMicros = currOffsettedMicros;
     return g_sdlTimeCount;
 }
 
+
+
+/*** Profiling ***/
+
+#define BE_ST_PROFILE_MAX_DEPTH 16
+
+static bool g_sdlProfileEnabled = false;
+static uint64_t g_sdlProfileNanos[BE_ST_PROFILE_LAST];
+static BE_ST_ProfileModule_T g_sdlProfileStack[BE_ST_PROFILE_MAX_DEPTH];
+static int g_sdlProfileDepth;
+static uint64_t g_sdlProfileLastNanos;
+
+static uint64_t BEL_ST_GetNanos(void)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Whatever passed since the last enter or leave belongs to the innermost module
+static void BEL_ST_ProfileAccount(void)
+{
+	const uint64_t currNanos = BEL_ST_GetNanos();
+	if (g_sdlProfileDepth > 0)
+	{
+		const int top = (g_sdlProfileDepth < BE_ST_PROFILE_MAX_DEPTH) ? g_sdlProfileDepth : BE_ST_PROFILE_MAX_DEPTH;
+		g_sdlProfileNanos[g_sdlProfileStack[top-1]] += currNanos - g_sdlProfileLastNanos;
+	}
+	g_sdlProfileLastNanos = currNanos;
+}
+
+void BE_ST_ProfileEnable(bool enable)
+{
+	g_sdlProfileEnabled = enable;
+	g_sdlProfileDepth = 0;
+	memset(g_sdlProfileNanos, 0, sizeof(g_sdlProfileNanos));
+}
+
+void BE_ST_ProfileEnter(BE_ST_ProfileModule_T module)
+{
+	if (!g_sdlProfileEnabled)
+	{
+		return;
+	}
+	BEL_ST_ProfileAccount();
+	// Deeper nesting than that is counted for the module entered last in the stack
+	if (g_sdlProfileDepth < BE_ST_PROFILE_MAX_DEPTH)
+	{
+		g_sdlProfileStack[g_sdlProfileDepth] = module;
+	}
+	++g_sdlProfileDepth;
+}
+
+void BE_ST_ProfileLeave(void)
+{
+	if (!g_sdlProfileEnabled || (g_sdlProfileDepth <= 0))
+	{
+		return;
+	}
+	BEL_ST_ProfileAccount();
+	--g_sdlProfileDepth;
+}
+
+uint64_t BE_ST_ProfileGetNanos(BE_ST_ProfileModule_T module)
+{
+	return g_sdlProfileNanos[module];
+}
+
 }
@@ -1,5 +1,8 @@
 
 #include "engine/keen/dreams/dreamsengine.h"
+#include "engine/core/EGAPlanar.h"
+
+#include <vector>
 
 extern dreams::DreamsEngine *gDreamsEngine;
 
@@ -19,9 +22,13 @@ extern "C"
 static bool g_sdlDoRefreshGfxOutput;
 bool g_sdlForceGfxControlUiRefresh;
 
+// Set if all of the host surface has to be written again, not just the changed lines
+static bool g_sdlEGAForceFullOutput = true;
+
 void BE_ST_MarkGfxForUpdate(void)
 {
 	g_sdlDoRefreshGfxOutput = true;
+	g_sdlEGAForceFullOutput = true;
 }
 
 const int GFX_TEX_WIDTH  = 320;
@@ -56,12 +63,16 @@ static union {
 	uint8_t text[TXT_COLS_NUM*TXT_ROWS_NUM*2]; // Textual contents of B800:0000
 } g_sdlVidMem;
 
-// Used for simple caching of EGA graphics (due to page flipping and more)
-// and similarly CGA graphics (modified only at one place)
 static union {
 	uint8_t egaGfx[2*GFX_TEX_WIDTH*GFX_TEX_HEIGHT]; // Support 640x200 mode for Catacomb Abyss
 	uint8_t cgaGfx[GFX_TEX_WIDTH*GFX_TEX_HEIGHT];
-} g_sdlHostScrMem, g_sdlHostScrMemCache;
+} g_sdlHostScrMem;
+
+// Used for simple caching of CGA graphics (modified only at one place).
+// EGA graphics are tracked by the dirty chunks and line sources below.
+static struct {
+	uint8_t cgaGfx[GFX_TEX_WIDTH*GFX_TEX_HEIGHT];
+} g_sdlHostScrMemCache;
 
 static uint16_t g_sdlScreenStartAddress = 0;
 static int g_sdlScreenMode = 3;
@@ -73,6 +84,71 @@ static int g_sdlTxtCursorPosX, g_sdlTxtCursorPosY;
 static bool g_sdlTxtCursorEnabled = true;
 static int g_sdlTxtColor = 7, g_sdlTxtBackground = 0;
 
+/* Dirty tracking of the EGA video memory. Every write marks the chunks of
+ * the planes it touches, so updateEGAGraphics only converts the scanlines
+ * showing one of them. Page flips, pel panning, line width and split screen
+ * changes are found by comparing what every scanline showed the last time.
+ */
+#define EGA_DIRTY_CHUNK_SHIFT 3 // Chunks of 8 bytes, so a 40 bytes line is 5 or 6 of them
+#define EGA_DIRTY_NUM_CHUNKS (0x10000 >> EGA_DIRTY_CHUNK_SHIFT)
+static uint8_t g_sdlEGADirtyChunks[EGA_DIRTY_NUM_CHUNKS];
+
+// What a scanline of g_sdlHostScrMem.egaGfx was converted from
+typedef struct
+{
+	uint16_t firstByte;
+	uint8_t panning;
+	int16_t numPixels; // 0 if the line has to be converted in any case
+} BE_ST_EGALineSource;
+
+static BE_ST_EGALineSource g_sdlEGALineSources[GFX_TEX_HEIGHT];
+
+static inline void BEL_ST_MarkEGAByteDirty(uint16_t off)
+{
+	g_sdlEGADirtyChunks[off >> EGA_DIRTY_CHUNK_SHIFT] = 1;
+	g_sdlDoRefreshGfxOutput = true;
+}
+
+// The range may wrap around the end of the planes, just like the memory of the EGA
+static void BEL_ST_MarkEGARangeDirty(uint16_t off, uint16_t num)
+{
+	if (!num)
+		return;
+
+	int chunk = off >> EGA_DIRTY_CHUNK_SHIFT;
+	const int lastChunk = (uint16_t)(off + num - 1) >> EGA_DIRTY_CHUNK_SHIFT;
+	while (true)
+	{
+		g_sdlEGADirtyChunks[chunk] = 1;
+		if (chunk == lastChunk)
+			break;
+		chunk = (chunk + 1) % EGA_DIRTY_NUM_CHUNKS;
+	}
+	g_sdlDoRefreshGfxOutput = true;
+}
+
+static bool BEL_ST_IsEGARangeDirty(uint16_t off, uint16_t num)
+{
+	int chunk = off >> EGA_DIRTY_CHUNK_SHIFT;
+	const int lastChunk = (uint16_t)(off + num - 1) >> EGA_DIRTY_CHUNK_SHIFT;
+	while (true)
+	{
+		if (g_sdlEGADirtyChunks[chunk])
+			return true;
+		if (chunk == lastChunk)
+			return false;
+		chunk = (chunk + 1) % EGA_DIRTY_NUM_CHUNKS;
+	}
+}
+
+// Converts all the scanlines and writes all of the host surface the next time
+static void BEL_ST_InvalidateEGAOutput(void)
+{
+	memset(g_sdlEGALineSources, 0, sizeof(g_sdlEGALineSources));
+	g_sdlEGAForceFullOutput = true;
+	g_sdlDoRefreshGfxOutput = true;
+}
+
 
 /*** Game controller UI resource definitions ***/
 
@@ -589,8 +665,12 @@ void BE_ST_SetGfxOutputRects(void)
 */
 void BE_ST_SetScreenStartAddress(uint16_t crtc)
 {
-	g_sdlScreenStartAddress = crtc;
-	g_sdlDoRefreshGfxOutput = true;
+	// Every scanline remembers where it came from, so a flip only needs the refresh flag
+	if (g_sdlScreenStartAddress != crtc)
+	{
+		g_sdlScreenStartAddress = crtc;
+		g_sdlDoRefreshGfxOutput = true;
+	}
 }
 
 uint8_t *BE_ST_GetTextModeMemoryPtr(void)
@@ -635,14 +715,21 @@ void BE_ST_EGASetPaletteAndBorder(const uint8_t *palette)
 
 void BE_ST_EGASetPelPanning(uint8_t panning)
 {
-	g_sdlPelPanning = panning;
-	g_sdlDoRefreshGfxOutput = true;
+	// Keen Dreams sets this on every frame
+	if (g_sdlPelPanning != panning)
+	{
+		g_sdlPelPanning = panning;
+		g_sdlDoRefreshGfxOutput = true;
+	}
 }
 
 void BE_ST_EGASetLineWidth(uint8_t widthInBytes)
 {
-	g_sdlLineWidth = widthInBytes;
-	g_sdlDoRefreshGfxOutput = true;
+	if (g_sdlLineWidth != widthInBytes)
+	{
+		g_sdlLineWidth = widthInBytes;
+		g_sdlDoRefreshGfxOutput = true;
+	}
 }
 
 void BE_ST_EGASetSplitScreen(int16_t linenum)
@@ -659,6 +746,7 @@ void BE_ST_EGASetSplitScreen(int16_t linenum)
 	}
 	else
 		g_sdlSplitScreenLine = linenum;
+	g_sdlDoRefreshGfxOutput = true;
 }
 
 void BE_ST_EGAUpdateGFXByte(uint16_t destOff, uint8_t srcVal, uint16_t planeMask)
@@ -671,7 +759,7 @@ void BE_ST_EGAUpdateGFXByte(uint16_t destOff, uint8_t srcVal, uint16_t planeMask
 		g_sdlVidMem.egaGfx[2][destOff] = srcVal;
 	if (planeMask & 8)
 		g_sdlVidMem.egaGfx[3][destOff] = srcVal;
-	g_sdlDoRefreshGfxOutput = true;
+	BEL_ST_MarkEGAByteDirty(destOff);
 }
 
 // Same as BE_ST_EGAUpdateGFXByte but picking specific bits out of each byte, and WITHOUT plane mask
@@ -681,7 +769,7 @@ void BE_ST_EGAUpdateGFXBits(uint16_t destOff, uint8_t srcVal, uint8_t bitsMask)
 	g_sdlVidMem.egaGfx[1][destOff] = (g_sdlVidMem.egaGfx[1][destOff] & ~bitsMask) | (srcVal & bitsMask); 
 	g_sdlVidMem.egaGfx[2][destOff] = (g_sdlVidMem.egaGfx[2][destOff] & ~bitsMask) | (srcVal & bitsMask); 
 	g_sdlVidMem.egaGfx[3][destOff] = (g_sdlVidMem.egaGfx[3][destOff] & ~bitsMask) | (srcVal & bitsMask); 
-	g_sdlDoRefreshGfxOutput = true;
+	BEL_ST_MarkEGAByteDirty(destOff);
 }
 
 // Based on BE_Cross_LinearToWrapped_MemCopy
@@ -697,7 +785,6 @@ static void BEL_ST_LinearToEGAPlane_MemCopy(uint8_t *planeDstPtr, uint16_t plane
 		memcpy(planeDstPtr+planeDstOff, linearSrc, bytesToEnd);
 		memcpy(planeDstPtr, linearSrc+bytesToEnd, num-bytesToEnd);
 	}
-	g_sdlDoRefreshGfxOutput = true;
 }
 
 // Based on BE_Cross_WrappedToLinear_MemCopy
@@ -756,7 +843,6 @@ static void BEL_ST_EGAPlaneToEGAPlane_MemCopy(uint8_t *planeCommonPtr, uint16_t
 		memcpy(planeCommonPtr, planeCommonPtr+planeSrcOff+dstBytesToEnd, srcBytesToEnd-dstBytesToEnd);
 		memcpy(planeCommonPtr+(srcBytesToEnd-dstBytesToEnd), planeCommonPtr, num-srcBytesToEnd);
 	}
-	g_sdlDoRefreshGfxOutput = true;
 }
 
 void BE_ST_EGAUpdateGFXBuffer(uint16_t destOff, const uint8_t *srcPtr, uint16_t num, uint16_t planeMask)
@@ -769,7 +855,7 @@ void BE_ST_EGAUpdateGFXBuffer(uint16_t destOff, const uint8_t *srcPtr, uint16_t
 		BEL_ST_LinearToEGAPlane_MemCopy(g_sdlVidMem.egaGfx[2], destOff, srcPtr, num);
 	if (planeMask & 8)
 		BEL_ST_LinearToEGAPlane_MemCopy(g_sdlVidMem.egaGfx[3], destOff, srcPtr, num);
-	g_sdlDoRefreshGfxOutput = true;
+	BEL_ST_MarkEGARangeDirty(destOff, num);
 }
 
 void BE_ST_EGAUpdateGFXByteScrToScr(uint16_t destOff, uint16_t srcOff)
@@ -778,7 +864,7 @@ void BE_ST_EGAUpdateGFXByteScrToScr(uint16_t destOff, uint16_t srcOff)
 	g_sdlVidMem.egaGfx[1][destOff] = g_sdlVidMem.egaGfx[1][srcOff];
 	g_sdlVidMem.egaGfx[2][destOff] = g_sdlVidMem.egaGfx[2][srcOff];
 	g_sdlVidMem.egaGfx[3][destOff] = g_sdlVidMem.egaGfx[3][srcOff];
-	g_sdlDoRefreshGfxOutput = true;
+	BEL_ST_MarkEGAByteDirty(destOff);
 }
 
 // Same as BE_ST_EGAUpdateGFXByteScrToScr but with plane mask (added for Catacomb Abyss vanilla bug reproduction/workaround)
@@ -792,7 +878,7 @@ void BE_ST_EGAUpdateGFXByteWithPlaneMaskScrToScr(uint16_t destOff, uint16_t srcO
 		g_sdlVidMem.egaGfx[2][destOff] = g_sdlVidMem.egaGfx[2][srcOff];
 	if (planeMask & 8)
 		g_sdlVidMem.egaGfx[3][destOff] = g_sdlVidMem.egaGfx[3][srcOff];
-	g_sdlDoRefreshGfxOutput = true;
+	BEL_ST_MarkEGAByteDirty(destOff);
 }
 
 // Same as BE_ST_EGAUpdateGFXByteScrToScr but picking specific bits out of each byte
@@ -802,7 +888,7 @@ void BE_ST_EGAUpdateGFXBitsScrToScr(uint16_t destOff, uint16_t srcOff, uint8_t b
 	g_sdlVidMem.egaGfx[1][destOff] = (g_sdlVidMem.egaGfx[1][destOff] & ~bitsMask) | (g_sdlVidMem.egaGfx[1][srcOff] & bitsMask); 
 	g_sdlVidMem.egaGfx[2][destOff] = (g_sdlVidMem.egaGfx[2][destOff] & ~bitsMask) | (g_sdlVidMem.egaGfx[2][srcOff] & bitsMask); 
 	g_sdlVidMem.egaGfx[3][destOff] = (g_sdlVidMem.egaGfx[3][destOff] & ~bitsMask) | (g_sdlVidMem.egaGfx[3][srcOff] & bitsMask); 
-	g_sdlDoRefreshGfxOutput = true;
+	BEL_ST_MarkEGAByteDirty(destOff);
 }
 
 void BE_ST_EGAUpdateGFXBufferScrToScr(uint16_t destOff, uint16_t srcOff, uint16_t num)
@@ -811,7 +897,7 @@ void BE_ST_EGAUpdateGFXBufferScrToScr(uint16_t destOff, uint16_t srcOff, uint16_
 	BEL_ST_EGAPlaneToEGAPlane_MemCopy(g_sdlVidMem.egaGfx[1], destOff, srcOff, num);
 	BEL_ST_EGAPlaneToEGAPlane_MemCopy(g_sdlVidMem.egaGfx[2], destOff, srcOff, num);
 	BEL_ST_EGAPlaneToEGAPlane_MemCopy(g_sdlVidMem.egaGfx[3], destOff, srcOff, num);
-	g_sdlDoRefreshGfxOutput = true;
+	BEL_ST_MarkEGARangeDirty(destOff, num);
 }
 
 uint8_t BE_ST_EGAFetchGFXByte(uint16_t destOff, uint16_t planenum)
@@ -840,7 +926,7 @@ void BE_ST_EGAUpdateGFXPixel4bpp(uint16_t destOff, uint8_t color, uint8_t bitsMa
 			g_sdlVidMem.egaGfx[3][destOff] |= (((color & 8) >> 3) << currBitNum);
 		}
 	}
-	g_sdlDoRefreshGfxOutput = true;
+	BEL_ST_MarkEGAByteDirty(destOff);
 }
 
 void BE_ST_EGAUpdateGFXPixel4bppRepeatedly(uint16_t destOff, uint8_t color, uint16_t count, uint8_t bitsMask)
@@ -861,7 +947,7 @@ void BE_ST_EGAXorGFXByte(uint16_t destOff, uint8_t srcVal, uint16_t planeMask)
 		g_sdlVidMem.egaGfx[2][destOff] ^= srcVal;
 	if (planeMask & 8)
 		g_sdlVidMem.egaGfx[3][destOff] ^= srcVal;
-	g_sdlDoRefreshGfxOutput = true;
+	BEL_ST_MarkEGAByteDirty(destOff);
 }
 
 // Like BE_ST_EGAXorGFXByte, but:
@@ -874,7 +960,22 @@ void BE_ST_EGAOrGFXBits(uint16_t destOff, uint8_t srcVal, uint8_t bitsMask)
 	g_sdlVidMem.egaGfx[1][destOff] |= (srcVal & bitsMask); 
 	g_sdlVidMem.egaGfx[2][destOff] |= (srcVal & bitsMask); 
 	g_sdlVidMem.egaGfx[3][destOff] |= (srcVal & bitsMask); 
-	g_sdlDoRefreshGfxOutput = true;
+	BEL_ST_MarkEGAByteDirty(destOff);
+}
+
+// FNV-1a over the planes, one after the other
+uint32_t BE_ST_EGAChecksumGFX(void)
+{
+	uint32_t hash = 2166136261u;
+	for (int plane = 0; plane < 4; ++plane)
+	{
+		const uint8_t *planePtr = g_sdlVidMem.egaGfx[plane];
+		for (int off = 0; off < 0x10000; ++off)
+		{
+			hash = (hash ^ planePtr[off]) * 16777619u;
+		}
+	}
+	return hash;
 }
 
 
@@ -951,7 +1052,7 @@ void BE_ST_SetScreenMode(int mode)
             memset(g_sdlVidMem.egaGfx, 0, sizeof(g_sdlVidMem.egaGfx));
         }
         memset(g_sdlHostScrMem.egaGfx, 0, sizeof(g_sdlHostScrMem.egaGfx));
-        g_sdlHostScrMemCache.egaGfx[0] = g_sdlHostScrMem.egaGfx[0]^0xFF; // Force refresh
+        BEL_ST_InvalidateEGAOutput(); // Force refresh
         break;
     case 0xE:
         g_sdlTexWidth = 2*GFX_TEX_WIDTH;
@@ -966,8 +1067,8 @@ void BE_ST_SetScreenMode(int mode)
         {
             memset(g_sdlVidMem.egaGfx,  0, sizeof(g_sdlVidMem.egaGfx));
         }
-        memset(g_sdlHostScrMem.egaGfx,  0, sizeof(g_sdlHostScrMem.egaGfx));
-        g_sdlHostScrMemCache.egaGfx[0] = g_sdlHostScrMem.egaGfx[0]^0xFF; // Force refresh
+        memset(g_sdlHostScrMem.egaGfx, 0, sizeof(g_sdlHostScrMem.egaGfx));
+        BEL_ST_InvalidateEGAOutput(); // Force refresh
         break;
     }
     g_sdlScreenMode = mode;
@@ -1319,213 +1420,186 @@ void updateTextMode(SDL_Surface *sfc)
 }
 
 
-void updateEGAGraphics(SDL_Surface *sfc)
+// Bytes of one scanline at most, that is 640 pixels and one more byte for the pel panning
+#define EGA_MAX_LINE_BYTES (2*GFX_TEX_WIDTH/8+1)
+
+/* Converts the scanline starting at firstByte into colour indices in
+ * lineIndices (8*EGA_MAX_LINE_BYTES bytes) and returns where its first
+ * visible pixel is, that is after the pel panning bits of the first byte.
+ * Lines which wrap around the end of the 64KB planes are copied
+ * to a small buffer first.
+ */
+static const uint8_t *BEL_ST_EGALineToChunky(uint8_t *lineIndices, uint16_t firstByte, uint8_t panningWithinByte, int numPixels)
 {
-    uint32_t ratioW = (sfc->w)/(g_sdlTexWidth);
-    uint32_t ratioH = (sfc->h)/(g_sdlTexHeight);
+    uint8_t wrappedLine[4][EGA_MAX_LINE_BYTES];
+    const uint8_t *planes[4];
+    const int numBytes = (panningWithinByte + numPixels + 7)/8;
 
-    if(ratioW == 1 && ratioH == 1) // Optimized. One layer less and
-                                   // fewer loops to run through
+    if (firstByte + numBytes <= 0x10000)
     {
-        if(SDL_MUSTLOCK(sfc)) SDL_LockSurface(sfc);
-
-        void *pixels = sfc->pixels;
-
-        uint32_t *currPixPtr = (uint32_t *)pixels;
-
-        uint16_t currLineFirstByte = (g_sdlScreenStartAddress + g_sdlPelPanning/8) % 0x10000;
-        uint8_t panningWithinInByte = g_sdlPelPanning%8;
-        bool doUpdate = false;
-        for (int line = 0, col; line < g_sdlTexHeight; ++line)
+        for (int plane = 0; plane < 4; ++plane)
+            planes[plane] = g_sdlVidMem.egaGfx[plane] + firstByte;
+    }
+    else
+    {
+        for (int plane = 0; plane < 4; ++plane)
         {
-            uint8_t currBitNum = 7-panningWithinInByte, currBitMask = 1<<currBitNum;
-            uint16_t currByte = currLineFirstByte;
-
-            for (col = 0; col < g_sdlTexWidth; ++col)
-            {
-                const uint8_t thePixel =
-                           ((g_sdlVidMem.egaGfx[0][currByte]&currBitMask)>>currBitNum) |
-                          (((g_sdlVidMem.egaGfx[1][currByte]&currBitMask)>>currBitNum)<<1) |
-                          (((g_sdlVidMem.egaGfx[2][currByte]&currBitMask)>>currBitNum)<<2) |
-                          (((g_sdlVidMem.egaGfx[3][currByte]&currBitMask)>>currBitNum)<<3);
-
-                *currPixPtr = g_sdlEGACurrBGRAPaletteAndBorder[thePixel];
+            for (int i = 0; i < numBytes; ++i)
+                wrappedLine[plane][i] = g_sdlVidMem.egaGfx[plane][(uint16_t)(firstByte + i)];
+            planes[plane] = wrappedLine[plane];
+        }
+    }
 
-                currPixPtr++;
+    planar::toChunky(lineIndices, planes, numBytes);
+    return lineIndices + panningWithinByte;
+}
 
-                if (currBitNum == 0)
-                {
-                    ++currByte;
-                    currByte %= 0x10000;
-                    currBitNum = 7;
-                    currBitMask = 0x80;
-                }
-                else
-                {
-                    --currBitNum;
-                    currBitMask >>= 1;
-                }
-                if (col == 8*g_sdlLineWidth)
-                {
-                    ++col;
-                    break;
-                }
-            }
+// Texture pixel shown by every column of a surface which isn't a whole multiple of the texture width
+static std::vector<uint16_t> g_sdlEGAColumnSources;
+static int g_sdlEGAColumnSourcesSfcW, g_sdlEGAColumnSourcesTexW;
 
-            if (g_sdlSplitScreenLine == line)
-            {
-                currLineFirstByte = 0; // NEXT line begins split screen, NOT g_sdlSplitScreenLine
-            }
-            else
-            {
-                currLineFirstByte += g_sdlLineWidth;
-                currLineFirstByte %= 0x10000;
-            }
-        }
+static void BEL_ST_SetupEGAColumnSources(int sfcWidth)
+{
+    if (g_sdlEGAColumnSourcesSfcW == sfcWidth && g_sdlEGAColumnSourcesTexW == g_sdlTexWidth)
+        return;
 
-        if(SDL_MUSTLOCK(sfc)) SDL_UnlockSurface(sfc);
+    g_sdlEGAColumnSources.resize(sfcWidth);
+    for (int x = 0; x < sfcWidth; ++x)
+        g_sdlEGAColumnSources[x] = (uint16_t)(x*g_sdlTexWidth/sfcWidth);
 
-        if (!doUpdate)
-        {
-            int paletteAndBorderEntry;
-            for (paletteAndBorderEntry = 0; paletteAndBorderEntry < 17; ++paletteAndBorderEntry)
-            {
-                if (g_sdlEGACurrBGRAPaletteAndBorder[paletteAndBorderEntry] != g_sdlEGACurrBGRAPaletteAndBorderCache[paletteAndBorderEntry])
-                {
-                    g_sdlEGACurrBGRAPaletteAndBorderCache[paletteAndBorderEntry] = g_sdlEGACurrBGRAPaletteAndBorder[paletteAndBorderEntry];
-                    doUpdate = true;
-                }
-            }
-            if (!doUpdate)
-            {
-                g_sdlDoRefreshGfxOutput = false;
-                return;
-            }
-        }
+    g_sdlEGAColumnSourcesSfcW = sfcWidth;
+    g_sdlEGAColumnSourcesTexW = g_sdlTexWidth;
+}
 
-        g_sdlDoRefreshGfxOutput = false;
+/* Writes a scanline of g_sdlHostScrMem.egaGfx to the host surface. If the
+ * surface is bigger than the texture, the line is palettised and enlarged
+ * into its first row only, the other rows showing it are copies of that one.
+ * ratioW is the whole number of columns per pixel, or 0 if the surface width
+ * isn't a multiple of the texture width and the line is stretched over it.
+ * The height is always filled, so lines get one row more or less when it
+ * isn't a multiple either (aspect corrected output).
+ */
+static void BEL_ST_OutputEGALine(SDL_Surface *sfc, int line, uint32_t ratioW)
+{
+    const uint8_t *linePalPixPtr = g_sdlHostScrMem.egaGfx + line*g_sdlTexWidth;
+    const int firstRow = line*sfc->h/g_sdlTexHeight;
+    const int numRows = (line+1)*sfc->h/g_sdlTexHeight - firstRow;
+    uint8_t *sfcLinePtr = (uint8_t *)sfc->pixels + firstRow*sfc->pitch;
+    uint32_t *firstRowPtr = (uint32_t *)(void *)sfcLinePtr;
 
+    if (ratioW == 1)
+    {
+        planar::palettise(firstRowPtr, linePalPixPtr, g_sdlTexWidth, g_sdlEGACurrBGRAPaletteAndBorder);
     }
-    else // unoptimized. This happens when the game resolution does not match the keen dreams resolution
+    else
     {
+        uint32_t linePixels[2*GFX_TEX_WIDTH];
+        planar::palettise(linePixels, linePalPixPtr, g_sdlTexWidth, g_sdlEGACurrBGRAPaletteAndBorder);
 
-        uint16_t currLineFirstByte = (g_sdlScreenStartAddress + g_sdlPelPanning/8) % 0x10000;
-        uint8_t panningWithinInByte = g_sdlPelPanning%8;
-        uint8_t *currPalPixPtrBase, *currPalPixCachePtr;
-        bool doUpdate = false;
-        for (int line = 0, col; line < g_sdlTexHeight; ++line)
-        {
-            uint8_t currBitNum = 7-panningWithinInByte, currBitMask = 1<<currBitNum;
-            uint16_t currByte = currLineFirstByte;
-            currPalPixPtrBase = g_sdlHostScrMem.egaGfx + line*g_sdlTexWidth;
-            currPalPixCachePtr = g_sdlHostScrMemCache.egaGfx + line*g_sdlTexWidth;
-            for (col = 0; col < g_sdlTexWidth; ++col, ++currPalPixPtrBase)
-            {
-                *currPalPixPtrBase = ((g_sdlVidMem.egaGfx[0][currByte]&currBitMask)>>currBitNum) |
-                        (((g_sdlVidMem.egaGfx[1][currByte]&currBitMask)>>currBitNum)<<1) |
-                        (((g_sdlVidMem.egaGfx[2][currByte]&currBitMask)>>currBitNum)<<2) |
-                        (((g_sdlVidMem.egaGfx[3][currByte]&currBitMask)>>currBitNum)<<3);
+        if (ratioW)
+            planar::widen(firstRowPtr, linePixels, g_sdlTexWidth, ratioW);
+        else
+            planar::stretch(firstRowPtr, linePixels, g_sdlEGAColumnSources.data(), sfc->w);
+    }
 
-                doUpdate |= (*currPalPixPtrBase != *currPalPixCachePtr);
-                *currPalPixCachePtr = *currPalPixPtrBase;
+    const size_t rowBytes = (ratioW ? ratioW*g_sdlTexWidth : sfc->w)*sizeof(uint32_t);
+    for (int row = 1; row < numRows; ++row)
+        memcpy(sfcLinePtr + row*sfc->pitch, firstRowPtr, rowBytes);
+}
 
-                if (currBitNum == 0)
-                {
-                    ++currByte;
-                    currByte %= 0x10000;
-                    currBitNum = 7;
-                    currBitMask = 0x80;
-                }
-                else
-                {
-                    --currBitNum;
-                    currBitMask >>= 1;
-                }
-                if (col == 8*g_sdlLineWidth)
-                {
-                    ++col;
-                    ++currPalPixPtrBase;
-                    ++currPalPixCachePtr;
-                    break;
-                }
-            }
-            // Just if this makes sense... (FIXME: Check!)
-            for (; col < g_sdlTexWidth; ++col, ++currPalPixPtrBase, ++currPalPixCachePtr)
-            {
-                doUpdate |= (*currPalPixCachePtr);
-            }
+void updateEGAGraphics(SDL_Surface *sfc)
+{
+    static SDL_Surface *lastSfc = NULL;
+    static int lastSfcW = 0, lastSfcH = 0;
 
-            memset(currPalPixPtrBase, 0, sizeof(uint8_t));
-            memset(currPalPixCachePtr, 0, sizeof(uint8_t));
+    if(sfc->w < g_sdlTexWidth || sfc->h < g_sdlTexHeight)
+        return;
 
-            if (g_sdlSplitScreenLine == line)
-            {
-                currLineFirstByte = 0; // NEXT line begins split screen, NOT g_sdlSplitScreenLine
-            }
-            else
-            {
-                currLineFirstByte += g_sdlLineWidth;
-                currLineFirstByte %= 0x10000;
-            }
-        }
+    const uint32_t ratioW = (sfc->w % g_sdlTexWidth) ? 0 : (sfc->w)/(g_sdlTexWidth);
+    if(!ratioW)
+        BEL_ST_SetupEGAColumnSources(sfc->w);
 
-        if (!doUpdate)
+    // Another surface or a resized one has none of the lines drawn yet
+    bool doFullOutput = g_sdlEGAForceFullOutput;
+    if(sfc != lastSfc || sfc->w != lastSfcW || sfc->h != lastSfcH)
+    {
+        lastSfc = sfc;
+        lastSfcW = sfc->w;
+        lastSfcH = sfc->h;
+        doFullOutput = true;
+    }
+
+    // A changed palette is applied to all the lines, but none has to be converted again
+    for (int paletteAndBorderEntry = 0; paletteAndBorderEntry < 17; ++paletteAndBorderEntry)
+    {
+        if (g_sdlEGACurrBGRAPaletteAndBorder[paletteAndBorderEntry] != g_sdlEGACurrBGRAPaletteAndBorderCache[paletteAndBorderEntry])
         {
-            int paletteAndBorderEntry;
-            for (paletteAndBorderEntry = 0; paletteAndBorderEntry < 17; ++paletteAndBorderEntry)
-            {
-                if (g_sdlEGACurrBGRAPaletteAndBorder[paletteAndBorderEntry] != g_sdlEGACurrBGRAPaletteAndBorderCache[paletteAndBorderEntry])
-                {
-                    g_sdlEGACurrBGRAPaletteAndBorderCache[paletteAndBorderEntry] = g_sdlEGACurrBGRAPaletteAndBorder[paletteAndBorderEntry];
-                    doUpdate = true;
-                }
-            }
-            if (!doUpdate)
-            {
-                g_sdlDoRefreshGfxOutput = false;
-                return;
-            }
+            g_sdlEGACurrBGRAPaletteAndBorderCache[paletteAndBorderEntry] = g_sdlEGACurrBGRAPaletteAndBorder[paletteAndBorderEntry];
+            doFullOutput = true;
         }
+    }
 
-        if(SDL_MUSTLOCK(sfc)) SDL_LockSurface(sfc);
-
-        void *pixels = sfc->pixels;
-
-        uint32_t *currPixPtrBase = (uint32_t *)pixels;
-        currPalPixPtrBase = g_sdlHostScrMem.egaGfx;
-
-        // Can we skip loops by just blitting the surfaces?
+    if (!g_sdlDoRefreshGfxOutput && !doFullOutput)
+        return;
 
-        uint8_t *currPalPixPtr = currPalPixPtrBase;
+    uint16_t currLineFirstByte = (g_sdlScreenStartAddress + g_sdlPelPanning/8) % 0x10000;
+    const uint8_t panningWithinInByte = g_sdlPelPanning%8;
+    // A line ends after the pixel at 8*g_sdlLineWidth, if that comes before the texture width
+    const int lineNumPixels = (8*g_sdlLineWidth < g_sdlTexWidth) ? (8*g_sdlLineWidth+1) : g_sdlTexWidth;
+    const uint16_t lineNumBytes = (panningWithinInByte + lineNumPixels + 7)/8;
+    uint8_t lineIndices[8*EGA_MAX_LINE_BYTES];
+    bool lineChanged[GFX_TEX_HEIGHT];
 
-        /*if( ratioW == 1 && ratioH == 1)
+    for (int line = 0; line < g_sdlTexHeight; ++line)
     {
-        memcpy(currPixPtrBase, );
-    }
-    else*/
-        {
-            for(int pixY=0 ; pixY < sfc->h ; pixY++ )
-            {
-                uint32_t *currPixPtr = currPixPtrBase + pixY*sfc->w;
+        BE_ST_EGALineSource &source = g_sdlEGALineSources[line];
+        lineChanged[line] = false;
 
-                const int yStart = (pixY/ratioH)*GFX_TEX_WIDTH;
+        // Convert the line again only if it shows other memory than before or that memory was written
+        if ((source.numPixels != lineNumPixels) || (source.firstByte != currLineFirstByte) ||
+            (source.panning != panningWithinInByte) || BEL_ST_IsEGARangeDirty(currLineFirstByte, lineNumBytes))
+        {
+            uint8_t *currPalPixPtr = g_sdlHostScrMem.egaGfx + line*g_sdlTexWidth;
+            const uint8_t *linePixels = BEL_ST_EGALineToChunky(lineIndices, currLineFirstByte, panningWithinInByte, lineNumPixels);
 
-                for(uint32_t pixX=0 ; pixX < ratioW*GFX_TEX_WIDTH ; pixX++ )
-                {
-                    currPalPixPtr = currPalPixPtrBase + yStart + pixX/ratioW;
+            // A flip to a page which looks the same doesn't need to be written out
+            if ((source.numPixels != lineNumPixels) || memcmp(currPalPixPtr, linePixels, lineNumPixels))
+            {
+                memcpy(currPalPixPtr, linePixels, lineNumPixels);
+                lineChanged[line] = true;
+            }
+            memset(currPalPixPtr + lineNumPixels, 0, g_sdlTexWidth - lineNumPixels);
 
-                    *currPixPtr = g_sdlEGACurrBGRAPaletteAndBorder[*currPalPixPtr];
+            source.firstByte = currLineFirstByte;
+            source.panning = panningWithinInByte;
+            source.numPixels = lineNumPixels;
+        }
 
-                    currPixPtr++;
-                }
-            }
+        if (g_sdlSplitScreenLine == line)
+        {
+            currLineFirstByte = 0; // NEXT line begins split screen, NOT g_sdlSplitScreenLine
         }
+        else
+        {
+            currLineFirstByte += g_sdlLineWidth;
+            currLineFirstByte %= 0x10000;
+        }
+    }
 
-        g_sdlDoRefreshGfxOutput = false;
+    // Everything written so far is on the lines now, or on lines which will notice their source has changed
+    memset(g_sdlEGADirtyChunks, 0, sizeof(g_sdlEGADirtyChunks));
+    g_sdlDoRefreshGfxOutput = false;
+    g_sdlEGAForceFullOutput = false;
 
-        if(SDL_MUSTLOCK(sfc)) SDL_UnlockSurface(sfc);
+    if(SDL_MUSTLOCK(sfc)) SDL_LockSurface(sfc);
 
+    for (int line = 0; line < g_sdlTexHeight; ++line)
+    {
+        if (doFullOutput || lineChanged[line])
+            BEL_ST_OutputEGALine(sfc, line, ratioW);
     }
+
+    if(SDL_MUSTLOCK(sfc)) SDL_UnlockSurface(sfc);
 }
 
 void BEL_ST_UpdateHostDisplay(SDL_Surface *sfc)
@@ -61,12 +61,6 @@ loaded into the data segment
 =============================================================================
 */
 
-typedef struct
-{
-  id0_unsigned_t bit0,bit1;	// 0-255 is a character, > is a pointer to a node
-} __attribute__((__packed__)) huffnode;
-
-
 typedef struct
 {
 	id0_unsigned_t	RLEWtag;
@@ -146,6 +140,11 @@ id0_long_t		chunkcomplen,chunkexplen;
 
 SDMode		oldsoundmode;
 
+#if GRMODE == EGAGR
+void CAL_ShutdownShiftCache (void);
+#endif
+void CAL_ShutdownMapCache (void);
+
 /*
 =============================================================================
 
@@ -277,98 +276,6 @@ id0_boolean_t CA_LoadFile (const id0_char_t *filename, memptr *ptr)
 
 
 
-/*
-===============
-=
-= CAL_OptimizeNodes
-=
-= Goes through a huffman table and changes the 256-511 node numbers to the
-= actular address of the node.  Must be called before CAL_HuffExpand
-=
-===============
-*/
-
-// TODO: We should remove that and use our implementation
-void CAL_OptimizeNodes (huffnode *table)
-{
-  /*** COMMENTED OUT - Not really useful in modern platforms as-is ***/
-#if 0
-  huffnode *node;
-  id0_int_t i;
-
-  node = table;
-
-  for (i=0;i<255;i++)
-  {
-	if (node->bit0 >= 256)
-	  node->bit0 = (id0_unsigned_t)(table+(node->bit0-256));
-	if (node->bit1 >= 256)
-	  node->bit1 = (id0_unsigned_t)(table+(node->bit1-256));
-	node++;
-  }
-#endif
-}
-
-
-
-/*
-======================
-=
-= CAL_HuffExpand
-=
-= Length is the length of the EXPANDED data
-=
-======================
-*/
-
-void CAL_HuffExpand (uint8_t *source, uint8_t *dest,
-  int32_t length, huffnode *hufftable)
-{
-	id0_unsigned_t code;
-	huffnode *headptr = hufftable+254; // head node is always node 254
-	huffnode *nodeon = headptr;
-
-	//------------
-	// expand data
-	//------------
-
-	// Ported from ASM
-	id0_byte_t id0_huge *srcptr = source, *dstptr = dest, *dstendptr = dest+length;
-	id0_byte_t byteval = *(srcptr++); // load first byte
-	id0_byte_t bitmask = 1;
-	do
-	{
-		// take bit0 or bit1 path from node
-		code = (byteval & bitmask) ? nodeon->bit1 : nodeon->bit0;
-		if (bitmask & 0x80)
-		{
-			byteval = *(srcptr++); // load next byte
-			bitmask = 1; // back to first bit
-		}
-		else
-		{
-			bitmask <<= 1; // advance to next bit position
-		}
-		// if < 256 it's a byte, else move node
-		if (code >= 256)
-		{
-			// NOTE: CAL_OptimizeNodes does nothing now
-			// and we do refer to hufftable itself here
-			nodeon = hufftable + (code-256);
-			continue;
-		}
-		*(dstptr++) = code; // write a decompressed byte out
-		nodeon = headptr; // back to the head node for next bit
-
-		if (dstptr == dstendptr) // done?
-		{
-			break;
-		}
-	} while (true);
-}
-
-
-
 /*
 ======================
 =
@@ -872,6 +779,11 @@ void CA_Shutdown (void)
 
 	BE_Cross_close (maphandle);
 	BE_Cross_close (grhandle);
+
+#if GRMODE == EGAGR
+	CAL_ShutdownShiftCache ();
+#endif
+	CAL_ShutdownMapCache ();
 }
 
 //===========================================================================
@@ -1096,6 +1008,141 @@ void CAL_ShiftSprite (id0_byte_t *source, id0_byte_t *dest,
 	}
 }
 
+/*
+=============================================================================
+
+						(REFKEEN) SHIFT CACHE
+
+Only the unshifted shape of a sprite is kept in its grseg. The shifted copies
+are made by CA_ShiftedSprite when they are drawn for the first time, and kept
+in a fixed number of slots outside of the emulated memory. When all the slots
+are taken, the one drawn least recently is reused.
+
+=============================================================================
+*/
+
+#define SHIFTCACHESLOTS	128
+
+typedef struct
+{
+	id0_int_t		chunk;
+	id0_unsigned_t	pixshift;
+	id0_longword_t	lastused;		// 0 if the slot is free
+	id0_unsigned_t	size;
+	id0_byte_t		*data;
+} shiftslottype;
+
+static shiftslottype	shiftslots[SHIFTCACHESLOTS];
+static id0_byte_t		shiftslotof[NUMSPRITES][4];	// 1 + slot of each pixshift/2, 0 if not made
+static id0_longword_t	shiftclock;
+
+
+/*
+======================
+=
+= CA_ShiftedSprite
+=
+= Returns the mask and four planes of the sprite, shifted right by pixshift
+= pixels. The data stays valid until the next call.
+=
+======================
+*/
+
+id0_byte_t *CA_ShiftedSprite (id0_int_t chunk, id0_unsigned_t pixshift)
+{
+	spritetabletype id0_far *spr;
+	spritetype id0_seg *block;
+	shiftslottype *slot;
+	id0_unsigned_t size;
+	id0_int_t i;
+
+	block = (spritetype id0_seg *)grsegs[chunk];
+
+	if (!pixshift)
+		return (id0_byte_t *)block + block->sourceoffset[0];
+
+	i = shiftslotof[chunk-STARTSPRITES][pixshift/2];
+	if (i)
+	{
+		slot = &shiftslots[i-1];
+		slot->lastused = ++shiftclock;
+		return slot->data;
+	}
+
+//
+// take a free slot or the one unused for the longest time
+//
+	slot = &shiftslots[0];
+	for (i=1;i<SHIFTCACHESLOTS && slot->lastused;i++)
+		if (shiftslots[i].lastused < slot->lastused)
+			slot = &shiftslots[i];
+
+	if (slot->lastused)
+		shiftslotof[slot->chunk-STARTSPRITES][slot->pixshift/2] = 0;
+
+	spr = &spritetable[chunk-STARTSPRITES];
+	size = (spr->width+1)*spr->height*5;
+	if (slot->size < size)
+	{
+		free (slot->data);
+		slot->data = (id0_byte_t *)malloc (size);
+		if (!slot->data)
+			Quit ("CA_ShiftedSprite: Out of memory!");
+		slot->size = size;
+	}
+
+	CAL_ShiftSprite ((id0_byte_t *)block + block->sourceoffset[0],slot->data,
+		spr->width,spr->height,pixshift);
+
+	slot->chunk = chunk;
+	slot->pixshift = pixshift;
+	slot->lastused = ++shiftclock;
+	shiftslotof[chunk-STARTSPRITES][pixshift/2] = (slot-shiftslots)+1;
+
+	return slot->data;
+}
+
+
+/*
+======================
+=
+= CA_ClearShiftedSprite
+=
+= Drops the shifted copies of a sprite, call it after changing its shape
+=
+======================
+*/
+
+void CA_ClearShiftedSprite (id0_int_t chunk)
+{
+	id0_int_t i,slot;
+
+	for (i=0;i<4;i++)
+	{
+		slot = shiftslotof[chunk-STARTSPRITES][i];
+		if (slot)
+		{
+			shiftslots[slot-1].lastused = 0;
+			shiftslotof[chunk-STARTSPRITES][i] = 0;
+		}
+	}
+}
+
+
+void CAL_ShutdownShiftCache (void)
+{
+	id0_int_t i;
+
+	for (i=0;i<SHIFTCACHESLOTS;i++)
+	{
+		free (shiftslots[i].data);
+		shiftslots[i].data = NULL;
+		shiftslots[i].size = 0;
+		shiftslots[i].lastused = 0;
+	}
+	memset (shiftslotof,0,sizeof(shiftslotof));
+}
+
 #endif
 
 //===========================================================================
@@ -1156,9 +1203,14 @@ void CAL_CacheSprite (id0_int_t chunk, id0_char_t id0_far *compressed)
 	shiftstarts[3] = shiftstarts[2] + bigplane*5;
 	shiftstarts[4] = shiftstarts[3] + bigplane*5;	// nothing ever put here
 
-	expanded = shiftstarts[spr->shifts];
+//
+// (REFKEEN) the shifts aren't made here any more, CA_ShiftedSprite makes
+// them when needed. The tables are still set up as if they were there.
+//
+	expanded = shiftstarts[1];
 	MM_GetPtr (&grsegs[chunk],expanded);
 	dest = (spritetype id0_seg *)grsegs[chunk];
+	CA_ClearShiftedSprite (chunk);
 
 //
 // expand the unshifted shape
@@ -1166,7 +1218,7 @@ void CAL_CacheSprite (id0_int_t chunk, id0_char_t id0_far *compressed)
 	CAL_HuffExpand ((id0_byte_t *)compressed, &dest->data[0],smallplane*5,grhuffman);
 
 //
-// make the shifts!
+// set up the tables for the shifts
 //
 	switch (spr->shifts)
 	{
@@ -1192,10 +1244,6 @@ void CAL_CacheSprite (id0_int_t chunk, id0_char_t id0_far *compressed)
 			dest->planesize[i] = bigplane;
 			dest->width[i] = spr->width+1;
 		}
-		CAL_ShiftSprite ((id0_byte_t *)(grsegs[chunk])+dest->sourceoffset[0],
-			(id0_byte_t *)(grsegs[chunk])+dest->sourceoffset[2],spr->width,spr->height,4);
-		//CAL_ShiftSprite ((id0_unsigned_t)grsegs[chunk],dest->sourceoffset[0],
-		//	dest->sourceoffset[2],spr->width,spr->height,4);
 		break;
 
 	case	4:
@@ -1206,26 +1254,14 @@ void CAL_CacheSprite (id0_int_t chunk, id0_char_t id0_far *compressed)
 		dest->sourceoffset[1] = shiftstarts[1];
 		dest->planesize[1] = bigplane;
 		dest->width[1] = spr->width+1;
-		CAL_ShiftSprite ((id0_byte_t *)(grsegs[chunk])+dest->sourceoffset[0],
-			(id0_byte_t *)(grsegs[chunk])+dest->sourceoffset[1],spr->width,spr->height,2);
-		//CAL_ShiftSprite ((id0_unsigned_t)grsegs[chunk],dest->sourceoffset[0],
-		//	dest->sourceoffset[1],spr->width,spr->height,2);
 
 		dest->sourceoffset[2] = shiftstarts[2];
 		dest->planesize[2] = bigplane;
 		dest->width[2] = spr->width+1;
-		CAL_ShiftSprite ((id0_byte_t *)(grsegs[chunk])+dest->sourceoffset[0],
-			(id0_byte_t *)(grsegs[chunk])+dest->sourceoffset[2],spr->width,spr->height,4);
-		//CAL_ShiftSprite ((id0_unsigned_t)grsegs[chunk],dest->sourceoffset[0],
-		//	dest->sourceoffset[2],spr->width,spr->height,4);
 
 		dest->sourceoffset[3] = shiftstarts[3];
 		dest->planesize[3] = bigplane;
 		dest->width[3] = spr->width+1;
-		CAL_ShiftSprite ((id0_byte_t *)(grsegs[chunk])+dest->sourceoffset[0],
-			(id0_byte_t *)(grsegs[chunk])+dest->sourceoffset[3],spr->width,spr->height,6);
-		//CAL_ShiftSprite ((id0_unsigned_t)grsegs[chunk],dest->sourceoffset[0],
-		//	dest->sourceoffset[3],spr->width,spr->height,6);
 
 		break;
 
@@ -1397,13 +1433,18 @@ void CA_CacheGrChunk (id0_int_t chunk)
 	if (grsegs[chunk])
 	  return;							// allready in memory
 
+	BE_ST_ProfileEnter (BE_ST_PROFILE_CA);	// (REFKEEN) headless benchmark
+
 //
 // load the chunk into a buffer, either the miscbuffer if it fits, or allocate
 // a larger buffer
 //
 	pos = grstarts[chunk];
 	if (pos<0)							// $FFFFFFFF start is a sparse tile
+	{
+	  BE_ST_ProfileLeave ();
 	  return;
+	}
 
 	next = chunk +1;
 	while (grstarts[next] == -1)		// skip past any sparse tiles
@@ -1429,30 +1470,307 @@ void CA_CacheGrChunk (id0_int_t chunk)
 
 	if (compressed>BUFFERSIZE)
 		MM_FreePtr(&bigbufferseg);
+
+	BE_ST_ProfileLeave ();
 }
 
 
 
 //==========================================================================
 
+/*
+======================
+=
+= CAL_CacheMapHeader
+=
+= Loads the header of a map from the map file
+=
+======================
+*/
+
+void CAL_CacheMapHeader (id0_int_t mapnum)
+{
+	id0_long_t	pos;
+
+	pos = mapFile.headeroffsets[mapnum];
+	if (pos<0)						// $FFFFFFFF start is a sparse map
+	  Quit ("CA_CacheMap: Tried to load a non existant map!");
+
+	MM_GetPtr((memptr *)&mapheaderseg[mapnum],sizeof(maptype));
+	BE_Cross_seek(maphandle,pos,SEEK_SET);
+
+#ifdef MAPHEADERLINKED
+	// Preprocessor can't check if BUFFERSIZE < sizeof(maptype), so apply this trick found online...
+	((void)sizeof(char[1 - 2*!!(BUFFERSIZE < sizeof(maptype))]));
+#if 0
+#if BUFFERSIZE < sizeof(maptype)
+The general buffer size is too small!
+#endif
+#endif
+	//
+	// load in, then unhuffman to the destination
+	//        
+        CA_FarRead (maphandle,(id0_byte_t *)bufferseg, mapFile.headersize[mapnum]);
+        //CA_FarRead (maphandle,(id0_byte_t *)bufferseg,((mapfiletype	id0_seg *)tinf)->headersize[mapnum]);
+	CAL_HuffExpand ((id0_byte_t id0_huge *)bufferseg,
+		(id0_byte_t id0_huge *)mapheaderseg[mapnum],sizeof(maptype),maphuffman);
+#else
+	CA_FarRead (maphandle,(id0_byte_t *)((memptr)mapheaderseg[mapnum]),sizeof(maptype));
+	//CA_FarRead (maphandle,(memptr)mapheaderseg[mapnum],sizeof(maptype));
+#endif
+	// REFKEEN - Big Endian support
+#ifdef REFKEEN_ARCH_BIG_ENDIAN
+	mapheaderseg[mapnum]->planestart[0] = BE_Cross_Swap32LE(mapheaderseg[mapnum]->planestart[0]);
+	mapheaderseg[mapnum]->planestart[1] = BE_Cross_Swap32LE(mapheaderseg[mapnum]->planestart[1]);
+	mapheaderseg[mapnum]->planestart[2] = BE_Cross_Swap32LE(mapheaderseg[mapnum]->planestart[2]);
+	mapheaderseg[mapnum]->planelength[0] = BE_Cross_Swap16LE(mapheaderseg[mapnum]->planelength[0]);
+	mapheaderseg[mapnum]->planelength[1] = BE_Cross_Swap16LE(mapheaderseg[mapnum]->planelength[1]);
+	mapheaderseg[mapnum]->planelength[2] = BE_Cross_Swap16LE(mapheaderseg[mapnum]->planelength[2]);
+	mapheaderseg[mapnum]->width = BE_Cross_Swap16LE(mapheaderseg[mapnum]->width);
+	mapheaderseg[mapnum]->height = BE_Cross_Swap16LE(mapheaderseg[mapnum]->height);
+#endif
+}
+
+
+/*
+======================
+=
+= CAL_ExpandMapPlane
+=
+= Reads one plane of a map from the map file and decompresses it to dest,
+= which has to hold size bytes
+=
+======================
+*/
+
+void CAL_ExpandMapPlane (id0_int_t mapnum, id0_int_t plane,
+	id0_unsigned_t id0_far *dest, id0_unsigned_t size)
+{
+	id0_long_t	pos,compressed,expanded;
+	memptr	bigbufferseg,buffer2seg;
+	id0_unsigned_t	id0_far	*source;
+
+	pos = mapheaderseg[mapnum]->planestart[plane];
+	compressed = mapheaderseg[mapnum]->planelength[plane];
+        BE_Cross_seek(maphandle, pos, SEEK_SET);
+	if (compressed<=BUFFERSIZE)
+		source = (id0_unsigned_t *)bufferseg;
+	else
+	{
+		MM_GetPtr(&bigbufferseg,compressed);
+		source = (id0_unsigned_t *)bigbufferseg;
+	}
+
+	CA_FarRead(maphandle,(id0_byte_t id0_far *)source,compressed);
+#ifdef MAPHEADERLINKED
+	//
+	// unhuffman, then unRLEW
+	// The huffman'd chunk has a two byte expanded length first
+	// The resulting RLEW chunk also does, even though it's not really
+	// needed
+	//
+	expanded = BE_Cross_Swap16LE(*source); // REFKEEN - Big Endian support
+	//expanded = *source;
+	source++;
+	MM_GetPtr (&buffer2seg,expanded);
+	CAL_HuffExpand ((id0_byte_t id0_huge *)source,(id0_byte_t *)buffer2seg,expanded,maphuffman);
+	// REFKEEN - Big Endian support
+#ifdef REFKEEN_ARCH_BIG_ENDIAN
+	id0_unsigned_t id0_far * rlewunsignedptr = (id0_unsigned_t id0_far *)buffer2seg;
+	for (int i = 0; i < expanded/2; ++i, ++rlewunsignedptr)
+	{
+		*rlewunsignedptr = BE_Cross_Swap16LE(*rlewunsignedptr);
+	}
+#endif
+        CA_RLEWexpand (((id0_unsigned_t id0_far *)buffer2seg)+1,dest,size,mapFile.RLEWtag);
+        MM_FreePtr (&buffer2seg);
+
+#else
+	// REFKEEN - Big Endian support
+#ifdef REFKEEN_ARCH_BIG_ENDIAN
+	id0_unsigned_t id0_far * rlewunsignedptr = source;
+	for (int i = 0; i < compressed/2; ++i, ++rlewunsignedptr)
+	{
+		*rlewunsignedptr = BE_Cross_Swap16LE(*rlewunsignedptr);
+	}
+#endif
+	//
+	// unRLEW, skipping expanded length
+	//
+	CA_RLEWexpand (source+1, dest,size,
+	((mapfiletype id0_seg *)tinf)->RLEWtag);
+#endif
+
+	if (compressed>BUFFERSIZE)
+		MM_FreePtr(&bigbufferseg);
+}
+
+/*
+=============================================================================
+
+						(REFKEEN) MAP CACHE
+
+The planes of the last few maps are kept as they come out of the map file, in
+a fixed number of slots outside of the emulated memory. Entering one of them
+again only copies the planes, the game changes to mapsegs don't reach the
+copies. When all the slots are taken, the one used least recently is reused.
+
+=============================================================================
+*/
+
+#define MAPCACHESLOTS	4
+
+typedef struct
+{
+	id0_int_t		mapnum;
+	id0_longword_t	lastused;		// 0 if the slot is free
+	id0_unsigned_t	size;			// of one plane
+	id0_unsigned_t	*planes;		// all three planes, one after the other
+} mapslottype;
+
+static mapslottype	mapslots[MAPCACHESLOTS];
+static id0_longword_t	mapclock;
+
+
+/*
+======================
+=
+= CAL_CachedMap
+=
+= Returns the slot holding the planes of a map, or NULL
+=
+======================
+*/
+
+mapslottype *CAL_CachedMap (id0_int_t mapnum)
+{
+	id0_int_t i;
+
+	for (i=0;i<MAPCACHESLOTS;i++)
+		if (mapslots[i].lastused && mapslots[i].mapnum == mapnum)
+		{
+			mapslots[i].lastused = ++mapclock;
+			return &mapslots[i];
+		}
+
+	return NULL;
+}
+
+
+/*
+======================
+=
+= CAL_NewMapSlot
+=
+= Takes a free slot or the one unused for the longest time, and makes room
+= for three planes of size bytes
+=
+======================
+*/
+
+mapslottype *CAL_NewMapSlot (id0_int_t mapnum, id0_unsigned_t size)
+{
+	mapslottype *slot;
+	id0_int_t i;
+
+	slot = &mapslots[0];
+	for (i=1;i<MAPCACHESLOTS && slot->lastused;i++)
+		if (mapslots[i].lastused < slot->lastused)
+			slot = &mapslots[i];
+
+	if (slot->size < size)
+	{
+		free (slot->planes);
+		slot->planes = (id0_unsigned_t *)malloc (3*(size_t)size);
+		if (!slot->planes)
+			Quit ("CAL_NewMapSlot: Out of memory!");
+		slot->size = size;
+	}
+
+	slot->mapnum = mapnum;
+	slot->lastused = ++mapclock;
+
+	return slot;
+}
+
+
+/*
+======================
+=
+= CA_PrefetchMap
+=
+= Decompresses a map into the map cache, so CA_CacheMap only has to copy it
+= later on. Neither mapon nor mapsegs are changed
+=
+======================
+*/
+
+void CA_PrefetchMap (id0_int_t mapnum)
+{
+	mapslottype *slot;
+	id0_unsigned_t size;
+	id0_int_t plane;
+
+	if (mapnum<0 || mapnum>=NUMMAPS || mapFile.headeroffsets[mapnum]<0)
+		return;
+	if (CAL_CachedMap (mapnum))
+		return;
+
+	BE_ST_ProfileEnter (BE_ST_PROFILE_CA);
+
+	if (!mapheaderseg[mapnum])
+		CAL_CacheMapHeader (mapnum);
+	else
+		MM_SetPurge ((memptr *)&mapheaderseg[mapnum],0);
+
+	size = mapheaderseg[mapnum]->width * mapheaderseg[mapnum]->height * 2;
+	slot = CAL_NewMapSlot (mapnum,size);
+	for (plane=0;plane<3;plane++)
+		CAL_ExpandMapPlane (mapnum,plane,slot->planes+plane*(size/2),size);
+
+	if (mapnum != mapon)
+		MM_SetPurge ((memptr *)&mapheaderseg[mapnum],3);
+
+	BE_ST_ProfileLeave ();
+}
+
+
+void CAL_ShutdownMapCache (void)
+{
+	id0_int_t i;
+
+	for (i=0;i<MAPCACHESLOTS;i++)
+	{
+		free (mapslots[i].planes);
+		mapslots[i].planes = NULL;
+		mapslots[i].size = 0;
+		mapslots[i].lastused = 0;
+	}
+}
+
+//===========================================================================
+
 /*
 ======================
 =
 = CA_CacheMap
 =
+= (REFKEEN) Maps in the map cache are copied from there, the others are
+= added to it
+=
 ======================
 */
 
 
 void CA_CacheMap (id0_int_t mapnum)
 {
-	id0_long_t	pos,compressed,expanded;
 	id0_int_t		plane;
-	memptr	*dest,bigbufferseg,buffer2seg;
+	mapslottype	*slot;
 	id0_unsigned_t	size;
-	id0_unsigned_t	id0_far	*source;
 
 
+	BE_ST_ProfileEnter (BE_ST_PROFILE_CA);	// (REFKEEN) headless benchmark
+
 //
 // free up memory from last map
 //
@@ -1470,115 +1788,33 @@ void CA_CacheMap (id0_int_t mapnum)
 // The header will be cached if it is still around
 //
 	if (!mapheaderseg[mapnum])
-	{
-        pos = mapFile.headeroffsets[mapnum];
-		if (pos<0)						// $FFFFFFFF start is a sparse map
-		  Quit ("CA_CacheMap: Tried to load a non existant map!");
-
-		MM_GetPtr((memptr *)&mapheaderseg[mapnum],sizeof(maptype));
-		BE_Cross_seek(maphandle,pos,SEEK_SET);
-
-#ifdef MAPHEADERLINKED
-		// Preprocessor can't check if BUFFERSIZE < sizeof(maptype), so apply this trick found online...
-		((void)sizeof(char[1 - 2*!!(BUFFERSIZE < sizeof(maptype))]));
-#if 0
-#if BUFFERSIZE < sizeof(maptype)
-The general buffer size is too small!
-#endif
-#endif
-		//
-		// load in, then unhuffman to the destination
-		//        
-        CA_FarRead (maphandle,(id0_byte_t *)bufferseg, mapFile.headersize[mapnum]);
-        //CA_FarRead (maphandle,(id0_byte_t *)bufferseg,((mapfiletype	id0_seg *)tinf)->headersize[mapnum]);
-		CAL_HuffExpand ((id0_byte_t id0_huge *)bufferseg,
-			(id0_byte_t id0_huge *)mapheaderseg[mapnum],sizeof(maptype),maphuffman);
-#else
-		CA_FarRead (maphandle,(id0_byte_t *)((memptr)mapheaderseg[mapnum]),sizeof(maptype));
-		//CA_FarRead (maphandle,(memptr)mapheaderseg[mapnum],sizeof(maptype));
-#endif
-		// REFKEEN - Big Endian support
-#ifdef REFKEEN_ARCH_BIG_ENDIAN
-		mapheaderseg[mapnum]->planestart[0] = BE_Cross_Swap32LE(mapheaderseg[mapnum]->planestart[0]);
-		mapheaderseg[mapnum]->planestart[1] = BE_Cross_Swap32LE(mapheaderseg[mapnum]->planestart[1]);
-		mapheaderseg[mapnum]->planestart[2] = BE_Cross_Swap32LE(mapheaderseg[mapnum]->planestart[2]);
-		mapheaderseg[mapnum]->planelength[0] = BE_Cross_Swap16LE(mapheaderseg[mapnum]->planelength[0]);
-		mapheaderseg[mapnum]->planelength[1] = BE_Cross_Swap16LE(mapheaderseg[mapnum]->planelength[1]);
-		mapheaderseg[mapnum]->planelength[2] = BE_Cross_Swap16LE(mapheaderseg[mapnum]->planelength[2]);
-		mapheaderseg[mapnum]->width = BE_Cross_Swap16LE(mapheaderseg[mapnum]->width);
-		mapheaderseg[mapnum]->height = BE_Cross_Swap16LE(mapheaderseg[mapnum]->height);
-#endif
-	}
+		CAL_CacheMapHeader (mapnum);
 	else
 		MM_SetPurge ((memptr *)&mapheaderseg[mapnum],0);
 
 //
 // load the planes in
 // If a plane's pointer still exists it will be overwritten (levels are
-// allways reloaded, never cached)
+// allways reloaded, from the map cache if they are in it)
 //
 
 	size = mapheaderseg[mapnum]->width * mapheaderseg[mapnum]->height * 2;
 
 	for (plane = 0; plane<3; plane++)
-	{
-		dest = (memptr *)&mapsegs[plane];
-		MM_GetPtr(dest,size);
-
-		pos = mapheaderseg[mapnum]->planestart[plane];
-		compressed = mapheaderseg[mapnum]->planelength[plane];
-        BE_Cross_seek(maphandle, pos, SEEK_SET);
-		if (compressed<=BUFFERSIZE)
-			source = (id0_unsigned_t *)bufferseg;
-		else
-		{
-			MM_GetPtr(&bigbufferseg,compressed);
-			source = (id0_unsigned_t *)bigbufferseg;
-		}
+		MM_GetPtr((memptr *)&mapsegs[plane],size);
 
-		CA_FarRead(maphandle,(id0_byte_t id0_far *)source,compressed);
-#ifdef MAPHEADERLINKED
-		//
-		// unhuffman, then unRLEW
-		// The huffman'd chunk has a two byte expanded length first
-		// The resulting RLEW chunk also does, even though it's not really
-		// needed
-		//
-		expanded = BE_Cross_Swap16LE(*source); // REFKEEN - Big Endian support
-		//expanded = *source;
-		source++;
-		MM_GetPtr (&buffer2seg,expanded);
-		CAL_HuffExpand ((id0_byte_t id0_huge *)source,(id0_byte_t *)buffer2seg,expanded,maphuffman);
-		// REFKEEN - Big Endian support
-#ifdef REFKEEN_ARCH_BIG_ENDIAN
-		id0_unsigned_t id0_far * rlewunsignedptr = (id0_unsigned_t id0_far *)buffer2seg;
-		for (int i = 0; i < expanded/2; ++i, ++rlewunsignedptr)
-		{
-			*rlewunsignedptr = BE_Cross_Swap16LE(*rlewunsignedptr);
-		}
-#endif
-        CA_RLEWexpand (((id0_unsigned_t id0_far *)buffer2seg)+1,(id0_unsigned_t *)(*dest),size,mapFile.RLEWtag);
-        MM_FreePtr (&buffer2seg);
+	slot = CAL_CachedMap (mapnum);
+	if (!slot)
+	{
+		slot = CAL_NewMapSlot (mapnum,size);
+		for (plane = 0; plane<3; plane++)
+			CAL_ExpandMapPlane (mapnum,plane,slot->planes+plane*(size/2),size);
+	}
 
-#else
-		// REFKEEN - Big Endian support
-#ifdef REFKEEN_ARCH_BIG_ENDIAN
-		id0_unsigned_t id0_far * rlewunsignedptr = source;
-		for (int i = 0; i < compressed/2; ++i, ++rlewunsignedptr)
-		{
-			*rlewunsignedptr = BE_Cross_Swap16LE(*rlewunsignedptr);
-		}
-#endif
-		//
-		// unRLEW, skipping expanded length
-		//
-		CA_RLEWexpand (source+1, *dest,size,
-		((mapfiletype id0_seg *)tinf)->RLEWtag);
-#endif
+	for (plane = 0; plane<3; plane++)
+		memcpy (mapsegs[plane],slot->planes+plane*(size/2),size);
 
-		if (compressed>BUFFERSIZE)
-			MM_FreePtr(&bigbufferseg);
-	}
+	BE_ST_ProfileLeave ();
 }
 
 //===========================================================================
@@ -1705,6 +1941,8 @@ void CA_CacheMarks (const id0_char_t *title, id0_boolean_t cachedownlevel)
 	id0_byte_t	id0_far *source;
 	memptr	bigbufferseg;
 
+	BE_ST_ProfileEnter (BE_ST_PROFILE_CA);	// (REFKEEN) headless benchmark
+
 	//
 	// save title so cache down level can redraw it
 	//
@@ -1757,7 +1995,10 @@ void CA_CacheMarks (const id0_char_t *title, id0_boolean_t cachedownlevel)
 		}
 
 	if (!numcache)			// nothing to cache!
+	{
+		BE_ST_ProfileLeave ();
 		return;
+	}
 
 	if (dialog)
 	{
@@ -1900,6 +2141,8 @@ void CA_CacheMarks (const id0_char_t *title, id0_boolean_t cachedownlevel)
 			// (REFKEEN) And again...
             BE_ST_ShortSleep();
 		}
+
+	BE_ST_ProfileLeave ();
 }
 
 
@@ -66,6 +66,11 @@ typedef	struct
 	id0_char_t		name[16];
 } __attribute__((__packed__)) maptype;
 
+typedef struct
+{
+  id0_unsigned_t bit0,bit1;	// 0-255 is a character, > is a pointer to a node
+} __attribute__((__packed__)) huffnode;
+
 //===========================================================================
 
 //extern	id0_byte_t 		id0_seg	*tinf;
@@ -92,6 +97,16 @@ extern	BE_FILE_T			profilehandle;
 void CAL_ShiftSprite (id0_byte_t *source, id0_byte_t *dest,
 	id0_unsigned_t width, id0_unsigned_t height, id0_unsigned_t pixshift);
 
+// huffman expansion lives in id_ca_a.cpp
+
+void CAL_OptimizeNodes (huffnode *table);
+void CAL_HuffExpand (id0_byte_t *source, id0_byte_t *dest,
+  id0_long_t length, huffnode *hufftable);
+
+// (REFKEEN) shifted sprites are made when they're drawn the first time
+id0_byte_t *CA_ShiftedSprite (id0_int_t chunk, id0_unsigned_t pixshift);
+void CA_ClearShiftedSprite (id0_int_t chunk);
+
 //===========================================================================
 
 id0_boolean_t CA_FarRead (BE_FILE_T handle, id0_byte_t id0_far *dest, id0_long_t length);
@@ -120,6 +135,7 @@ void CA_ClearAllMarks (void);
 
 void CA_CacheGrChunk (id0_int_t chunk);
 void CA_CacheMap (id0_int_t mapnum);
+void CA_PrefetchMap (id0_int_t mapnum);	// (REFKEEN) into the map cache
 
 #ifdef REFKEEN_VER_KDREAMS_CGA_ALL
 void CA_CacheMarks (const id0_char_t *title);
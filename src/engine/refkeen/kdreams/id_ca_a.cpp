@@ -0,0 +1,226 @@
+/* Keen Dreams Source Code
+ * Copyright (C) 2014 Javier M. Chavez
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+extern "C"
+{
+
+
+#include "id_heads.h"
+
+//	Assembly portion of the Cache Mgr. The huffman expansion was inline
+//		assembly in ID_CA.C, it lives here so it can be built on its own
+//		(tools/RefKeenDecodeBench uses it)
+
+/*
+=============================================================================
+
+						 LOCAL CONSTANTS
+
+=============================================================================
+*/
+
+// (REFKEEN) The first HUFFLOOKBITS bits of a code are resolved with a single
+// table lookup instead of walking the tree bit by bit
+
+#define HUFFLOOKBITS	8
+#define HUFFLOOKSIZE	(1<<HUFFLOOKBITS)
+#define NUMHUFFDICTS	3		// graphics, map and audio dictionaries
+
+typedef struct
+{
+	id0_unsigned_t	code;	// 0-255 is a character, > is the node to go on from
+	id0_byte_t		bits;	// source bits used up to get there
+} hufflooktype;
+
+typedef struct
+{
+	huffnode		*table;
+	hufflooktype	look[HUFFLOOKSIZE];
+} huffdicttype;
+
+/*
+=============================================================================
+
+						 LOCAL VARIABLES
+
+=============================================================================
+*/
+
+static huffdicttype	huffdicts[NUMHUFFDICTS];
+static id0_int_t	nexthuffdict;
+
+//===========================================================================
+
+
+/*
+===============
+=
+= CAL_HuffDict
+=
+= Returns the lookup slot of a huffman table. If there is none yet, the
+= oldest slot is taken over and built is set to false
+=
+===============
+*/
+
+static huffdicttype *CAL_HuffDict (huffnode *table, id0_boolean_t *built)
+{
+	id0_int_t i;
+	huffdicttype *dict;
+
+	for (i=0;i<NUMHUFFDICTS;i++)
+		if (huffdicts[i].table == table)
+		{
+			*built = true;
+			return &huffdicts[i];
+		}
+
+	dict = &huffdicts[nexthuffdict];
+	nexthuffdict = (nexthuffdict+1)%NUMHUFFDICTS;
+	dict->table = table;
+	*built = false;
+	return dict;
+}
+
+
+/*
+===============
+=
+= CAL_BuildHuffLook
+=
+= Walks the tree once for every possible HUFFLOOKBITS bit pattern. Bits are
+= taken from the lowest one up, just like CAL_HuffExpand does
+=
+===============
+*/
+
+static void CAL_BuildHuffLook (huffdicttype *dict)
+{
+	id0_unsigned_t pattern,bit,code;
+	huffnode *nodeon;
+
+	for (pattern=0;pattern<HUFFLOOKSIZE;pattern++)
+	{
+		nodeon = dict->table+254;	// head node is always node 254
+		code = 256+254;
+		for (bit=0;bit<HUFFLOOKBITS;bit++)
+		{
+			code = (pattern & (1<<bit)) ? nodeon->bit1 : nodeon->bit0;
+			if (code < 256)
+				break;
+			nodeon = dict->table+(code-256);
+		}
+		dict->look[pattern].code = code;
+		dict->look[pattern].bits = (code < 256) ? bit+1 : HUFFLOOKBITS;
+	}
+}
+
+
+/*
+===============
+=
+= CAL_OptimizeNodes
+=
+= Goes through a huffman table and changes the 256-511 node numbers to the
+= actular address of the node.  Must be called before CAL_HuffExpand
+=
+= (REFKEEN) Node numbers are kept as they are, the lookup table for the
+= first bits of every code is built instead
+=
+===============
+*/
+
+void CAL_OptimizeNodes (huffnode *table)
+{
+	id0_boolean_t built;
+
+	CAL_BuildHuffLook (CAL_HuffDict (table,&built));
+}
+
+
+
+/*
+======================
+=
+= CAL_HuffExpand
+=
+= Length is the length of the EXPANDED data
+=
+= (REFKEEN) Source bits are collected in a bit buffer, a byte is only
+= loaded when the code being decoded really needs it. So the source is
+= never read further than with the original bit by bit expansion
+=
+======================
+*/
+
+void CAL_HuffExpand (id0_byte_t *source, id0_byte_t *dest,
+  id0_long_t length, huffnode *hufftable)
+{
+	id0_unsigned_t code;
+	huffnode *nodeon;
+	huffdicttype *dict;
+	hufflooktype *look;
+	id0_boolean_t built;
+
+	id0_unsigned_long_t bitbuf = 0;	// unused bits, the next one is the lowest
+	id0_unsigned_t bitcount = 0;
+
+	id0_byte_t id0_huge *srcptr = source, *dstptr = dest, *dstendptr = dest+length;
+
+	dict = CAL_HuffDict (hufftable,&built);
+	if (!built)
+		CAL_BuildHuffLook (dict);
+
+	//------------
+	// expand data
+	//------------
+
+	while (dstptr < dstendptr)
+	{
+		// bits above bitcount are zero, so a short code can already be
+		// looked up before the rest of the pattern is loaded
+		look = &dict->look[bitbuf & (HUFFLOOKSIZE-1)];
+		if (look->bits > bitcount)
+		{
+			bitbuf |= (id0_unsigned_long_t)*(srcptr++) << bitcount;
+			bitcount += 8;
+			continue;
+		}
+		bitbuf >>= look->bits;
+		bitcount -= look->bits;
+		code = look->code;
+
+		// codes longer than the table go on bit by bit
+		while (code >= 256)
+		{
+			if (!bitcount)
+			{
+				bitbuf = *(srcptr++);
+				bitcount = 8;
+			}
+			nodeon = hufftable + (code-256);
+			code = (bitbuf & 1) ? nodeon->bit1 : nodeon->bit0;
+			bitbuf >>= 1;
+			bitcount--;
+		}
+
+		*(dstptr++) = code; // write a decompressed byte out
+	}
+}
+
+}
@@ -74,13 +74,22 @@ typedef struct mmblockstruct
 	id0_unsigned_t	attributes;
 	memptr		*useptr;	// pointer to the segment start
 	struct mmblockstruct id0_far *next;
+	// (REFKEEN) The block in front of this one, and the free list
+	// which the gap behind this block (if any) is linked into
+	struct mmblockstruct id0_far *prev;
+	struct mmblockstruct id0_far *gapnext,id0_far *gapprev;
+	id0_int_t	gapclass;	// -1 if there's no gap behind the block
 } mmblocktype;
 
+// (REFKEEN) Free gaps are sorted into lists by the highest set bit of
+// their length in paragraphs, so fitting space is found without a scan
+#define MMGAPCLASSES	16
+
 
 /*#define GETNEWBLOCK {if(!(mmnew=mmfree))Quit("MM_GETNEWBLOCK: No free blocks!")\
     ;mmfree=mmfree->next;}*/
 
-#define FREEBLOCK(x) {*x->useptr=NULL;x->next=mmfree;mmfree=x;}
+#define FREEBLOCK(x) {MML_ForgetBlock(x);*x->useptr=NULL;x->next=mmfree;mmfree=x;}
 
 /*
 =============================================================================
@@ -91,6 +100,7 @@ typedef struct mmblockstruct
 */
 
 mminfotype	mminfo;
+mmstatstype	mmstats;
 memptr		bufferseg;
 id0_boolean_t		bombonerror;
 
@@ -113,6 +123,9 @@ id0_boolean_t		mmstarted;
 mmblocktype	id0_far mmblocks[MAXBLOCKS]
 			,id0_far *mmhead,id0_far *mmfree,id0_far *mmrover,id0_far *mmnew;
 
+static mmblocktype id0_far *mmgaps[MMGAPCLASSES];
+static id0_unsigned_long_t mmgapmask;	// bit set for each non-empty list in mmgaps
+
 // A static memory buffer used for our allocations, made out of 16-bytes
 // long paragraphs (each of them beginning with some emulated "segment")
 //
@@ -138,10 +151,15 @@ mmblocktype	id0_far mmblocks[MAXBLOCKS]
 #define EMULATED_FAR_PARAGRAPHS 28037
 #define EMULATED_EMS_PARAGRAPHS 0 // Yes!
 #define EMULATED_XMS_PARAGRAPHS 4095
+#define EMULATED_TOTAL_PARAGRAPHS (EMULATED_FIRST_PARAGRAPHS+EMULATED_NEAR_PARAGRAPHS+EMULATED_FAR_PARAGRAPHS+EMULATED_EMS_PARAGRAPHS+EMULATED_XMS_PARAGRAPHS)
 // Used to obtain a pointer to some location in mmEmulatedMemSpace
 #define EMULATED_SEG_TO_PTR(seg) (mmEmulatedMemSpace+(seg)*16)
 
-static id0_byte_t mmEmulatedMemSpace[16*(EMULATED_FIRST_PARAGRAPHS+EMULATED_NEAR_PARAGRAPHS+EMULATED_FAR_PARAGRAPHS+EMULATED_EMS_PARAGRAPHS+EMULATED_XMS_PARAGRAPHS)];
+static id0_byte_t mmEmulatedMemSpace[16*EMULATED_TOTAL_PARAGRAPHS];
+
+// (REFKEEN) For each segment, 1 + the index of the block starting there
+// (0 if none), so a block is found from the pointer without walking the list
+static id0_unsigned_t mmblockatseg[EMULATED_TOTAL_PARAGRAPHS];
 
 //==========================================================================
 
@@ -155,6 +173,179 @@ static id0_byte_t mmEmulatedMemSpace[16*(EMULATED_FIRST_PARAGRAPHS+EMULATED_NEAR
 //id0_boolean_t 	MML_CheckForXMS (void);
 //void 		MML_ShutdownXMS (void);
 
+/*
+=============================================================================
+
+				(REFKEEN) FREE LISTS AND BLOCK LOOKUP
+
+=============================================================================
+*/
+
+static id0_int_t MML_GapClass (id0_unsigned_t length)
+{
+	id0_int_t gapclass = 0;
+
+	while (length >>= 1)
+		gapclass++;
+	return gapclass;
+}
+
+static id0_unsigned_t MML_GapBehind (mmblocktype id0_far *block)
+{
+	return block->next ? block->next->start - (block->start + block->length) : 0;
+}
+
+static void MML_UnlinkGap (mmblocktype id0_far *block)
+{
+	if (block->gapclass < 0)
+		return;
+
+	if (block->gapprev)
+		block->gapprev->gapnext = block->gapnext;
+	else
+	{
+		mmgaps[block->gapclass] = block->gapnext;
+		if (!block->gapnext)
+			mmgapmask &= ~(1ul<<block->gapclass);
+	}
+	if (block->gapnext)
+		block->gapnext->gapprev = block->gapprev;
+
+	block->gapclass = -1;
+}
+
+// Puts the gap behind the block into the list it belongs to now
+static void MML_LinkGap (mmblocktype id0_far *block)
+{
+	id0_unsigned_t gap;
+
+	MML_UnlinkGap (block);
+
+	gap = MML_GapBehind (block);
+	if (!gap)
+		return;
+
+	block->gapclass = MML_GapClass (gap);
+	block->gapprev = NULL;
+	block->gapnext = mmgaps[block->gapclass];
+	if (block->gapnext)
+		block->gapnext->gapprev = block;
+	mmgaps[block->gapclass] = block;
+	mmgapmask |= 1ul<<block->gapclass;
+}
+
+static void MML_IndexBlock (mmblocktype id0_far *block)
+{
+	// Zero length blocks share their segment with the next block, so leave them out
+	if (block->length && (block->start < EMULATED_TOTAL_PARAGRAPHS))
+		mmblockatseg[block->start] = (block-mmblocks)+1;
+}
+
+// Takes a block which is about to be freed out of the lists and the index
+static void MML_ForgetBlock (mmblocktype id0_far *block)
+{
+	MML_UnlinkGap (block);
+	if ((block->start < EMULATED_TOTAL_PARAGRAPHS) && (mmblockatseg[block->start] == (block-mmblocks)+1))
+		mmblockatseg[block->start] = 0;
+}
+
+// Sets up the back links, free lists and index from the block list
+static void MML_RebuildIndex (void)
+{
+	mmblocktype id0_far *scan,id0_far *last;
+
+	memset (mmgaps,0,sizeof(mmgaps));
+	mmgapmask = 0;
+	memset (mmblockatseg,0,sizeof(mmblockatseg));
+
+	last = NULL;
+	for (scan = mmhead; scan; scan = scan->next)
+	{
+		scan->prev = last;
+		scan->gapclass = -1;
+		MML_IndexBlock (scan);
+		last = scan;
+	}
+
+	for (scan = mmhead; scan; scan = scan->next)
+		MML_LinkGap (scan);
+}
+
+// Links the block in behind last, it must already fit into the gap there
+static void MML_InsertBlock (mmblocktype id0_far *last, mmblocktype id0_far *block)
+{
+	block->next = last->next;
+	block->prev = last;
+	if (block->next)
+		block->next->prev = block;
+	last->next = block;
+
+	block->gapclass = -1;
+	MML_IndexBlock (block);
+	MML_LinkGap (last);
+	MML_LinkGap (block);
+}
+
+static void MML_RemoveBlock (mmblocktype id0_far *block)
+{
+	mmblocktype id0_far *last = block->prev;
+
+	last->next = block->next;
+	if (block->next)
+		block->next->prev = last;
+
+	FREEBLOCK(block);
+	MML_LinkGap (last);
+}
+
+static mmblocktype id0_far *MML_FindBlock (memptr *baseptr)
+{
+	mmblocktype id0_far *scan;
+	id0_byte_t *ptr = (id0_byte_t *)*baseptr;
+	id0_unsigned_t index;
+
+	if ((ptr >= mmEmulatedMemSpace) && (ptr < mmEmulatedMemSpace+sizeof(mmEmulatedMemSpace)))
+	{
+		index = mmblockatseg[(ptr-mmEmulatedMemSpace)/16];
+		if (index && (mmblocks[index-1].useptr == baseptr))
+			return &mmblocks[index-1];
+	}
+
+	// The pointer doesn't lead to the block (e.g. a zero length one), so walk the list
+	for (scan = mmhead->next; scan; scan = scan->next)
+		if (scan->useptr == baseptr)
+			return scan;
+
+	return NULL;
+}
+
+// Returns the block with a free gap of at least needed paragraphs behind it
+static mmblocktype id0_far *MML_FindGap (id0_unsigned_t needed)
+{
+	mmblocktype id0_far *scan;
+	id0_unsigned_long_t larger;
+	id0_int_t gapclass;
+
+	gapclass = MML_GapClass (needed);
+
+	// any gap of a higher class is large enough, so take one of the lowest of them
+	larger = mmgapmask & ~((2ul<<gapclass)-1);
+	if (larger)
+	{
+		gapclass = 0;
+		while (!(larger & (1ul<<gapclass)))
+			gapclass++;
+		return mmgaps[gapclass];
+	}
+
+	// only some of the gaps in the same class may be large enough
+	for (scan = mmgaps[gapclass]; scan; scan = scan->gapnext)
+		if (MML_GapBehind (scan) >= needed)
+			return scan;
+
+	return NULL;
+}
+
 //==========================================================================
 
 #if 0
@@ -297,6 +488,7 @@ void MM_Startup (void)
 
 	mmstarted = true;
 	bombonerror = true;
+	memset (&mmstats,0,sizeof(mmstats));
 
 //
 // set up the linked list (everything in the free list)
@@ -434,6 +626,7 @@ void MM_Startup (void)
 // allocate the misc buffer
 //
 	mmrover = mmhead;		// start looking for space after low block
+	MML_RebuildIndex ();
 
 	MM_GetPtr (&bufferseg,BUFFERSIZE);
 }
@@ -493,6 +686,24 @@ void MM_GetPtr (memptr *baseptr,id0_unsigned_long_t size)
 	mmnew->length = needed;
 	mmnew->useptr = baseptr;
 	mmnew->attributes = BASEATTRIBUTES;
+	mmnew->gapclass = -1;
+
+	mmstats.getptrs++;
+
+	//
+	// (REFKEEN) first try the free lists, that never throws anything out
+	//
+	if (needed && (lastscan = MML_FindGap (needed)) != NULL)
+	{
+		mmnew->start = lastscan->start + lastscan->length;
+		*baseptr = EMULATED_SEG_TO_PTR(mmnew->start);
+		MML_InsertBlock (lastscan,mmnew);
+		mmrover = mmnew;
+		mmstats.fastallocs++;
+		return;
+	}
+
+	mmstats.slowallocs++;
 
 	for (search = 0; search<3; search++)
 	{
@@ -503,6 +714,11 @@ void MM_GetPtr (memptr *baseptr,id0_unsigned_long_t size)
 		if (search == 1 && mmrover == mmhead)
 			search++;
 
+		// (REFKEEN) compressing is slow and can't help if there isn't
+		// enough space even after purging everything
+		if (search == 2 && MM_TotalFree() < needed*16l)
+			break;
+
 		switch (search)
 		{
 		case 0:
@@ -535,16 +751,18 @@ void MM_GetPtr (memptr *baseptr,id0_unsigned_long_t size)
 			// and allocate the new block
 			//
 				purge = lastscan->next;
-				lastscan->next = mmnew;
+				lastscan->next = scan;
+				scan->prev = lastscan;
                 mmnew->start = startseg;
 				*baseptr = EMULATED_SEG_TO_PTR(startseg);
-				mmnew->next = scan;
 				while ( purge != scan)
 				{	// free the purgable block
 					next = purge->next;
 					FREEBLOCK(purge);
+					mmstats.purgedblocks++;
 					purge = next;		// purge another if not at scan
 				}
+				MML_InsertBlock (lastscan,mmnew);
 				mmrover = mmnew;
 				return;	// good allocation!
 			}
@@ -585,26 +803,19 @@ void MM_GetPtr (memptr *baseptr,id0_unsigned_long_t size)
 
 void MM_FreePtr (memptr *baseptr)
 {
-	mmblocktype id0_far *scan,id0_far *last;
+	mmblocktype id0_far *scan;
 
-	last = mmhead;
-	scan = last->next;
+	mmstats.freeptrs++;
 
 	if (baseptr == mmrover->useptr)	// removed the last allocated block
 		mmrover = mmhead;
 
-	while (scan->useptr != baseptr && scan)
-	{
-		last = scan;
-		scan = scan->next;
-	}
+	scan = MML_FindBlock (baseptr);
 
 	if (!scan)
 		Quit ("MM_FreePtr: Block not found!");
 
-	last->next = scan->next;
-
-	FREEBLOCK(scan);
+	MML_RemoveBlock (scan);
 }
 //==========================================================================
 
@@ -620,24 +831,14 @@ void MM_FreePtr (memptr *baseptr)
 
 void MM_SetPurge (memptr *baseptr, id0_int_t purge)
 {
-	mmblocktype id0_far *start;
-
-	start = mmrover;
-
-	do
-	{
-		if (mmrover->useptr == baseptr)
-			break;
-
-		mmrover = mmrover->next;
+	mmblocktype id0_far *block;
 
-		if (!mmrover)
-			mmrover = mmhead;
-		else if (mmrover == start)
-			Quit ("MM_SetPurge: Block not found!");
+	block = MML_FindBlock (baseptr);
 
-	} while (1);
+	if (!block)
+		Quit ("MM_SetPurge: Block not found!");
 
+	mmrover = block;
 	mmrover->attributes &= ~PURGEBITS;
 	mmrover->attributes |= purge;
 }
@@ -656,24 +857,14 @@ void MM_SetPurge (memptr *baseptr, id0_int_t purge)
 
 void MM_SetLock (memptr *baseptr, id0_boolean_t locked)
 {
-	mmblocktype id0_far *start;
-
-	start = mmrover;
-
-	do
-	{
-		if (mmrover->useptr == baseptr)
-			break;
+	mmblocktype id0_far *block;
 
-		mmrover = mmrover->next;
+	block = MML_FindBlock (baseptr);
 
-		if (!mmrover)
-			mmrover = mmhead;
-		else if (mmrover == start)
-			Quit ("MM_SetLock: Block not found!");
-
-	} while (1);
+	if (!block)
+		Quit ("MM_SetLock: Block not found!");
 
+	mmrover = block;
 	mmrover->attributes &= ~LOCKBIT;
 	mmrover->attributes |= locked*LOCKBIT;
 }
@@ -702,6 +893,8 @@ void MM_SortMem (void)
 	if (beforesort)
 		beforesort();
 
+	mmstats.sorts++;
+
 	scan = mmhead;
 
 	while (scan)
@@ -722,6 +915,7 @@ void MM_SortMem (void)
 			//
 				next = scan->next;
 				FREEBLOCK(scan);
+				mmstats.purgedblocks++;
 				last->next = next;
 				scan = next;
 				continue;
@@ -734,6 +928,7 @@ void MM_SortMem (void)
 				if (scan->start != start)
 				{
 					length = scan->length;
+					mmstats.movedbytes += length*16l;
 					source = scan->start;
 					dest = start;
 					while (length > 0xf00)
@@ -760,6 +955,7 @@ void MM_SortMem (void)
 	}
 
 	mmrover = mmhead;
+	MML_RebuildIndex ();
 
 	if (aftersort)
 		aftersort();
@@ -883,4 +1079,40 @@ id0_long_t MM_TotalFree (void)
 	return free*16l;
 }
 
+//==========================================================================
+
+
+/*
+======================
+=
+= MM_LargestFree
+=
+= (REFKEEN) Returns the largest block which can be allocated without purging
+=
+======================
+*/
+
+id0_long_t MM_LargestFree (void)
+{
+	id0_unsigned_t gap,largest;
+	id0_int_t gapclass;
+	mmblocktype id0_far *scan;
+
+	largest = 0;
+
+	for (gapclass = MMGAPCLASSES-1; gapclass >= 0; gapclass--)
+		if (mmgapmask & (1ul<<gapclass))
+			break;
+
+	if (gapclass >= 0)
+		for (scan = mmgaps[gapclass]; scan; scan = scan->gapnext)
+		{
+			gap = MML_GapBehind (scan);
+			if (gap > largest)
+				largest = gap;
+		}
+
+	return largest*16l;
+}
+
 }
@@ -49,9 +49,21 @@ typedef struct
 	id0_long_t	nearheap,farheap,EMSmem,XMSmem,mainmem;
 } mminfotype;
 
+// (REFKEEN) Counters to see how the memory manager is doing,
+// e.g. whether loading a level had to compress the memory
+typedef struct
+{
+	id0_unsigned_long_t	getptrs,freeptrs;
+	id0_unsigned_long_t	fastallocs;		// taken right from a free list
+	id0_unsigned_long_t	slowallocs;		// had to scan, purge or compress
+	id0_unsigned_long_t	sorts;			// calls to MM_SortMem
+	id0_unsigned_long_t	purgedblocks,movedbytes;
+} mmstatstype;
+
 //==========================================================================
 
 extern	mminfotype	mminfo;
+extern	mmstatstype	mmstats;
 extern	memptr		bufferseg;
 extern	id0_boolean_t		bombonerror;
 
@@ -75,6 +87,7 @@ void MM_ShowMemory (void);
 
 id0_long_t MM_UnusedMemory (void);
 id0_long_t MM_TotalFree (void);
+id0_long_t MM_LargestFree (void);
 
 
 #endif
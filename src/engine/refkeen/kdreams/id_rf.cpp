@@ -105,6 +105,7 @@ typedef	struct spriteliststruct
 
 	id0_unsigned_t	grseg,sourceofs,planesize;
 	drawtype	draw;
+	id0_unsigned_t	shift;			// (REFKEEN) EGA only, drawn by VW_MaskSprite
 	id0_unsigned_t	tilex,tiley,tilewide,tilehigh;
 	id0_int_t			priority,updatecount;
 	struct spriteliststruct **prevptr,*nextsprite;
@@ -129,6 +130,7 @@ typedef struct animtilestruct
 	tiletype	*chain;
 	id0_unsigned_t	id0_far *mapplane;
 	struct animtilestruct **prevptr,*nexttile;
+	struct animtilestruct **chainprevptr,*chainnext;	// (REFKEEN) tiles of the same chain
 } __attribute__((__packed__)) animtiletype;
 
 /*
@@ -199,6 +201,19 @@ id0_byte_t		*updateptr,*baseupdateptr,						// current start of update window
 tiletype	allanims[MAXANIMTYPES];
 id0_unsigned_t	numanimchains;
 
+// (REFKEEN) The chains are kept in a heap ordered by the time they change next,
+// so a refresh only looks at the chains which are due. Only the tiles of the
+// chains which have changed are checked for a new state.
+id0_long_t		animclock;
+id0_long_t		animdue[MAXANIMTYPES];
+id0_byte_t		animqueue[MAXANIMTYPES];
+id0_int_t		animqueuesize;
+
+animtiletype	*animchainheads[MAXANIMTYPES];
+id0_boolean_t	animchaindirty[MAXANIMTYPES];
+id0_byte_t		dirtychains[MAXANIMTYPES];
+id0_int_t		numdirtychains;
+
 void 		(*refreshvector) (void);
 
 id0_unsigned_t	screenstart[3] =
@@ -238,6 +253,7 @@ void RFL_CalcOriginStuff (id0_long_t x, id0_long_t y);
 void RFL_InitSpriteList (void);
 void RFL_InitAnimList (void);
 void RFL_CheckForAnimTile (id0_unsigned_t x, id0_unsigned_t y);
+void RFL_InitAnimQueue (void);
 void RFL_AnimateTiles (void);
 void RFL_RemoveAnimsOnX (id0_unsigned_t x);
 void RFL_RemoveAnimsOnY (id0_unsigned_t y);
@@ -548,6 +564,8 @@ nextback:
 nextfront:
 		info++;
 	} while (start<end);
+
+	RFL_InitAnimQueue ();
 }
 
 
@@ -577,6 +595,144 @@ void RFL_InitAnimList (void)
 	animarray[i].nexttile = NULL;
 
 	animhead = NULL;			// nothing in list
+
+	memset (animchainheads,0,sizeof(animchainheads));
+	memset (animchaindirty,0,sizeof(animchaindirty));
+	numdirtychains = 0;
+}
+
+
+/*
+=========================
+=
+= RFL_SiftAnimDown
+=
+= Moves the chain at the given heap position down until no chain below is
+= due earlier
+=
+=========================
+*/
+
+void RFL_SiftAnimDown (id0_int_t pos)
+{
+	id0_int_t	child;
+	id0_byte_t	chain;
+
+	chain = animqueue[pos];
+
+	while ((child = 2*pos+1) < animqueuesize)
+	{
+		if (child+1 < animqueuesize && animdue[animqueue[child+1]] < animdue[animqueue[child]])
+			child++;
+		if (animdue[animqueue[child]] >= animdue[chain])
+			break;
+		animqueue[pos] = animqueue[child];
+		pos = child;
+	}
+
+	animqueue[pos] = chain;
+}
+
+
+/*
+=========================
+=
+= RFL_InitAnimQueue
+=
+= Puts all the chains found by RF_MarkTileGraphics into the queue
+=
+=========================
+*/
+
+void RFL_InitAnimQueue (void)
+{
+	id0_int_t	i;
+
+	animclock = 0;
+	animqueuesize = 0;
+
+	for (i=0;i<MAXANIMTYPES && allanims[i].current;i++)
+	{
+		animdue[i] = allanims[i].count;
+		animqueue[animqueuesize++] = i;
+	}
+
+	for (i=animqueuesize/2-1;i>=0;i--)
+		RFL_SiftAnimDown (i);
+}
+
+
+/*
+=========================
+=
+= RFL_MarkAnimChain
+=
+= The tiles of the chain will be checked by the next RFL_AnimateTiles
+=
+=========================
+*/
+
+void RFL_MarkAnimChain (id0_int_t chain)
+{
+	if (animchaindirty[chain])
+		return;
+	animchaindirty[chain] = true;
+	dirtychains[numdirtychains++] = chain;
+}
+
+
+/*
+=========================
+=
+= RFL_LinkAnimTile
+=
+= Adds a new tile to the list of its chain
+=
+=========================
+*/
+
+void RFL_LinkAnimTile (animtiletype *anim)
+{
+	id0_int_t	chain;
+	animtiletype	*next;
+
+	chain = anim->chain - allanims;
+
+	next = animchainheads[chain];
+	animchainheads[chain] = anim;
+	if (next)
+		next->chainprevptr = &anim->chainnext;
+	anim->chainnext = next;
+	anim->chainprevptr = &animchainheads[chain];
+
+	// the map may still hold an older state of the chain
+	if (anim->tile != anim->chain->current)
+		RFL_MarkAnimChain (chain);
+}
+
+
+/*
+=========================
+=
+= RFL_FreeAnimTile
+=
+= Takes the tile out of both lists and returns it to the free list
+=
+=========================
+*/
+
+void RFL_FreeAnimTile (animtiletype *anim)
+{
+	*(void **)anim->prevptr = anim->nexttile;
+	if (anim->nexttile)
+		anim->nexttile->prevptr = anim->prevptr;
+
+	*(void **)anim->chainprevptr = anim->chainnext;
+	if (anim->chainnext)
+		anim->chainnext->chainprevptr = anim->chainprevptr;
+
+	anim->nexttile = animfreeptr;
+	animfreeptr = anim;
 }
 
 
@@ -623,6 +779,7 @@ void RFL_CheckForAnimTile (id0_unsigned_t x, id0_unsigned_t y)
 		anim->mapplane = map;
 		anim->chain = &allanims[COMPAT_ALLANIMS_CONVERT_DOS_PTR_TO_INDEX(*(mapsegs[2]+offset))];
 		//anim->chain = (tiletype *)*(mapsegs[2]+offset);
+		RFL_LinkAnimTile (anim);
 	}
 
 //
@@ -649,6 +806,7 @@ void RFL_CheckForAnimTile (id0_unsigned_t x, id0_unsigned_t y)
 		anim->mapplane = map;
 		anim->chain = &allanims[COMPAT_ALLANIMS_CONVERT_DOS_PTR_TO_INDEX(*(mapsegs[2]+offset))];
 		//anim->chain = (tiletype *)*(mapsegs[2]+offset);
+		RFL_LinkAnimTile (anim);
 	}
 
 }
@@ -671,12 +829,8 @@ void RFL_RemoveAnimsOnX (id0_unsigned_t x)
 	{
 		if (current->x == x)
 		{
-			*(void **)current->prevptr = current->nexttile;
-			if (current->nexttile)
-				current->nexttile->prevptr = current->prevptr;
 			next = current->nexttile;
-			current->nexttile = animfreeptr;
-			animfreeptr = current;
+			RFL_FreeAnimTile (current);
 			current = next;
 		}
 		else
@@ -702,12 +856,8 @@ void RFL_RemoveAnimsOnY (id0_unsigned_t y)
 	{
 		if (current->y == y)
 		{
-			*(void **)current->prevptr = current->nexttile;
-			if (current->nexttile)
-				current->nexttile->prevptr = current->prevptr;
 			next = current->nexttile;
-			current->nexttile = animfreeptr;
-			animfreeptr = current;
+			RFL_FreeAnimTile (current);
 			current = next;
 		}
 		else
@@ -729,70 +879,82 @@ void RFL_AnimateTiles (void)
 	animtiletype *current;
 	id0_unsigned_t	updateofs,tile,x,y;
 	tiletype	*anim;
+	id0_int_t	chain,i;
 
 //
-// animate the lists of tiles
+// animate the chains which are due
 //
-	anim = &allanims[0];
-	while (anim->current)
+	animclock += tics;
+
+	while (animqueuesize && animdue[animqueue[0]] <= animclock)
 	{
-		anim->count-=tics;
-		while ( anim->count < 1)
+		chain = animqueue[0];
+		anim = &allanims[chain];
+		while (animdue[chain] <= animclock)
 		{
 			if (anim->current & 0x8000)
 			{
 				tile = anim->current & 0x7fff;
                 tile += (id0_signed_char_t)mapFile.tileinfo[MANIM+tile];
-                anim->count += mapFile.tileinfo[MSPEED+tile];
+                animdue[chain] += mapFile.tileinfo[MSPEED+tile];
 				tile |= 0x8000;
 			}
 			else
 			{
 				tile = anim->current;
                 tile += (id0_signed_char_t)mapFile.tileinfo[ANIM+tile];
-                anim->count += mapFile.tileinfo[tile];
+                animdue[chain] += mapFile.tileinfo[tile];
 			}
 			anim->current = tile;
 		}
-		anim++;
-	}
+		anim->count = animdue[chain]-animclock;
 
+		RFL_MarkAnimChain (chain);
+		RFL_SiftAnimDown (0);
+	}
 
 //
-// traverse the list of animating tiles
+// traverse the tiles of the chains which have changed
 //
-	current = animhead;
-	while (current)
+	for (i=0;i<numdirtychains;i++)
 	{
-		tile =current->chain->current;
-		if ( tile != current->tile)
+		chain = dirtychains[i];
+		animchaindirty[chain] = false;
+
+		current = animchainheads[chain];
+		while (current)
 		{
-		// tile has animated
-		//
-		// remove tile from master screen cache,
-		// change a tile to its next state, set the structure up for
-		// next animation, and post an update region to both update pages
-		//
-			current->tile = tile;
+			tile =current->chain->current;
+			if ( tile != current->tile)
+			{
+			// tile has animated
+			//
+			// remove tile from master screen cache,
+			// change a tile to its next state, set the structure up for
+			// next animation, and post an update region to both update pages
+			//
+				current->tile = tile;
 
-			*(current->mapplane) = tile & 0x7fff; 		// change in map
+				*(current->mapplane) = tile & 0x7fff; 		// change in map
 
 #if GRMODE == EGAGR
-			if (tile<0x8000)		// background
-				tilecache[tile] = 0;
+				if (tile<0x8000)		// background
+					tilecache[tile] = 0;
 #endif
 
-			x = current->x-originxtile;
-			y = current->y-originytile;
+				x = current->x-originxtile;
+				y = current->y-originytile;
 
-			if (x>=PORTTILESWIDE || y>=PORTTILESHIGH)
-				Quit ("RFL_AnimateTiles: Out of bounds!");
+				if (x>=PORTTILESWIDE || y>=PORTTILESHIGH)
+					Quit ("RFL_AnimateTiles: Out of bounds!");
 
-			updateofs = uwidthtable[y] + x;
-			RFL_NewTile(updateofs);				// puts "1"s in both pages
+				updateofs = uwidthtable[y] + x;
+				RFL_NewTile(updateofs);				// puts "1"s in both pages
+			}
+			current = current->chainnext;
 		}
-		current = current->nexttile;
 	}
+	numdirtychains = 0;
 }
 
 
@@ -1119,6 +1281,8 @@ void RF_Scroll (id0_int_t x, id0_int_t y)
 	id0_unsigned_t	oldpanx,oldpanadjust,oldoriginmap,oldscreen,newscreen,screencopy;
 	id0_int_t			screenmove;
 
+	BE_ST_ProfileEnter (BE_ST_PROFILE_RF);	// (REFKEEN) headless benchmark
+
 	oldxt = originxtile;
 	oldyt = originytile;
 	oldoriginmap = originmap;
@@ -1138,11 +1302,15 @@ void RF_Scroll (id0_int_t x, id0_int_t y)
 	// scrolled more than one tile, so start from scratch
 	//
 		RF_NewPosition(originxglobal,originyglobal);
+		BE_ST_ProfileLeave ();
 		return;
 	}
 
 	if (!absdx && !absdy)
+	{
+		BE_ST_ProfileLeave ();
 		return;					// the screen has not scrolled an entire tile
+	}
 
 
 //
@@ -1252,6 +1420,8 @@ void RF_Scroll (id0_int_t x, id0_int_t y)
 
     memcpy(update0, &UPDATETERMINATE, sizeof(id0_unsigned_t));
     memcpy(update1, &UPDATETERMINATE, sizeof(id0_unsigned_t));
+
+	BE_ST_ProfileLeave ();
 }
 
 //===========================================================================
@@ -1343,6 +1513,7 @@ linknewspot:
 	sprite->width = block->width[shift];
 	sprite->height = spr->height;
 	sprite->grseg = spritenumber;
+	sprite->shift = shift;
 	sprite->sourceofs = block->sourceoffset[shift];
 	sprite->planesize = block->planesize[shift];
 	sprite->draw = draw;
@@ -1548,7 +1719,7 @@ void RFL_UpdateSprites (void)
 	id0_byte_t		*updatespot,*baseupdatespot;
 	id0_unsigned_t	updatedelta;
 	//id0_unsigned_t	updatecount;
-	id0_unsigned_t	height,sourceofs;
+	id0_unsigned_t	height,firstline;
 
 #ifdef PROFILE
 	id0_unsigned_t updatecount = 0;
@@ -1622,11 +1793,11 @@ redraw:
 		// draw it!
 		//
 			height = sprite->height;
-			sourceofs = sprite->sourceofs;
+			firstline = 0;
 			if (porty<0)
 			{
 				height += porty;					// clip top off
-				sourceofs -= porty*sprite->width;
+				firstline = -porty;
 				porty = 0;
 			}
 			else if (porty+height>PORTSCREENHIGH)
@@ -1639,8 +1810,7 @@ redraw:
 			switch (sprite->draw)
 			{
 			case spritedraw:
-				VW_MaskBlock(grsegs[sprite->grseg], sourceofs,
-					dest,sprite->width,height,sprite->planesize);
+				VW_MaskSprite(sprite->grseg,sprite->shift,firstline,dest,height);
 				break;
 
 			case maskdraw:
@@ -1688,6 +1858,7 @@ void RF_Refresh (int updateGraphics)
     id0_byte_t	*newupdate;
     id0_long_t	newtime;
 
+    BE_ST_ProfileEnter (BE_ST_PROFILE_RF);	// (REFKEEN) headless benchmark
 
     // Wait for the main thread to finish passing the data on screen
     {
@@ -1793,6 +1964,7 @@ void RF_Refresh (int updateGraphics)
 		tics = MAXTICS;
 	}    
 
+	BE_ST_ProfileLeave ();
 }
 
 #endif		// GRMODE == EGAGR
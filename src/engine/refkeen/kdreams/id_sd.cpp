@@ -1747,7 +1747,8 @@ SD_PlaySound(id0_word_t sound)
 {        
     // NOTE: GameSound names do not match here yet!
     GameSound gameSnd = GameSound(sound);
-    gSound.playSound(gameSnd);
+    // (REFKEEN) Queued, so the game never waits for the audio callback
+    gSound.queueSound(gameSnd);
 
     /*SoundCommon	id0_far *s;
 
@@ -73,6 +73,10 @@ id0_unsigned_t	ylookup[VIRTUALHEIGHT];
 
 id0_boolean_t		screenfaded;
 
+// (REFKEEN) shift the sprites while drawing them instead of keeping shifted copies.
+// DreamsEngine::setupRefKeen takes it from the configuration.
+id0_boolean_t		shiftspritesondraw;
+
 pictabletype	*pictable = nullptr;
 pictabletype	*picmtable = nullptr;
 spritetabletype *spritetable = nullptr;
@@ -444,6 +448,69 @@ void VW_DrawMPic(id0_unsigned_t x, id0_unsigned_t y, id0_unsigned_t chunknum)
 
 #if NUMSPRITES>0
 
+/*
+====================
+=
+= VW_MaskSprite
+=
+= (REFKEEN) Draws the given shift of a sprite, leaving out the first lines.
+= The shifted shape comes from the shift cache in id_ca, or is shifted while
+= drawing if shiftspritesondraw is set.
+=
+====================
+*/
+
+void VW_MaskSprite (id0_unsigned_t chunknum, id0_unsigned_t shift,
+	id0_unsigned_t firstline, id0_unsigned_t dest, id0_unsigned_t height)
+{
+	spritetype id0_seg	*block;
+	id0_unsigned_t	pixshift,width;
+
+	BE_ST_ProfileEnter (BE_ST_PROFILE_VW);	// (REFKEEN) headless benchmark
+
+	block = (spritetype id0_seg *)grsegs[chunknum];
+
+#if GRMODE == EGAGR
+	switch (spritetable[chunknum-STARTSPRITES].shifts)
+	{
+	case 2:
+		pixshift = (shift&2)*2;		// shifts 2 and 3 are both 4 pixels
+		break;
+	case 4:
+		pixshift = shift*2;
+		break;
+	default:
+		pixshift = 0;
+	}
+#endif
+#if GRMODE == CGAGR
+	pixshift = 0;
+#endif
+
+	if (!pixshift)
+	{
+		width = block->width[0];
+		VW_MaskBlock (block,block->sourceoffset[0]+firstline*width,dest,
+			width,height,block->planesize[0]);
+	}
+#if GRMODE == EGAGR
+	else if (shiftspritesondraw)
+	{
+		width = block->width[0];
+		VW_MaskBlockShifted (block,block->sourceoffset[0]+firstline*width,dest,
+			width,height,block->planesize[0],pixshift);
+	}
+	else
+	{
+		width = block->width[shift];
+		VW_MaskBlock (CA_ShiftedSprite(chunknum,pixshift),firstline*width,dest,
+			width,height,block->planesize[shift]);
+	}
+#endif
+
+	BE_ST_ProfileLeave ();
+}
+
 /*
 ====================
 =
@@ -483,8 +550,7 @@ void VW_DrawSprite(id0_int_t x, id0_int_t y, id0_unsigned_t chunknum)
 	else
 		dest += (x+1)/SCREENXDIV;
 
-	VW_MaskBlock (block,block->sourceoffset[shift],dest,
-		block->width[shift],spr->height,block->planesize[shift]);
+	VW_MaskSprite (chunknum,shift,0,dest,spr->height);
 }
 
 #endif
@@ -1167,6 +1233,7 @@ id0_int_t VW_MarkUpdateBlock (id0_int_t x1, id0_int_t y1, id0_int_t x2, id0_int_
 
 void VW_UpdateScreen (void)
 {
+	BE_ST_ProfileEnter (BE_ST_PROFILE_VW);	// (REFKEEN) headless benchmark
 
     /*if (cursorvisible>0)
         VWL_EraseCursor();
@@ -1183,8 +1250,7 @@ void VW_UpdateScreen (void)
 	VW_CGAFullUpdate();
 #endif
 
-
-
+	BE_ST_ProfileLeave ();
 }
 
 
@@ -1340,8 +1406,7 @@ void VWB_DrawSprite(id0_int_t x, id0_int_t y, id0_int_t chunknum)
 
 	if (VW_MarkUpdateBlock (x&SCREENXMASK,y,(x&SCREENXMASK)+width*SCREENXDIV-1
 		,y+height-1))
-		VW_MaskBlock (block,block->sourceoffset[shift],dest,
-			width,height,block->planesize[shift]);
+		VW_MaskSprite (chunknum,shift,0,dest,height);
 }
 #endif
 
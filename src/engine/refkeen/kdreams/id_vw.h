@@ -203,6 +203,7 @@ extern	id0_unsigned_t	linewidth;
 extern	id0_unsigned_t	ylookup[VIRTUALHEIGHT];
 
 extern	id0_boolean_t		screenfaded;
+extern	id0_boolean_t		shiftspritesondraw;
 
 extern	pictabletype	*pictable;
 extern	pictabletype	*picmtable;
@@ -266,6 +267,10 @@ void	VW_FadeDown(void);
 
 void VW_MaskBlock(memptr segm,id0_unsigned_t ofs,id0_unsigned_t dest,
 	id0_unsigned_t wide,id0_unsigned_t height,id0_unsigned_t planesize);
+#if GRMODE == EGAGR
+void VW_MaskBlockShifted(memptr segm,id0_unsigned_t ofs,id0_unsigned_t dest,
+	id0_unsigned_t wide,id0_unsigned_t height,id0_unsigned_t planesize,id0_unsigned_t pixshift);
+#endif
 void VW_MemToScreen(memptr source,id0_unsigned_t dest,id0_unsigned_t width,id0_unsigned_t height);
 void VW_ScreenToMem(id0_unsigned_t source,memptr dest,id0_unsigned_t width,id0_unsigned_t height);
 void VW_ScreenToScreen(id0_unsigned_t source,id0_unsigned_t dest,id0_unsigned_t width,id0_unsigned_t height);
@@ -311,6 +316,8 @@ void	VW_MeasureMPropString  (const id0_char_t id0_far *string, const id0_char_t
 void VW_DrawPropString (const id0_char_t id0_far *string, const id0_char_t id0_far *optsend);
 void VW_DrawMPropString (const id0_char_t id0_far *string, const id0_char_t id0_far *optsend);
 void VW_DrawSprite(id0_int_t x, id0_int_t y, id0_unsigned_t sprite);
+void VW_MaskSprite (id0_unsigned_t chunknum, id0_unsigned_t shift,
+	id0_unsigned_t firstline, id0_unsigned_t dest, id0_unsigned_t height);
 void VW_Plot(id0_unsigned_t x, id0_unsigned_t y, id0_unsigned_t color);
 void VW_Hlin(id0_unsigned_t xl, id0_unsigned_t xh, id0_unsigned_t y, id0_unsigned_t color);
 void VW_Vlin(id0_unsigned_t yl, id0_unsigned_t yh, id0_unsigned_t x, id0_unsigned_t color);
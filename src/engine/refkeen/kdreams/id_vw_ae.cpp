@@ -319,6 +319,60 @@ void VW_MaskBlock(memptr segm,id0_unsigned_t ofs,id0_unsigned_t dest,
 	} while (planemask != 0x10); // done all four planes?
 }
 
+//============================================================================
+//
+// VW_MaskBlockShifted
+//
+// (REFKEEN) Same as VW_MaskBlock, but the block is shifted right by pixshift
+// pixels on the way, the same way CAL_ShiftSprite does. It comes out one byte
+// wider, so no shifted copies have to be kept.
+//
+//============================================================================
+
+void VW_MaskBlockShifted(memptr segm,id0_unsigned_t ofs,id0_unsigned_t dest,
+	id0_unsigned_t wide,id0_unsigned_t height,id0_unsigned_t planesize,id0_unsigned_t pixshift)
+{
+	id0_byte_t rowmask[VIRTUALWIDTH/8+1],rowdata[VIRTUALWIDTH/8+1];
+	id0_unsigned_t *currshifttable = shifttabletable[pixshift];
+	id0_unsigned_t val,line,i,plane,egaDestOff;
+	id0_byte_t *srcPtr;
+
+	if (wide > VIRTUALWIDTH/8)
+		Quit ("VW_MaskBlockShifted: Block too wide!");
+
+	for (line = 0; line < height; line++)
+	{
+		srcPtr = (id0_byte_t *)segm + ofs + line*wide;
+		egaDestOff = dest + line*linewidth;
+
+		// the mask gets 1s shifted in
+		rowmask[0] = 0xFF;
+		for (i = 0; i < wide; i++)
+		{
+			val = currshifttable[srcPtr[i] ^ 0xFF] ^ 0xFFFF;
+			rowmask[i] &= (val & 0xFF);
+			rowmask[i+1] = (val >> 8);
+		}
+
+		for (plane = 0; plane < 4; plane++)
+		{
+			srcPtr += planesize;
+
+			// the data gets 0s shifted in
+			rowdata[0] = 0;
+			for (i = 0; i < wide; i++)
+			{
+				val = currshifttable[srcPtr[i]];
+				rowdata[i] |= (val & 0xFF);
+				rowdata[i+1] = (val >> 8);
+			}
+
+			for (i = 0; i <= wide; i++)
+				BE_ST_EGAUpdateGFXByte(egaDestOff+i, (BE_ST_EGAFetchGFXByte(egaDestOff+i, plane) & rowmask[i]) | rowdata[i], 1<<plane);
+		}
+	}
+}
+
 #if 0
 DATASEG
 
@@ -280,6 +280,7 @@ void 	GetNewObj (id0_boolean_t usedummy);
 void	RemoveObj (objtype *gone);
 void 	ScanInfoPlane (void);
 void 	PatchWorldMap (void);
+void 	PrefetchNearestLevel (void);
 void 	MarkTileGraphics (void);
 void 	FadeAndUnhook (void);
 void 	SetupGameLevel (id0_boolean_t loadnow);
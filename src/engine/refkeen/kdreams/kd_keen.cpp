@@ -245,20 +245,8 @@ void MemDrawChar (id0_int_t char8, id0_byte_t id0_far *dest, id0_unsigned_t widt
 #if GRMODE == EGAGR
 void ShiftScore (void)
 {
-	spritetabletype id0_far *spr;
-	spritetype id0_seg *dest;
-
-	spr = &spritetable[SCOREBOXSPR-STARTSPRITES];
-	dest = (spritetype id0_seg *)grsegs[SCOREBOXSPR];
-
-	CAL_ShiftSprite ((id0_byte_t *)dest+dest->sourceoffset[0],
-		(id0_byte_t *)dest+dest->sourceoffset[1],spr->width,spr->height,2);
-
-	CAL_ShiftSprite ((id0_byte_t *)dest+dest->sourceoffset[0],
-		(id0_byte_t *)dest+dest->sourceoffset[2],spr->width,spr->height,4);
-
-	CAL_ShiftSprite ((id0_byte_t *)dest+dest->sourceoffset[0],
-		(id0_byte_t *)dest+dest->sourceoffset[3],spr->width,spr->height,6);
+	// (REFKEEN) the shifts are made again from the changed shape when drawn
+	CA_ClearShiftedSprite (SCOREBOXSPR);
 #if 0
 	CAL_ShiftSprite (FP_SEG(dest),dest->sourceoffset[0],
 		dest->sourceoffset[1],spr->width,spr->height,2);
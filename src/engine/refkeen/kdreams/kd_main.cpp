@@ -92,7 +92,7 @@ void    InitGame (void);
 void DebugMemory (void)
 {
 	VW_FixRefreshBuffer ();
-	US_CenterWindow (16,7);
+	US_CenterWindow (16,9);
 
 	US_CPrint ("Memory Usage");
 	US_CPrint ("------------");
@@ -100,9 +100,13 @@ void DebugMemory (void)
 	US_PrintUnsigned (mminfo.mainmem/1024);
 	US_Print ("k\nFree      :");
 	US_PrintUnsigned (MM_UnusedMemory()/1024);
+	US_Print ("k\nLargest   :");
+	US_PrintUnsigned (MM_LargestFree()/1024);
 	US_Print ("k\nWith purge:");
 	US_PrintUnsigned (MM_TotalFree()/1024);
-	US_Print ("k\n");
+	US_Print ("k\nSorts     :");
+	US_PrintUnsigned (mmstats.sorts);
+	US_Print ("\n");
 	VW_UpdateScreen();
 	IN_Ack ();
 #if GRMODE == EGAGR
@@ -176,7 +180,8 @@ void TestSprites(void)
 		}
 		else
 		{
-			mem = block->sourceoffset[3]+5*block->planesize[3];
+			// (REFKEEN) the shifts aren't kept in the block any more
+			mem = block->sourceoffset[0]+5*block->planesize[0];
 			mem = (mem+15)&(~15);           // round to paragraphs
 			US_PrintUnsigned (mem);
 		}
@@ -220,6 +220,7 @@ void 	GetNewObj (id0_boolean_t usedummy);
 void	RemoveObj (objtype *gone);
 void 	ScanInfoPlane (void);
 void 	PatchWorldMap (void);
+void 	PrefetchNearestLevel (void);
 void 	MarkTileGraphics (void);
 void 	FadeAndUnhook (void);
 void 	SetupGameLevel (id0_boolean_t loadnow);
@@ -704,6 +705,48 @@ void PatchWorldMap (void)
 
 //===========================================================================
 
+/*
+==========================
+=
+= PrefetchNearestLevel
+=
+= (REFKEEN) Puts the unfinished level with the entrance closest to Keen
+= into the map cache, so walking into it doesn't wait for the map file
+=
+==========================
+*/
+
+void PrefetchNearestLevel (void)
+{
+	id0_int_t		x,y,keenx,keeny,level;
+	id0_unsigned_t	info;
+	id0_long_t		dist,bestdist;
+
+	keenx = player->x >> G_T_SHIFT;
+	keeny = player->y >> G_T_SHIFT;
+	level = 0;
+	bestdist = 0;
+
+	for (y=0;y<mapheight;y++)
+		for (x=0;x<mapwidth;x++)
+		{
+			info = *(mapsegs[2] + mapbwidthtable[y]/2 + x);
+			if (info<3 || info>18 || gamestate.leveldone[info-2])
+				continue;
+			dist = (id0_long_t)(x-keenx)*(x-keenx) + (id0_long_t)(y-keeny)*(y-keeny);
+			if (!level || dist<bestdist)
+			{
+				level = info-2;
+				bestdist = dist;
+			}
+		}
+
+	if (level)
+		CA_PrefetchMap (level);
+}
+
+//===========================================================================
+
 /*
 ==========================
 =
@@ -769,6 +812,9 @@ void 	SetupGameLevel (id0_boolean_t loadnow)
 		ScanInfoPlane ();
 	RF_MarkTileGraphics ();
 
+	if (!mapon && loadnow)
+		PrefetchNearestLevel ();
+
 //
 // have the caching manager load and purge stuff to make sure all marks
 // are in memory
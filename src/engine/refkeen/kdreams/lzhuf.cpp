@@ -72,7 +72,9 @@ extern "C"
 //===========================================================================
 
 
+#ifndef INCLUDE_LZH_COMP
 #define INCLUDE_LZH_COMP			0
+#endif
 #define INCLUDE_LZH_DECOMP			1
 
 
@@ -991,7 +993,7 @@ id0_long_t lzhCompress(void id0_far *infile, void id0_far *outfile,id0_unsigned_
 	textsize = DataLength;
 
 	if (textsize == 0)
-		return;
+		return 0; // REFKEEN - Was return without a value
 
 	getbuf = 0;
 	getlen = 0;
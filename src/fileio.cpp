@@ -77,3 +77,41 @@ void fputl(unsigned long word, FILE *fp)
 	fputc(b, fp);
 	fputc(a, fp);
 }
+
+
+bool freadAll(FILE *fp, std::vector<byte> &data)
+{
+	data.clear();
+
+	const long start = ftell(fp);
+	if(start < 0 || fseek(fp, 0, SEEK_END) != 0)
+		return false;
+
+	const long end = ftell(fp);
+	fseek(fp, start, SEEK_SET);
+
+	if(end <= start)
+		return false;
+
+	data.resize(size_t(end-start));
+	data.resize(fread(data.data(), 1, data.size(), fp));
+	return !data.empty();
+}
+
+bool freadAll(std::ifstream &file, std::vector<byte> &data)
+{
+	data.clear();
+
+	const std::streampos start = file.tellg();
+	file.seekg(0, std::ios::end);
+	const std::streampos end = file.tellg();
+	file.seekg(start);
+
+	if(start < 0 || end <= start)
+		return false;
+
+	data.resize(size_t(end-start));
+	file.read(reinterpret_cast<char*>(data.data()), std::streamsize(data.size()));
+	data.resize(size_t(file.gcount()));
+	return !data.empty();
+}
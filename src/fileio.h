@@ -4,6 +4,7 @@
 #include <string>
 #include <cstdio>
 #include <fstream>
+#include <vector>
 #include <base/TypeDefinitions.h>
 
 unsigned int fgeti(FILE *fp);
@@ -13,4 +14,11 @@ word fgetw(std::ifstream &file);
 void fputi(unsigned int word, FILE *fp);
 void fputl(unsigned long word, FILE *fp);
 
+/**
+ * \brief Reads everything from the current position up to the end of the file in one go
+ * \return true if anything could be read, otherwise false
+ */
+bool freadAll(FILE *fp, std::vector<byte> &data);
+bool freadAll(std::ifstream &file, std::vector<byte> &data);
+
 #endif
@@ -7,6 +7,7 @@
 
 #include "CExeFile.h"
 #include "compression/Cunlzexe.h"
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <fstream>
@@ -194,11 +195,54 @@ bool CExeFile::readData(const unsigned int episode, const std::string& datadirec
 
 	m_crc = getcrc32( mData.data(), m_datasize );
 
+    mSignatureIndex.build(mData.data(), m_datasize);
+    mDataCrc = m_crc;
+
 	gLogging.ftextOut( "EXE processed with size of %d and crc of %X\n", m_datasize, m_crc );
 
 	return true;
 }
 
+void CExeFile::dataChanged()
+{
+    mSignatureIndex.build(mData.data(), m_datasize);
+    mDataCrc = getcrc32( mData.data(), m_datasize );
+}
+
+std::string CExeFile::messageCacheFilename() const
+{
+    char filename[32];
+    snprintf(filename, sizeof(filename), "messages_%08X.cache", mDataCrc);
+    return GetWriteFullFileName(JoinPaths(gKeenFiles.gameDir, filename), true);
+}
+
+const MessageTable* CExeFile::getCachedMessages()
+{
+    if(mMessageCacheValid && mMessageCacheCrc == mDataCrc)
+        return &mMessageCache;
+
+    // Maybe an earlier launch has extracted them
+    if(mMessageCache.load(messageCacheFilename(), mDataCrc))
+    {
+        mMessageCacheCrc = mDataCrc;
+        mMessageCacheValid = true;
+        return &mMessageCache;
+    }
+
+    return nullptr;
+}
+
+void CExeFile::cacheMessages(const MessageTable &messages)
+{
+    mMessageCache = messages;
+    mMessageCacheCrc = mDataCrc;
+    mMessageCacheValid = true;
+
+    const std::string filename = messageCacheFilename();
+    if(!mMessageCache.save(filename, mDataCrc))
+        gLogging.ftextOut("Could not save the messages into %s<br>", filename.c_str());
+}
+
 bool CExeFile::Supported()
 {
 
@@ -402,7 +446,7 @@ bool CExeFile::readExeImageSize(unsigned char *p_data_start, unsigned long *imgl
 }
 
 
-bool CExeFile::unpackAudioInterval( RingBuffer<IMFChunkType> &imfData,
+bool CExeFile::unpackAudioInterval( std::vector<IMFChunkType> &imfData,
                                     const std::vector<uint8_t> &AudioCompFileData,
                                     const int audio_start,
                                     const int audio_end) const
@@ -461,12 +505,9 @@ bool CExeFile::unpackAudioInterval( RingBuffer<IMFChunkType> &imfData,
         }
 
 
-        if(!imfData.empty())
-            imfData.clear();
-
         const word imf_chunks = data_size/sizeof(IMFChunkType);
-        imfData.reserve(imf_chunks);
-        memcpy(imfData.getStartPtr(), imfDataPtr, data_size);
+        imfData.resize(imf_chunks);
+        memcpy(imfData.data(), imfDataPtr, imf_chunks*sizeof(IMFChunkType));
         return true;
     }
     else
@@ -475,7 +516,7 @@ bool CExeFile::unpackAudioInterval( RingBuffer<IMFChunkType> &imfData,
     }
 }
 
-bool CExeFile::readMusicHedInternal(RingBuffer<IMFChunkType> &imfData,
+bool CExeFile::readMusicHedInternal(std::vector<IMFChunkType> &imfData,
                                     std::vector<uint32_t> &musiched,
                                     const size_t audiofilecompsize) const
 {
@@ -485,22 +526,20 @@ bool CExeFile::readMusicHedInternal(RingBuffer<IMFChunkType> &imfData,
 
     const uint32_t *starthedptr = reinterpret_cast<uint32_t*>(getHeaderData());
     uint32_t *audiohedptr = const_cast<uint32_t*>(starthedptr);
-    for( const uint32_t *endptr = (uint32_t*) (void*) getHeaderData()+getExeDataSize()/sizeof(uint32_t);
-         audiohedptr < endptr ;
-         audiohedptr++ )
+
+    // The AUDIOHED ends with the size of the audio file. Go back from there to its first entry
+    size_t audiohedEndOffset = 0;
+    if( mSignatureIndex.findAlignedLongWord(audiofilecompsize, audiohedEndOffset) )
     {
-        if(*audiohedptr == audiofilecompsize)
+        audiohedptr += audiohedEndOffset/sizeof(uint32_t);
+
+        for( ; audiohedptr > starthedptr ; audiohedptr-- )
         {
-            for( const uint32_t *startptr = (uint32_t*) (void*) getHeaderData() ;
-                 audiohedptr > startptr ; audiohedptr-- )
-            {
-                // Get the number of Audio files we have
-                number_of_audiorecs++;
-                empty = false;
-                if(*audiohedptr == 0x0)
-                    break;
-            }
-            break;
+            // Get the number of Audio files we have
+            number_of_audiorecs++;
+            empty = false;
+            if(*audiohedptr == 0x0)
+                break;
         }
     }
 
@@ -597,7 +636,7 @@ bool CExeFile::readMusicHedFromFile(const std::string &fname, std::vector<uint32
 
 
 
-bool CExeFile::readCompressedAudiointoMemory(RingBuffer<IMFChunkType> &imfData,
+bool CExeFile::readCompressedAudiointoMemory(std::vector<IMFChunkType> &imfData,
                                              std::vector<uint32_t> &musiched,
                                              std::vector<uint8_t> &AudioCompFileData) const
 
@@ -644,7 +683,7 @@ bool CExeFile::readCompressedAudiointoMemory(RingBuffer<IMFChunkType> &imfData,
 
 
 
-bool CExeFile::loadMusicTrack(RingBuffer<IMFChunkType> &imfData, const int track) const
+bool CExeFile::loadMusicTrack(std::vector<IMFChunkType> &imfData, const int track) const
 {
     // Now get the proper music slot reading the assignment table.
     std::vector<uint8_t> AudioCompFileData;
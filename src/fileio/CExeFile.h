@@ -15,6 +15,8 @@
 #define CEXEFILE_H_
 
 #include "fileio/crc.h"
+#include "fileio/ExeSignatureIndex.h"
+#include "fileio/MessageTable.h"
 #include <base/TypeDefinitions.h>
 
 #include "sdl/audio/music/CIMFPlayer.h"
@@ -71,25 +73,60 @@ public:
     byte* getDSegPtr() const
     {	return m_data_segment; }
 
-    bool loadMusicTrack(RingBuffer<IMFChunkType> &imfData, const int track) const;
+    /**
+     * @brief getSignatureIndex Index over the whole unpacked exe (header included).
+     *                          Offsets it returns are relative to getHeaderData()
+     */
+    const ExeSignatureIndex& getSignatureIndex() const
+    {   return mSignatureIndex;  }
+
+    /**
+     * @brief dataChanged Needs to be called whenever the exe data has been altered,
+     *                    for example by the patcher. It updates the index and checksum of the data
+     */
+    void dataChanged();
+
+    /**
+     * @brief getDataCrc Checksum of the exe data as it is now, patches included
+     */
+    unsigned int getDataCrc() const
+    {   return mDataCrc;  }
+
+    /**
+     * @brief getCachedMessages Messages extracted earlier from exactly this exe data,
+     *                          in this run or by an earlier launch which saved them into the game directory
+     * @return pointer to the cached table or nullptr if the data has not been extracted yet
+     */
+    const MessageTable* getCachedMessages();
+
+    /**
+     * @brief cacheMessages Keeps the messages extracted from the current exe data and saves them,
+     *                      so they don't have to be extracted again when the game is restarted
+     */
+    void cacheMessages(const MessageTable &messages);
+
+    bool loadMusicTrack(std::vector<IMFChunkType> &imfData, const int track) const;
 
 
 private:
 
+    // File in the game directory, where the messages of the exe data with that checksum are saved
+    std::string messageCacheFilename() const;
+
     bool readMusicHedFromFile(const std::string &fname,
                   std::vector<uint32_t> &musiched) const;
 
-    bool unpackAudioInterval(RingBuffer<IMFChunkType> &imfData,
+    bool unpackAudioInterval(std::vector<IMFChunkType> &imfData,
                               const std::vector<uint8_t> &AudioCompFileData,
                               const int audio_start,
                               const int audio_end) const;
 
-    bool readMusicHedInternal(RingBuffer<IMFChunkType> &imfData,
+    bool readMusicHedInternal(std::vector<IMFChunkType> &imfData,
                               std::vector<uint32_t> &musiched,
                               const size_t audiofilecompsize) const;
 
 
-    bool readCompressedAudiointoMemory(RingBuffer<IMFChunkType> &imfData,
+    bool readCompressedAudiointoMemory(std::vector<IMFChunkType> &imfData,
                                        std::vector<uint32_t> &musiched,
                                        std::vector<uint8_t> &AudioCompFileData) const;
 
@@ -118,6 +155,13 @@ private:
 	bool m_demo;
 	unsigned int m_crc;
 	std::vector<byte> mData;
+	ExeSignatureIndex mSignatureIndex;
+
+	// Checksum of the data as it is now, patches included
+	unsigned int mDataCrc = 0;
+	MessageTable mMessageCache;
+	unsigned int mMessageCacheCrc = 0;
+	bool mMessageCacheValid = false;
 	void *m_headerdata;
 	byte *m_rawdata;
 	byte *m_data_segment;
@@ -21,6 +21,7 @@
 
 
 CPatcher::CPatcher(CExeFile &ExeFile, const std::string &patchFname) :
+mExeFile(ExeFile),
 mPatchFname(patchFname)
 {
 	m_episode = ExeFile.getEpisode();
@@ -233,6 +234,10 @@ void CPatcher::process()
 	}
 
     gLogging.ftextOut("Patched %d items.\n", numPatchedItems);
+
+    // Patches might have moved or changed data the loaders look up later on
+    if(numPatchedItems > 0)
+        mExeFile.dataChanged();
 }
 
 
@@ -266,6 +271,9 @@ void CPatcher::postProcess()
 		it->keyword.clear();
 		it->value.clear();
 	}
+
+	if(!mPostPatchItems.empty())
+		mExeFile.dataChanged();
 }
 
 
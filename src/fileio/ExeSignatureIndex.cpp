@@ -0,0 +1,127 @@
+/*
+ * ExeSignatureIndex.cpp
+ *
+ *  Created on: 18.10.2026
+ */
+
+#include "ExeSignatureIndex.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+struct SignatureDef
+{
+    ExeSignatureIndex::Signature sig;
+    const uint8_t *bytes;
+    size_t size;
+};
+
+const uint8_t DICTSIG[] = { 0xFD, 0x01, 0x00, 0x00, 0x00, 0x00 };
+
+const SignatureDef signatureDefs[] =
+{
+    { ExeSignatureIndex::HUFFMAN_DICT, DICTSIG, sizeof(DICTSIG) }
+};
+
+const size_t numSignatureDefs = sizeof(signatureDefs)/sizeof(SignatureDef);
+
+}
+
+
+size_t ExeSignatureIndex::signatureSize(const Signature sig)
+{
+    for(size_t d = 0 ; d < numSignatureDefs ; d++)
+    {
+        if(signatureDefs[d].sig == sig)
+            return signatureDefs[d].size;
+    }
+
+    return 0;
+}
+
+
+void ExeSignatureIndex::clear()
+{
+    mpData = nullptr;
+    mSize = 0;
+
+    for(auto &offsets : mSigOffsets)
+        offsets.clear();
+
+    mLongWordSlots.clear();
+}
+
+
+uint32_t ExeSignatureIndex::longWordAt(const uint32_t slot) const
+{
+    const uint8_t *p = mpData + size_t(slot)*sizeof(uint32_t);
+    return uint32_t(p[0]) | (uint32_t(p[1])<<8) |
+           (uint32_t(p[2])<<16) | (uint32_t(p[3])<<24);
+}
+
+
+void ExeSignatureIndex::build(const uint8_t *data, const size_t size)
+{
+    clear();
+
+    mpData = data;
+    mSize = size;
+
+    if(!data)
+        return;
+
+    // Only bytes which start a signature are looked at more closely
+    bool isFirstByte[256] = { false };
+    for(size_t d = 0 ; d < numSignatureDefs ; d++)
+        isFirstByte[signatureDefs[d].bytes[0]] = true;
+
+    const size_t numSlots = size/sizeof(uint32_t);
+    mLongWordSlots.resize(numSlots);
+
+    for(size_t pos = 0 ; pos < size ; pos++)
+    {
+        if((pos % sizeof(uint32_t)) == 0 && pos/sizeof(uint32_t) < numSlots)
+            mLongWordSlots[pos/sizeof(uint32_t)] = uint32_t(pos/sizeof(uint32_t));
+
+        if(!isFirstByte[data[pos]])
+            continue;
+
+        for(size_t d = 0 ; d < numSignatureDefs ; d++)
+        {
+            const SignatureDef &def = signatureDefs[d];
+
+            if(pos + def.size <= size &&
+               memcmp(data+pos, def.bytes, def.size) == 0)
+            {
+                mSigOffsets[def.sig].push_back(pos);
+            }
+        }
+    }
+
+    std::sort(mLongWordSlots.begin(), mLongWordSlots.end(),
+              [this](const uint32_t a, const uint32_t b)
+    {
+        const uint32_t va = longWordAt(a);
+        const uint32_t vb = longWordAt(b);
+        return (va != vb) ? (va < vb) : (a < b);
+    });
+}
+
+
+bool ExeSignatureIndex::findAlignedLongWord(const uint32_t value, size_t &offset) const
+{
+    auto it = std::lower_bound(mLongWordSlots.begin(), mLongWordSlots.end(), value,
+                               [this](const uint32_t slot, const uint32_t v)
+    {
+        return longWordAt(slot) < v;
+    });
+
+    if(it == mLongWordSlots.end() || longWordAt(*it) != value)
+        return false;
+
+    offset = size_t(*it)*sizeof(uint32_t);
+    return true;
+}
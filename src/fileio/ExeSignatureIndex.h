@@ -0,0 +1,70 @@
+/*
+ * ExeSignatureIndex.h
+ *
+ *  Created on: 18.10.2026
+ *
+ *  Index over the unpacked image of an executable. Several loaders
+ *  used to walk the whole exe byte by byte (Huffman dictionaries,
+ *  the embedded AUDIOHED). This index is built in one pass right after
+ *  the exe is unpacked, so those lookups become cheap queries.
+ */
+
+#ifndef EXESIGNATUREINDEX_H_
+#define EXESIGNATUREINDEX_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class ExeSignatureIndex
+{
+public:
+
+    /// Byte patterns which are located when the index is built
+    enum Signature
+    {
+        HUFFMAN_DICT,   // Last node of a Huffman dictionary {FD 01 00 00 00 00}
+        NUM_SIGNATURES
+    };
+
+    /**
+     * \brief Scans data once and records every occurrence of the known signatures
+     *        and the positions of all 32-bit aligned values.
+     * \param data  start of the unpacked exe (including its header)
+     * \param size  number of bytes in data
+     */
+    void build(const uint8_t *data, const size_t size);
+
+    void clear();
+
+    /// Length of the given signature in bytes
+    static size_t signatureSize(const Signature sig);
+
+    /**
+     * \brief All offsets (relative to data) at which the signature occurs, in ascending order
+     */
+    const std::vector<size_t>& offsetsOf(const Signature sig) const
+    {   return mSigOffsets[sig];    }
+
+    /**
+     * \brief Looks for the first 32-bit little-endian value at an offset divisible by four
+     *        which equals value.
+     * \param offset    receives the offset in bytes relative to data if found
+     * \return true if there is such a value, otherwise false
+     */
+    bool findAlignedLongWord(const uint32_t value, size_t &offset) const;
+
+private:
+
+    uint32_t longWordAt(const uint32_t slot) const;
+
+    const uint8_t *mpData = nullptr;
+    size_t mSize = 0;
+
+    std::vector<size_t> mSigOffsets[NUM_SIGNATURES];
+
+    // Slot numbers (offset/4) of all aligned long words, sorted by value, then slot
+    std::vector<uint32_t> mLongWordSlots;
+};
+
+#endif /* EXESIGNATUREINDEX_H_ */
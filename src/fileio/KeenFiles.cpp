@@ -11,6 +11,7 @@
 #include "KeenFiles.h"
 #include <base/utils/FindFile.h>
 #include <base/GsLogging.h>
+#include <fstream>
 
 
 
@@ -28,3 +29,47 @@ int getRessourceID(const std::string& filename, const std::string& namefilter)
 	return value;
 }
 
+
+
+const std::vector<byte> *KeenFiles::gameMaps(const std::string &filename)
+{
+    const unsigned int crc = exeFile.getDataCrc();
+
+    if(filename == mGameMapsFilename && crc == mGameMapsCrc && !mGameMapsData.empty())
+        return &mGameMapsData;
+
+    resetGameMaps();
+
+    std::ifstream mapFile;
+    if(!OpenGameFileR(mapFile, filename, std::ios::binary))
+        return nullptr;
+
+    mapFile.seekg(0, std::ios::end);
+    const std::streamoff length = mapFile.tellg();
+    mapFile.seekg(0, std::ios::beg);
+
+    if(length <= 0)
+        return nullptr;
+
+    mGameMapsData.resize(size_t(length));
+    mapFile.read(reinterpret_cast<char*>(mGameMapsData.data()), length);
+
+    if(!mapFile)
+    {
+        resetGameMaps();
+        return nullptr;
+    }
+
+    mGameMapsFilename = filename;
+    mGameMapsCrc = crc;
+    return &mGameMapsData;
+}
+
+
+void KeenFiles::resetGameMaps()
+{
+    // swap, so the memory is really given back
+    std::vector<byte>().swap(mGameMapsData);
+    mGameMapsFilename.clear();
+    mGameMapsCrc = 0;
+}
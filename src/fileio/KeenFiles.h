@@ -10,6 +10,7 @@
 
 #include <string>
 #include <set>
+#include <vector>
 #include <base/utils/StringUtils.h>
 #include <base/Singleton.h>
 #include "CExeFile.h"
@@ -32,6 +33,9 @@ struct KeenFiles : public GsSingleton<KeenFiles>
 
 	void setupFilenames(const unsigned int episode)
 	{
+	    // Another game may be started, its levels are in another GAMEMAPS
+	    resetGameMaps();
+
 	    const std::string epStr = itoa(episode);
 	    
 	    if(episode <= 6)
@@ -55,6 +59,27 @@ struct KeenFiles : public GsSingleton<KeenFiles>
             audioHedFilename = "AUDIOHHD.KDR";
 	    }
 	}
+
+    /**
+     * @brief gameMaps  Whole content of the GAMEMAPS file. It is read once and kept,
+     *                  so entering another level of the same game does not read it again.
+     *                  The content belongs to the game whose exe data has the checksum
+     *                  it was read with, for any other it is read anew.
+     * @param filename  path of the GAMEMAPS file
+     * @return pointer to the data or nullptr if the file could not be read
+     */
+    const std::vector<byte> *gameMaps(const std::string &filename);
+
+    /**
+     * @brief resetGameMaps Releases the kept content of the GAMEMAPS file
+     */
+    void resetGameMaps();
+
+private:
+
+    std::vector<byte> mGameMapsData;
+    std::string mGameMapsFilename;
+    unsigned int mGameMapsCrc = 0;
 };
 
 
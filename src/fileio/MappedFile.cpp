@@ -0,0 +1,84 @@
+/*
+ * MappedFile.cpp
+ *
+ *  Created on: 18.10.2026
+ */
+
+#include "MappedFile.h"
+#include "fileio.h"
+
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPEDFILE_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+
+bool MappedFile::open(const std::string &filename)
+{
+    close();
+
+#ifdef MAPPEDFILE_USE_MMAP
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void *ptr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if(ptr != MAP_FAILED)
+        {
+            mpData = static_cast<const byte*>(ptr);
+            mSize = size_t(st.st_size);
+            mMapped = true;
+        }
+    }
+
+    ::close(fd);
+
+    if(mMapped)
+        return true;
+#endif
+
+    FILE *fp = fopen(filename.c_str(), "rb");
+    if(!fp)
+        return false;
+
+    const bool ok = freadAll(fp, mBuffer);
+    fclose(fp);
+
+    if(!ok || mBuffer.empty())
+    {
+        mBuffer.clear();
+        return false;
+    }
+
+    mpData = mBuffer.data();
+    mSize = mBuffer.size();
+    return true;
+}
+
+
+void MappedFile::close()
+{
+#ifdef MAPPEDFILE_USE_MMAP
+    if(mMapped)
+        munmap(const_cast<byte*>(mpData), mSize);
+#endif
+
+    mMapped = false;
+    mpData = nullptr;
+    mSize = 0;
+    mBuffer.clear();
+}
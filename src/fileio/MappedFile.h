@@ -0,0 +1,51 @@
+/*
+ * MappedFile.h
+ *
+ *  Created on: 18.10.2026
+ *
+ *  Read-only view of a whole file. Where the system supports it the file
+ *  is memory mapped, so only the parts actually read are loaded from disk.
+ *  Elsewhere it is read into memory at once.
+ */
+
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <base/TypeDefinitions.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * \brief Opens the file with the given full path. A previously opened file is closed.
+     * \return true if the file could be opened and is not empty
+     */
+    bool open(const std::string &filename);
+
+    void close();
+
+    const byte *data() const
+    {   return mpData;  }
+
+    size_t size() const
+    {   return mSize;   }
+
+private:
+    const byte *mpData = nullptr;
+    size_t mSize = 0;
+    bool mMapped = false;
+
+    // Holds the file, if it could not be mapped
+    std::vector<byte> mBuffer;
+};
+
+#endif /* MAPPEDFILE_H_ */
@@ -0,0 +1,237 @@
+/*
+ * MessageTable.cpp
+ *
+ *  Created on: 18.10.2026
+ */
+
+#include "MessageTable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+namespace
+{
+
+// Replaced texts are only dropped from the pool when there is that much of them
+const size_t MinCompactSize = 4096;
+
+const char MessageFileMagic[4] = { 'C', 'G', 'M', 'T' };
+const uint32_t MessageFileVersion = 1;
+
+struct MessageFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t key;
+    uint32_t numEntries;
+    uint32_t poolSize;
+};
+
+}
+
+void MessageTable::clear()
+{
+    mPool.clear();
+    mEntries.clear();
+    mInterned.clear();
+    mReplaced = 0;
+}
+
+
+uint32_t MessageTable::intern(const char *str, const size_t length)
+{
+    const size_t hash = std::hash<std::string>()(std::string(str, length));
+
+    auto range = mInterned.equal_range(hash);
+    for( auto it = range.first ; it != range.second ; it++ )
+    {
+        const char *pooled = at(it->second);
+        if( strlen(pooled) == length && memcmp(pooled, str, length) == 0 )
+            return it->second;
+    }
+
+    const uint32_t offset = uint32_t(mPool.size());
+    mPool.insert(mPool.end(), str, str+length);
+    mPool.push_back('\0');
+    mInterned.insert(std::make_pair(hash, offset));
+    return offset;
+}
+
+
+void MessageTable::set(const std::string &name, const std::string &text)
+{
+    // Texts are stored zero terminated, so anything behind a zero would be lost anyway
+    const size_t textLength = strnlen(text.c_str(), text.size());
+    const uint32_t textOffset = intern(text.c_str(), textLength);
+
+    auto it = std::lower_bound(mEntries.begin(), mEntries.end(), name.c_str(),
+                               [this](const Entry &entry, const char *key)
+    {
+        return strcmp(at(entry.name), key) < 0;
+    });
+
+    if( it != mEntries.end() && strcmp(at(it->name), name.c_str()) == 0 )
+    {
+        const uint32_t oldText = it->text;
+        const size_t oldLength = it->length;
+
+        it->text = textOffset;
+        it->length = uint32_t(textLength);
+
+        // The old text stays interned, so setting it again reuses its space.
+        // If too much of the pool is unused that way, it is built anew.
+        if( oldText != textOffset && !isReferenced(oldText) )
+        {
+            mReplaced += oldLength + 1;
+
+            if( mReplaced >= MinCompactSize && 2*mReplaced >= mPool.size() )
+                compact();
+        }
+        return;
+    }
+
+    Entry entry;
+    entry.text = textOffset;
+    entry.length = uint32_t(textLength);
+
+    const size_t pos = size_t(it - mEntries.begin());
+    entry.name = intern(name.c_str(), strnlen(name.c_str(), name.size()));
+    mEntries.insert(mEntries.begin() + pos, entry);
+}
+
+
+void MessageTable::merge(const MessageTable &other)
+{
+    for( const auto &entry : other.mEntries )
+    {
+        set(other.at(entry.name),
+            std::string(other.at(entry.text), entry.length));
+    }
+}
+
+
+const char *MessageTable::find(const char *name, size_t *length) const
+{
+    auto it = std::lower_bound(mEntries.begin(), mEntries.end(), name,
+                               [this](const Entry &entry, const char *key)
+    {
+        return strcmp(at(entry.name), key) < 0;
+    });
+
+    if( it == mEntries.end() || strcmp(at(it->name), name) != 0 )
+        return nullptr;
+
+    if(length)
+        *length = it->length;
+
+    return at(it->text);
+}
+
+
+bool MessageTable::isReferenced(const uint32_t offset) const
+{
+    for( const auto &entry : mEntries )
+    {
+        if( entry.name == offset || entry.text == offset )
+            return true;
+    }
+
+    return false;
+}
+
+
+void MessageTable::compact()
+{
+    const std::vector<char> oldPool(std::move(mPool));
+    std::vector<Entry> entries(std::move(mEntries));
+
+    clear();
+
+    // The order by name stays the same
+    for( auto &entry : entries )
+    {
+        const char *name = oldPool.data() + entry.name;
+        entry.name = intern(name, strlen(name));
+        entry.text = intern(oldPool.data() + entry.text, entry.length);
+    }
+
+    mEntries.swap(entries);
+}
+
+
+bool MessageTable::save(const std::string &filename, const uint32_t key) const
+{
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if(!file)
+        return false;
+
+    MessageFileHeader header;
+    memcpy(header.magic, MessageFileMagic, sizeof(header.magic));
+    header.version = MessageFileVersion;
+    header.key = key;
+    header.numEntries = uint32_t(mEntries.size());
+    header.poolSize = uint32_t(mPool.size());
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(mEntries.data()), mEntries.size()*sizeof(Entry));
+    file.write(mPool.data(), mPool.size());
+
+    return bool(file);
+}
+
+
+bool MessageTable::load(const std::string &filename, const uint32_t key)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if(!file)
+        return false;
+
+    MessageFileHeader header;
+    if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+
+    if( memcmp(header.magic, MessageFileMagic, sizeof(header.magic)) != 0 ||
+        header.version != MessageFileVersion || header.key != key ||
+        header.poolSize == 0 )
+        return false;
+
+    std::vector<Entry> entries(header.numEntries);
+    std::vector<char> pool(header.poolSize);
+
+    if( !file.read(reinterpret_cast<char*>(entries.data()), entries.size()*sizeof(Entry)) ||
+        !file.read(pool.data(), pool.size()) )
+        return false;
+
+    // Every string has to end inside the pool, and the names have to be in order
+    if( pool.back() != '\0' )
+        return false;
+
+    for( size_t i = 0 ; i < entries.size() ; i++ )
+    {
+        const Entry &entry = entries[i];
+
+        if( entry.name >= pool.size() || entry.text >= pool.size() ||
+            size_t(entry.text) + entry.length >= pool.size() ||
+            pool[entry.text + entry.length] != '\0' )
+            return false;
+
+        if( i > 0 && strcmp(pool.data() + entries[i-1].name, pool.data() + entry.name) >= 0 )
+            return false;
+    }
+
+    clear();
+    mEntries.swap(entries);
+    mPool.swap(pool);
+
+    // Every string in the pool starts behind the end of the one before
+    for( uint32_t offset = 0 ; offset < mPool.size() ; )
+    {
+        const size_t length = strlen(at(offset));
+        mInterned.insert(std::make_pair(std::hash<std::string>()(std::string(at(offset), length)), offset));
+        offset += uint32_t(length) + 1;
+    }
+
+    return true;
+}
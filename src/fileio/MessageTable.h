@@ -0,0 +1,95 @@
+/*
+ * MessageTable.h
+ *
+ *  Created on: 18.10.2026
+ *
+ *  Holds the texts of the game (read from the exe or set by patches)
+ *  in one contiguous pool. Identical texts are only stored once and
+ *  a text can be looked up by its name without allocating memory.
+ */
+
+#ifndef MESSAGETABLE_H_
+#define MESSAGETABLE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class MessageTable
+{
+public:
+
+    void clear();
+
+    /**
+     * \brief Sets the text with the given name. An existing text of that name is replaced.
+     */
+    void set(const std::string &name, const std::string &text);
+
+    /**
+     * \brief Copies all the texts of other into this table, replacing those of the same name
+     */
+    void merge(const MessageTable &other);
+
+    /**
+     * \brief Writes the table into a file, together with a key telling what it was made from
+     * \return true if the file could be written
+     */
+    bool save(const std::string &filename, const uint32_t key) const;
+
+    /**
+     * \brief Reads a table written by save(). The table is left alone
+     *        if the file is missing, damaged or was written with another key.
+     * \return true if the table has been read
+     */
+    bool load(const std::string &filename, const uint32_t key);
+
+    /**
+     * \brief Looks up the text of the given name.
+     * \param name      zero terminated name of the text
+     * \param length    if not null, receives the length of the text
+     * \return pointer to the zero terminated text inside the pool or nullptr if there is none.
+     *         It stays valid until the table is changed the next time.
+     */
+    const char *find(const char *name, size_t *length = nullptr) const;
+
+    size_t size() const
+    {   return mEntries.size();  }
+
+    bool empty() const
+    {   return mEntries.empty();  }
+
+private:
+
+    struct Entry
+    {
+        uint32_t name;      // Offsets into mPool
+        uint32_t text;
+        uint32_t length;
+    };
+
+    uint32_t intern(const char *str, const size_t length);
+
+    bool isReferenced(const uint32_t offset) const;
+
+    // Builds the pool again from the texts the entries refer to
+    void compact();
+
+    const char *at(const uint32_t offset) const
+    {   return mPool.data() + offset;   }
+
+    std::vector<char> mPool;
+
+    // Sorted by name, so a lookup is a binary search
+    std::vector<Entry> mEntries;
+
+    // Hash of every string in the pool, so texts used more than once share their storage
+    std::unordered_multimap<size_t, uint32_t> mInterned;
+
+    // Bytes of texts which have been replaced. When they take up half of the pool, it gets compacted
+    size_t mReplaced = 0;
+};
+
+#endif /* MESSAGETABLE_H_ */
@@ -32,13 +32,26 @@
  * \param	length	length of the EXPANDED data
  */
 void CCarmack::expand( std::vector<byte>& dst, std::vector<byte>& src )
+{
+	if(src.empty())
+	{
+		dst.clear();
+		return;
+	}
+
+	expand(dst, src.data(), src.size());
+}
+
+/**
+ * \brief			Same as above but reading straight out of a buffer, for example
+ * 					the whole GAMEMAPS file. Nothing outside [src, src+srcSize) is read.
+ */
+void CCarmack::expand( std::vector<byte>& dst, const byte *src, const size_t srcSize )
 {
 	uint32_t i, j, offset, length, inc;
 
 	dst.clear();
 
-    const unsigned int srcSize = src.size();
-
     for( i=WORDSIZE ; i<srcSize ; i+=inc )
 	{
         if(TAG >= srcSize)
@@ -47,44 +60,59 @@ void CCarmack::expand( std::vector<byte>& dst, std::vector<byte>& src )
             return;
         }
 
-		switch( src.at(TAG) )
+		switch( src[TAG] )
 		{
 		case NEARTAG:
-			if( src.at(COUNT)==0x00 && src.at(OFFSET_MSB)==0x00 )
+			if( OFFSET >= srcSize || (src[COUNT]==0x00 && OFFSET_MSB >= srcSize) )
+			{
+				gLogging.textOut("Something went wrong with the Carmack compression!\n");
+				return;
+			}
+
+			if( src[COUNT]==0x00 && src[OFFSET_MSB]==0x00 )
 			{
 				dst.push_back(NEARTAG);
-				inc = WORDSIZE+1;
 			}
 			else
 			{
-				offset = dst.size()-(WORDSIZE*src.at(OFFSET));
-				length = WORDSIZE*src.at(COUNT);
+				length = WORDSIZE*src[COUNT];
+
+				// A reference before the start of the output copies nothing
+				if( src[OFFSET]==0 || WORDSIZE*src[OFFSET] > dst.size() )
+					length = 0;
+
+				offset = dst.size()-(WORDSIZE*src[OFFSET]);
 				for( j=offset; j<offset+length; j+=WORDSIZE )
 				{
 					// Word is already swapped in the destination vector
-					dst.push_back(dst.at(COPY_BYTE1));
-					dst.push_back(dst.at(COPY_BYTE2));
+					dst.push_back(dst[COPY_BYTE1]);
+					dst.push_back(dst[COPY_BYTE2]);
 				}
 			}
 			inc = WORDSIZE+1;
 			break;
 		case FARTAG:
-			if( src.at(COUNT)==0x00 && src.at(OFFSET_MSB)==0x00 )
+			if( OFFSET_MSB >= srcSize )
+			{
+				gLogging.textOut("Something went wrong with the Carmack compression!\n");
+				return;
+			}
+
+			if( src[COUNT]==0x00 && src[OFFSET_MSB]==0x00 )
 			{
 				dst.push_back(FARTAG);
-				inc = WORDSIZE+1;
 			}
 			else
 			{
-				offset = WORDSIZE*((src.at(OFFSET_MSB)<<8)+src.at(OFFSET_LSB));
-				length = WORDSIZE*src.at(COUNT);
+				offset = WORDSIZE*((src[OFFSET_MSB]<<8)+src[OFFSET_LSB]);
+				length = WORDSIZE*src[COUNT];
 				for( j=offset; j<offset+length; j+=WORDSIZE )
 				{
-					if( j+src.at(COUNT)<dst.size() )
+					if( j+src[COUNT]<dst.size() )
 					{
 						// Word is already swapped in the destination vector
-						dst.push_back(dst.at(COPY_BYTE1));
-						dst.push_back(dst.at(COPY_BYTE2));
+						dst.push_back(dst[COPY_BYTE1]);
+						dst.push_back(dst[COPY_BYTE2]);
 					}
 					else
 					{
@@ -97,8 +125,8 @@ void CCarmack::expand( std::vector<byte>& dst, std::vector<byte>& src )
 			break;
 		default:
 			// Swap the bytes for the word
-			dst.push_back(src.at(TAG));
-			dst.push_back(src.at(COUNT));
+			dst.push_back(src[TAG]);
+			dst.push_back(src[COUNT]);
 			inc = WORDSIZE;
 			break;
 		}
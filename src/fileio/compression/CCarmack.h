@@ -11,12 +11,14 @@
 #define CCARMACK_H_
 
 #include <vector>
+#include <cstddef>
 #include <base/TypeDefinitions.h>
 
 class CCarmack
 {
 public:	
 	void expand( std::vector<byte>& dst, std::vector<byte>& src );
+	void expand( std::vector<byte>& dst, const byte *src, const size_t srcSize );
 };
 
 #endif /* CCARMACK_H_ */
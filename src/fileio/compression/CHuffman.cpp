@@ -8,34 +8,32 @@
 #include "CHuffman.h"
 #include <base/utils/FindFile.h>
 #include <fstream>
-
-const unsigned int DICT_SIG_BYTES = 6;
-const uint8_t DICTSIG[DICT_SIG_BYTES] = { 0xFD, 0x01, 0x00, 0x00, 0x00, 0x00 };
+#include <cstring>
 
 bool CHuffman::readDictionaryNumber( const CExeFile& ExeFile,
                                      const int dictnum,
                                      const unsigned int dictOffset )
 {
-    uint8_t dictnumleft = dictnum;
-
     if( dictOffset == 0) // don't seek to offset
     {
-        uint8_t *data_ptr = ExeFile.getRawData();
+        // Take the dictnum-th dictionary found behind the exe header
+        const ExeSignatureIndex &index = ExeFile.getSignatureIndex();
+        const std::vector<size_t> &sigOffsets = index.offsetsOf(ExeSignatureIndex::HUFFMAN_DICT);
+        const size_t sigBytes = ExeSignatureIndex::signatureSize(ExeSignatureIndex::HUFFMAN_DICT);
+        const size_t rawStart = ExeFile.getRawData() - static_cast<byte*>(ExeFile.getHeaderData());
+
+        int dictnumleft = dictnum;
 
-        for( Uint32 i=0; i<ExeFile.getExeDataSize() ; i++ )
+        for( const size_t sigOffset : sigOffsets )
         {
-            if( memcmp(data_ptr, DICTSIG, DICT_SIG_BYTES) == 0 )
+            if(sigOffset < rawStart)
+                continue;
+
+            if(dictnumleft == 0)
             {
-                if(dictnumleft == 0)
-                {
-                    uint8_t *dictdata = data_ptr-(DICT_SIZE*sizeof(nodestruct))+DICT_SIG_BYTES;
-                    const Uint32 size = DICT_SIZE*sizeof(nodestruct);
-                    memcpy(m_nodes, dictdata, size);
-                    return true;
-                }
-                dictnumleft--;
+                return readDictionaryEndingAt(ExeFile, sigOffset+sigBytes);
             }
-            data_ptr++;
+            dictnumleft--;
         }
         return false;
     }
@@ -49,24 +47,33 @@ bool CHuffman::readDictionaryNumber( const CExeFile& ExeFile,
 
 bool CHuffman::readDictionaryNumberfromEnd(const CExeFile& ExeFile)
 {
-    const uint32_t bytesToCheck = ExeFile.getExeDataSize()-DICT_SIG_BYTES;
-
-    uint8_t *data_ptr = static_cast<uint8_t*>(ExeFile.getHeaderData())+bytesToCheck;
+    const ExeSignatureIndex &index = ExeFile.getSignatureIndex();
+    const std::vector<size_t> &sigOffsets = index.offsetsOf(ExeSignatureIndex::HUFFMAN_DICT);
+    const size_t sigBytes = ExeSignatureIndex::signatureSize(ExeSignatureIndex::HUFFMAN_DICT);
 
-    for( Uint32 i=0; i<bytesToCheck ; i++ )
+    // The very last byte of the exe is never taken as part of a signature
+    for( auto it = sigOffsets.rbegin() ; it != sigOffsets.rend() ; it++ )
     {
-        data_ptr--;
-        if( memcmp(data_ptr, DICTSIG, DICT_SIG_BYTES) == 0 )
+        if(*it + sigBytes < ExeFile.getExeDataSize())
         {
-       		uint8_t *dictdata = data_ptr-(DICT_SIZE*sizeof(nodestruct))+DICT_SIG_BYTES;
-       		const Uint32 size = DICT_SIZE*sizeof(nodestruct);
-       		memcpy(m_nodes, dictdata, size);
-       		return true;
+            return readDictionaryEndingAt(ExeFile, *it+sigBytes);
         }
     }
     return false;
 }
 
+bool CHuffman::readDictionaryEndingAt(const CExeFile& ExeFile, const size_t endOffset)
+{
+    const size_t size = DICT_SIZE*sizeof(nodestruct);
+
+    if(endOffset < size || endOffset > ExeFile.getExeDataSize())
+        return false;
+
+    const byte *dictdata = static_cast<byte*>(ExeFile.getHeaderData())+endOffset-size;
+    memcpy(m_nodes, dictdata, size);
+    return true;
+}
+
 bool CHuffman::readDictionaryFromFile( const std::string &filename )
 {
 	std::ifstream file;
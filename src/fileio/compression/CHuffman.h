@@ -40,6 +40,9 @@ public:
 
 private:
 
+    /// Copies the dictionary whose last byte is right before endOffset of the exe
+    bool readDictionaryEndingAt(const CExeFile& ExeFile, const size_t endOffset);
+
 	nodestruct m_nodes[DICT_SIZE];
 };
 
@@ -4,6 +4,7 @@
  */
 #include <base/GsLogging.h>
 #include <cstdio>
+#include <vector>
 
 #define LZ_STARTBITS        9
 #define LZ_ERRORCODE        256
@@ -13,6 +14,7 @@
 #define LZ_MAXSTRINGSIZE    72
 
 unsigned char *lz_outbuffer;
+unsigned char *lz_outbufferend;
 
 typedef struct stLZDictionaryEntry
 {
@@ -20,10 +22,27 @@ typedef struct stLZDictionaryEntry
 	unsigned char string[LZ_MAXSTRINGSIZE];
 } stLZDictionaryEntry;
 
-stLZDictionaryEntry **lzdict;
+stLZDictionaryEntry *lzdict;
 
-// reads a word of length numbits from file lzfile.
-unsigned int lz_readbits(FILE *lzfile, unsigned char numbits, unsigned char reset)
+// the compressed data which is being read
+const unsigned char *lz_indata;
+size_t lz_insize;
+size_t lz_inpos;
+
+// returns the next byte of the compressed data or -1 if there is nothing left
+int lz_getc()
+{
+	if(lz_inpos >= lz_insize)
+	{
+		lz_inpos = lz_insize+1; // Mark that we have read past the end
+		return -1;
+	}
+
+	return lz_indata[lz_inpos++];
+}
+
+// reads a word of length numbits from the compressed data.
+unsigned int lz_readbits(unsigned char numbits, unsigned char reset)
 {
 	static int mask, byte;
 	unsigned char bitsread;
@@ -43,7 +62,7 @@ unsigned int lz_readbits(FILE *lzfile, unsigned char numbits, unsigned char rese
 	{
         if (!mask)
         {
-			byte = fgetc(lzfile);
+			byte = lz_getc();
 			mask = 0x80;
         }
 		
@@ -64,16 +83,17 @@ void lz_outputdict(int entry)
 {
 	int i;
 	
-	for(i=0;i<lzdict[entry]->stringlen;i++)
+	for(i=0;i<lzdict[entry].stringlen && lz_outbuffer < lz_outbufferend;i++)
 	{
-		*lz_outbuffer = lzdict[entry]->string[i];
+		*lz_outbuffer = lzdict[entry].string[i];
 		lz_outbuffer++;
 	}
 }
 
-// decompresses LZ data from open file lzfile into buffer outbuffer
-// returns nonzero if an error occurs
-char lz_decompress(FILE *lzfile, unsigned char *outbuffer)
+// decompresses the LZ data lzdata of lzsize bytes into buffer outbuffer
+// which has room for outsize bytes. Returns nonzero if an error occurs
+char lz_decompress(const unsigned char *lzdata, const size_t lzsize,
+                   unsigned char *outbuffer, const size_t outsize)
 {
 	unsigned int i;
 	unsigned int numbits;
@@ -84,30 +104,33 @@ char lz_decompress(FILE *lzfile, unsigned char *outbuffer)
 	unsigned int lzcode,lzcode_save,lastcode;
 	char addtodict;
 	
+	lz_indata = lzdata;
+	lz_insize = lzsize;
+	lz_inpos = 0;
+
 	// Get the decompressed file-size
-	decsize = fgetc(lzfile);
-	decsize += fgetc(lzfile) << 8;
-	decsize += fgetc(lzfile) << 16;
-	decsize += fgetc(lzfile) << 24;
+	decsize = lz_getc();
+	decsize += lz_getc() << 8;
+	decsize += lz_getc() << 16;
+	decsize += lz_getc() << 24;
+	(void) decsize;
 	
 	// Get the length of the maximum dictionary size
 	
-	maxdictcodewords = fgetc(lzfile);
-	maxdictcodewords += fgetc(lzfile) << 8;
+	maxdictcodewords = lz_getc();
+	maxdictcodewords += lz_getc() << 8;
+
+	if(lzsize < 6 || maxdictcodewords < LZ_STARTBITS || maxdictcodewords > 16)
+	{
+		gLogging.textOut("lz_decompress(): invalid header of the compressed data!<br>");
+		return 1;
+	}
 	
 	maxdictsize = ((1<<maxdictcodewords)+1);
 	
-	lzdict = new stLZDictionaryEntry*[maxdictsize];
-	// allocate memory for the LZ dictionary
-	for(i=0;i<maxdictsize;i++)
-	{
-		lzdict[i] = new stLZDictionaryEntry;
-		if (!lzdict[i])
-		{
-			gLogging.textOut("lz_decompress(): unable to allocate memory for dictionary!<br>");
-			return 1;
-		}
-	}
+	// allocate memory for the LZ dictionary, all entries at once
+	std::vector<stLZDictionaryEntry> dictionary(maxdictsize);
+	lzdict = dictionary.data();
 	
 	/* initilize the dictionary */
 	
@@ -115,17 +138,17 @@ char lz_decompress(FILE *lzfile, unsigned char *outbuffer)
 	// to their entry number
 	for(i=0;i<256;i++)
 	{
-		lzdict[i]->stringlen = 1;
-		lzdict[i]->string[0] = i;
+		lzdict[i].stringlen = 1;
+		lzdict[i].string[0] = i;
 	}
 	// 256+ start undefined
 	for(i=256;i<maxdictsize;i++)
 	{
-		lzdict[i]->stringlen = 0;
+		lzdict[i].stringlen = 0;
 	}
 	
 	// reset readbits
-	lz_readbits(NULL, 0, 1);
+	lz_readbits(0, 1);
 	
 	// set starting # of bits-per-code
 	numbits = LZ_STARTBITS;
@@ -133,22 +156,27 @@ char lz_decompress(FILE *lzfile, unsigned char *outbuffer)
 	
 	// point the global pointer to the buffer we were passed
 	lz_outbuffer = outbuffer;
+	lz_outbufferend = outbuffer + outsize;
 	
 	// setup where to start adding strings to the dictionary
 	dictindex = LZ_DICTSTARTCODE;
 	addtodict = 1;                    // enable adding to dictionary
 	
 	// read first code
-	lastcode = lz_readbits(lzfile, numbits, 0);
+	lastcode = lz_readbits(numbits, 0);
 	lz_outputdict(lastcode);
 	do
 	{
 		// read the next code from the compressed data stream
-		lzcode = lz_readbits(lzfile, numbits, 0);
+		lzcode = lz_readbits(numbits, 0);
 		lzcode_save = lzcode;
 		
 		if (lzcode==LZ_ERRORCODE || lzcode==LZ_EOFCODE)
 			break;
+
+		// Data is truncated or broken, stop instead of reading garbage forever
+		if (lz_inpos > lz_insize || lzcode >= maxdictsize)
+			break;
 		
 		// if the code is present in the dictionary,
 		// lookup and write the string for that code, then add the
@@ -159,7 +187,7 @@ char lz_decompress(FILE *lzfile, unsigned char *outbuffer)
 		// last string to the dictionary at dictindex (which will be equal
 		// to lzcode), then lookup and write string lzcode.
 		
-		if (lzdict[lzcode]->stringlen==0)
+		if (lzdict[lzcode].stringlen==0)
 			// code is not present in dictionary
 			lzcode = lastcode;
 		
@@ -167,14 +195,14 @@ char lz_decompress(FILE *lzfile, unsigned char *outbuffer)
 		{
 			// copies string lastcode to string dictindex, then
 			// concatenates the first character of string lzcode.
-			for(i=0 ; i< (unsigned int) lzdict[lastcode]->stringlen ; i++)
-				lzdict[dictindex]->string[i] = lzdict[lastcode]->string[i];
+			for(i=0 ; i< (unsigned int) lzdict[lastcode].stringlen ; i++)
+				lzdict[dictindex].string[i] = lzdict[lastcode].string[i];
 			
-			lzdict[dictindex]->string[i] = lzdict[lzcode]->string[0];
-			lzdict[dictindex]->stringlen = (lzdict[lastcode]->stringlen + 1);
+			lzdict[dictindex].string[i] = lzdict[lzcode].string[0];
+			lzdict[dictindex].stringlen = (lzdict[lastcode].stringlen + 1);
 			
 			// ensure we haven't overflowed the buffer
-			if (lzdict[dictindex]->stringlen >= (LZ_MAXSTRINGSIZE-1))
+			if (lzdict[dictindex].stringlen >= (LZ_MAXSTRINGSIZE-1))
 			{
 				gLogging.ftextOut("lz_decompress(): lzdict[%d]->stringlen is too long...max length is %d<br>", dictindex, LZ_MAXSTRINGSIZE);
 				return 1;
@@ -205,11 +233,7 @@ char lz_decompress(FILE *lzfile, unsigned char *outbuffer)
 		lastcode = lzcode_save;
 	} while(1);
 	
-	/* free the memory used by the LZ dictionary */
-	for(i=0;i<maxdictsize;i++)
-		delete lzdict[i];
-	
-	delete [] lzdict;
+	lzdict = NULL;
 	
 	return 0;
 }
@@ -1 +1,4 @@
-char lz_decompress(FILE *lzfile, unsigned char *outbuffer);
+#include <cstddef>
+
+char lz_decompress(const unsigned char *lzdata, const size_t lzsize,
+                   unsigned char *outbuffer, const size_t outsize);
@@ -13,6 +13,9 @@
 #include "sdl/audio/music/CMusic.h"
 
 #include <fstream>
+#include <algorithm>
+#include <functional>
+#include <chrono>
 
 
 // This central list tells which frequencies can be used for your soundcard.
@@ -39,6 +42,17 @@ static const int availableRates[numAvailableRates]=
 #endif
 
 
+// Sounds the game may queue between two callbacks
+static const size_t SoundQueueSize = 256;
+
+// Timestamps of queued sounds, from a monotonic clock
+static Uint64 microsNow()
+{
+    return Uint64(std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+
 // define a callback function we can work with
 inline static void CCallback(void *unused, Uint8 *stream, int len)
 {
@@ -58,6 +72,8 @@ mPauseGameplay(false)
 	mAudioSpec.format = AUDIO_S16; // 16-bit sound
 	mAudioSpec.freq = 44100; // high quality
 
+    mCommandRing.reserve(SoundQueueSize);
+
     updateFuncPtrs();
 }
 
@@ -121,25 +137,63 @@ bool Audio::init()
     //gLogging << "Using audio driver: "  << SDL_AudioDriverName(name, 32) << " <br>";
 #endif
 
-    const unsigned int channels = 32;
-
-    mSndChnlVec.clear();
-
-    mSndChnlVec.assign(channels, CSoundChannel(mAudioSpec));
+    setupChannels();
 
     SDL_PauseAudio(0);
 
     gLogging << "Sound System: SDL sound system initialized.<br>";
 
-	// Let's initialize the OPL Emulator here!
-	m_OPL_Player.init();
-
     updateFuncPtrs();
 
 	return true;
 }
 
 
+bool Audio::initNullSink()
+{
+    gLogging.ftextOut("Starting the sound driver without a sound device...<br>");
+
+    mAudioSpec.silence = 0;
+    mAudioSpec.samples = 1024;
+    mAudioSpec.callback = nullptr;
+    mAudioSpec.userdata = nullptr;
+    const Uint32 bytesPerSample = (mAudioSpec.format == AUDIO_U8) ? 1 : 2;
+    mAudioSpec.size = mAudioSpec.samples * mAudioSpec.channels * bytesPerSample;
+
+    mMixedForm.resize(mAudioSpec.size);
+    mNullSinkForm.resize(mAudioSpec.size);
+
+    setupChannels();
+
+    updateFuncPtrs();
+
+    return true;
+}
+
+void Audio::mixNullSink(const Uint32 len)
+{
+    const Uint32 bufferSize = Uint32(mNullSinkForm.size());
+
+    for(Uint32 mixed = 0 ; mixed < len ; mixed += bufferSize)
+    {
+        const Uint32 part = std::min(len - mixed, bufferSize);
+        SDL_memset(mNullSinkForm.data(), mAudioSpec.silence, part);
+        callback(nullptr, mNullSinkForm.data(), int(part));
+    }
+}
+
+void Audio::setupChannels()
+{
+    const unsigned int channels = NumVirtualVoices;
+
+    mSndChnlVec.clear();
+    mMixOrder.reserve(channels);
+
+    mSndChnlVec.assign(channels, CSoundChannel(mAudioSpec));
+    mVoices.setup(channels, mpAudioRessources ? mpAudioRessources->getNumberofSounds() : 0);
+}
+
+
 void (*mixAudio)(Uint8*, const Uint8*, Uint32, Uint32);
 
 void mixAudioUnsigned8(Uint8 *dst, const Uint8 *src, Uint32 len, Uint32 volume);
@@ -176,17 +230,44 @@ void Audio::destroy()
     if(!mSndChnlVec.empty())
         mSndChnlVec.clear();
 
-	// Shutdown the OPL Emulator here!
-	gLogging.ftextOut("SoundDrv_Stop(): shut down.<br>");
+    mVoices.setup(0, 0);
 
-	m_OPL_Player.shutdown();
+    const QueueLatency latency = getQueueLatency();
+    if(latency.sounds > 0)
+    {
+        gLogging.ftextOut("Queued sounds: %lu, waited %lu us on average, %lu us at most<br>",
+                          static_cast<unsigned long>(latency.sounds),
+                          static_cast<unsigned long>(latency.totalMicros/latency.sounds),
+                          static_cast<unsigned long>(latency.maxMicros));
+    }
+
+	gLogging.ftextOut("SoundDrv_Stop(): shut down.<br>");
 }
 
 // stops all currently playing sounds
 void Audio::stopAllSounds()
 {
-    for( auto &snd_chnl : mSndChnlVec )
-		snd_chnl.stopSound();
+    SDL_LockAudio();
+
+    // Whatever was queued would be stopped right away
+    SoundCommand command;
+    while(mCommandRing.pop(&command, 1) == 1)
+        unpinSlot(command.slot);
+
+    stopAllVoices();
+
+    SDL_UnlockAudio();
+}
+
+void Audio::stopAllVoices()
+{
+    for( int voice = mVoices.firstActive() ; voice != CVoiceManager::NoVoice ;
+         voice = mVoices.nextActive(voice) )
+    {
+        mSndChnlVec[voice].stopSound();
+    }
+
+    mVoices.releaseAll();
 }
 
 // pauses any currently playing sounds
@@ -204,47 +285,72 @@ void Audio::resumeAudio()
 // returns true if sound snd is currently playing
 bool Audio::isPlaying(const GameSound snd)
 {
-    std::vector<CSoundChannel>::iterator snd_chnl = mSndChnlVec.begin();
-    for( ; snd_chnl != mSndChnlVec.end() ; snd_chnl++ )
-	{
-		if (snd_chnl->isPlaying())
-		{
-			CSoundSlot *pSlotToStop = mpAudioRessources->getSlotPtrAt(snd);
-			if (snd_chnl->getCurrentSoundPtr() == pSlotToStop)
-				return true;
-		}
-	}
-	return false;
+    const int slot = slotOfSound(snd);
+
+    if( slot < 0 || !mpAudioRessources )
+        return false;
+
+    // It might be played as PC Speaker or as AdLib sound
+    const unsigned int speaker_snds_end_off = mpAudioRessources->getNumberofSounds()/2;
+
+    // The callback releases the voices of finished sounds
+    SDL_LockAudio();
+    const bool playing = mVoices.isSlotActive(slot) ||
+                         mVoices.isSlotActive(slot+speaker_snds_end_off);
+    SDL_UnlockAudio();
+
+    return playing;
 }
 
 // if sound snd is currently playing, stop it immediately
 void Audio::stopSound(const GameSound snd)
 {
-    std::vector<CSoundChannel>::iterator snd_chnl = mSndChnlVec.begin();
-    for( ; snd_chnl != mSndChnlVec.end() ; snd_chnl++)
-	{
-		if (snd_chnl->isPlaying())
-		{
-			CSoundSlot *pSlotToStop =  mpAudioRessources->getSlotPtrAt(snd);
-			if( snd_chnl->getCurrentSoundPtr() == pSlotToStop )
-				snd_chnl->stopSound();
-		}
-	}
+    const int slot = slotOfSound(snd);
+
+    if( slot < 0 || !mpAudioRessources )
+        return;
+
+    const unsigned int speaker_snds_end_off = mpAudioRessources->getNumberofSounds()/2;
+    const unsigned int slots[2] = { unsigned(slot), slot+speaker_snds_end_off };
+
+    SDL_LockAudio();
+
+    // A queued start must not come after the stop
+    startQueuedSounds(microsNow(), 0);
+
+    for( const auto stopSlot : slots )
+    {
+        int voice;
+        while( (voice = mVoices.firstVoiceOf(stopSlot)) != CVoiceManager::NoVoice )
+        {
+            mSndChnlVec[voice].stopSound();
+            mVoices.release(voice);
+        }
+    }
+
+    SDL_UnlockAudio();
 }
 
 // returns true if a sound is currently playing in SoundPlayMode::PLAY_FORCE mode
 bool Audio::forcedisPlaying()
 {
-    std::vector<CSoundChannel>::iterator snd_chnl = mSndChnlVec.begin();
-    for( ; snd_chnl != mSndChnlVec.end() ; snd_chnl++)
+    bool forced = false;
+
+    SDL_LockAudio();
+
+    for( int voice = mVoices.firstActive() ; voice != CVoiceManager::NoVoice ;
+         voice = mVoices.nextActive(voice) )
     {
-		if(snd_chnl->isForcedPlaying())
+        if(mSndChnlVec[voice].isForcedPlaying())
         {
-			return true;
+            forced = true;
+            break;
         }
     }
 
-	return false;
+    SDL_UnlockAudio();
+
+	return forced;
 }
 
 void Audio::callback(void *unused,
@@ -265,6 +371,8 @@ void Audio::callback(void *unused,
 		return;
     }
 
+    startQueuedSounds(microsNow(), Uint32(len));
+
     mMixedForm.resize(len);
 
     Uint8* buffer = mMixedForm.data();
@@ -275,16 +383,54 @@ void Audio::callback(void *unused,
         mixAudio(stream, buffer, len, m_MusicVolume);
     }
 
-    bool any_sound_playing = false;
-    std::vector<CSoundChannel>::iterator snd_chnl = mSndChnlVec.begin();
-    for( ; snd_chnl != mSndChnlVec.end() ; snd_chnl++)
+    // Finished sounds give their channel back, idle channels are not visited at all
+    mMixOrder.clear();
+
+    int voice = mVoices.firstActive();
+    while( voice != CVoiceManager::NoVoice )
    	{
-		if(snd_chnl->isPlaying())
-		{
-			any_sound_playing |= true;
-            snd_chnl->readWaveform( buffer, len );
+        const int nextVoice = mVoices.nextActive(voice);
+
+		if(mSndChnlVec[voice].isPlaying())
+            mMixOrder.push_back( std::make_pair(mixRank(voice), voice) );
+        else
+            mVoices.release(voice);
+
+        voice = nextVoice;
+    }
+
+    const bool any_sound_playing = !mMixOrder.empty();
+
+    // Only the top ranked channels are mixed, so the cost has a fixed ceiling
+    const size_t numMixed = std::min(mMixOrder.size(), size_t(MaxMixedVoices));
+
+    if(mMixOrder.size() > numMixed)
+    {
+        std::nth_element(mMixOrder.begin(), mMixOrder.begin()+numMixed, mMixOrder.end(),
+                         std::greater< std::pair<Uint64, int> >());
+    }
+
+    for( size_t i = 0 ; i < mMixOrder.size() ; i++ )
+    {
+        const Uint64 rank = mMixOrder[i].first;
+        const int rankedVoice = mMixOrder[i].second;
+        CSoundChannel &sndChnl = mSndChnlVec[rankedVoice];
+
+        // The others keep their position going, so they are in time once they become audible again
+        if( i < numMixed && (rank & 0xFFFFFFFF) != 0 )
+        {
+            sndChnl.readWaveform( buffer, len );
             mixAudio(stream, buffer, len, m_SoundVolume);
-		}
+        }
+        else
+        {
+            sndChnl.skipWaveform( len );
+        }
+
+        if(!sndChnl.isPlaying())
+        {
+            mVoices.release(rankedVoice);
+        }
     }
 
 	if(!any_sound_playing)
@@ -297,12 +443,127 @@ void Audio::callback(void *unused,
 }
 
 
+Uint64 Audio::mixRank(const int voice) const
+{
+    const CSoundChannel &sndChnl = mSndChnlVec[voice];
+    const Uint64 forced = sndChnl.isForcedPlaying() ? 1 : 0;
+    const Uint64 priority = sndChnl.getCurrentSoundPtr()->priority;
+    const Uint64 gain = Uint64(sndChnl.audibleGain()) * m_SoundVolume;
+
+    return (forced << 48) | (priority << 32) | gain;
+}
+
+
 void Audio::playSound(const GameSound snd,
                       const SoundPlayMode mode )
 {
 	playStereosound(snd, mode, 0);
 }
 
+void Audio::queueSound(const GameSound snd,
+                       const SoundPlayMode mode )
+{
+    if( mSndChnlVec.empty() ) return;
+
+    if( !mpAudioRessources ) return;
+
+    int slotplay = slotOfSound(snd);
+
+    if (slotplay < 0)
+        return;
+
+    const int speaker_snds_end_off = mpAudioRessources->getNumberofSounds()/2;
+
+    if (slotplay >= speaker_snds_end_off)
+        return;
+
+    if (mUseSoundBlaster && mpAudioRessources->hasSound(slotplay+speaker_snds_end_off))
+        slotplay += speaker_snds_end_off;
+
+    // PLAY_NORESTART is checked by the callback when it starts the sound,
+    // so the game never looks at the voices without the audio lock.
+
+    // Pinned before it's prepared, so no other thread can unload it from the cache meanwhile
+    pinSlot(slotplay);
+
+    SoundCommand command;
+    command.micros = microsNow();
+    command.pSlot = mpAudioRessources->prepareSlot(slotplay);
+    command.slot = static_cast<unsigned char>(slotplay);
+    command.mode = mode;
+    command.balance = 0;
+
+    // The gameplay has to wait right away, not only once the callback got the sound
+    if(mode == SoundPlayMode::PLAY_PAUSEALL)
+    {
+        mPauseGameplay = true;
+    }
+
+    // Only if the callback didn't run for a long time. Then it's played the old way.
+    if(mCommandRing.push(&command, 1) == 0)
+    {
+        playStereosoundSlot(command.slot, mode, 0);
+        unpinSlot(command.slot);
+    }
+}
+
+void Audio::pinSlot(const unsigned int slot)
+{
+    if(slot < mNumSlotPins)
+        mpSlotPins[slot].fetch_add(1, std::memory_order_acq_rel);
+}
+
+void Audio::unpinSlot(const unsigned int slot)
+{
+    if(slot < mNumSlotPins)
+        mpSlotPins[slot].fetch_sub(1, std::memory_order_acq_rel);
+}
+
+Audio::QueueLatency Audio::getQueueLatency() const
+{
+    QueueLatency latency;
+    latency.sounds = mQueuedSounds.load(std::memory_order_relaxed);
+    latency.totalMicros = mQueueMicros.load(std::memory_order_relaxed);
+    latency.maxMicros = mQueueMaxMicros.load(std::memory_order_relaxed);
+    return latency;
+}
+
+void Audio::startQueuedSounds(const Uint64 now, const Uint32 len)
+{
+    const Uint32 frameSize = ((mAudioSpec.format & 0xFF)/8) * mAudioSpec.channels;
+    const Uint32 frames = (frameSize > 0) ? len/frameSize : 0;
+
+    SoundCommand command;
+    while(mCommandRing.pop(&command, 1) == 1)
+    {
+        const Uint64 waited = (now > command.micros) ? (now - command.micros) : 0;
+
+        mQueuedSounds.store(mQueuedSounds.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        mQueueMicros.store(mQueueMicros.load(std::memory_order_relaxed) + waited, std::memory_order_relaxed);
+        if(waited > mQueueMaxMicros.load(std::memory_order_relaxed))
+            mQueueMaxMicros.store(waited, std::memory_order_relaxed);
+
+        // Everything is heard one buffer later than it was queued, but with the
+        // same spacing the game had, instead of all at the start of the buffer.
+        Uint32 startDelay = 0;
+        if(frames > 0 && mLastCallbackMicros > 0 && command.micros > mLastCallbackMicros)
+        {
+            const Uint64 frame = (command.micros - mLastCallbackMicros) * Uint64(mAudioSpec.freq) / 1000000;
+            startDelay = Uint32(std::min(frame, Uint64(frames-1))) * frameSize;
+        }
+
+        startVoice(*command.pSlot, command.slot, command.mode, command.balance, startDelay);
+
+        // Playing now, or it never will
+        unpinSlot(command.slot);
+    }
+
+    if(len > 0)
+    {
+        mLastCallbackMicros = now;
+    }
+}
+
 void Audio::playStereofromCoord(const GameSound snd,
                                 const SoundPlayMode mode,
                                 const int xCoord )
@@ -336,15 +597,17 @@ void Audio::playStereosound(const GameSound snd,
 
     if( !mpAudioRessources ) return;
 
-	CSoundSlot *mp_Slots = mpAudioRessources->getSlotPtr();
-    int slotplay = sndSlotMap[snd];
+    int slotplay = slotOfSound(snd);
+
+    if (slotplay < 0)
+        return;
 
 	const int speaker_snds_end_off = mpAudioRessources->getNumberofSounds()/2;
 
     if (slotplay >= speaker_snds_end_off)
 		return;
 
-    if (mUseSoundBlaster && mp_Slots[slotplay+speaker_snds_end_off].getSoundData())
+    if (mUseSoundBlaster && mpAudioRessources->hasSound(slotplay+speaker_snds_end_off))
 		slotplay += speaker_snds_end_off;
 
     if (mode == SoundPlayMode::PLAY_NORESTART && isPlaying(snd))
@@ -358,8 +621,11 @@ void Audio::playStereosoundSlot(unsigned char slotplay,
                                 const SoundPlayMode mode,
                                 const short balance)
 {
-    CSoundSlot *pSlots = mpAudioRessources->getSlotPtr();
-    CSoundSlot &chosenSlot = pSlots[slotplay];
+    // Kept loaded until its voice has started
+    pinSlot(slotplay);
+
+    // AdLib effects are rendered here if they are not cached yet
+    CSoundSlot &chosenSlot = *mpAudioRessources->prepareSlot(slotplay);
 
     if(mode == SoundPlayMode::PLAY_PAUSEALL)
     {
@@ -372,26 +638,81 @@ void Audio::playStereosoundSlot(unsigned char slotplay,
 		stopAllSounds();
     }
 
-	// first try to find an empty channel
-    std::vector<CSoundChannel>::iterator sndChnl;
-    for( sndChnl = mSndChnlVec.begin() ; sndChnl != mSndChnlVec.end() ; sndChnl++)
-	{
-        CSoundSlot &currentSlot = *sndChnl->getCurrentSoundPtr();
+    SDL_LockAudio();
 
-        if (!sndChnl->isPlaying()
-            ||
-            chosenSlot.priority >= currentSlot.priority )
-		{
-			if(mAudioSpec.channels == 2)
+    // Queued sounds came first
+    startQueuedSounds(microsNow(), 0);
+
+    startVoice(chosenSlot, slotplay, mode, balance, 0);
+    unpinSlot(slotplay);
+
+    SDL_UnlockAudio();
+}
+
+void Audio::startVoice(CSoundSlot &chosenSlot,
+                       const unsigned char slotplay,
+                       const SoundPlayMode mode,
+                       const short balance,
+                       const Uint32 startDelay)
+{
+    if ( slotplay >= mVoices.numSlots() )
+    {
+        return;
+    }
+
+    if ( mode == SoundPlayMode::PLAY_FORCE )
+    {
+        stopAllVoices();
+    }
+    else if ( mode == SoundPlayMode::PLAY_NORESTART &&
+              mVoices.firstVoiceOf(slotplay) != CVoiceManager::NoVoice )
+    {
+        return;
+    }
+
+    // A sound which is already playing is restarted on its channel,
+    // otherwise an idle channel is taken.
+    int voice = mVoices.firstVoiceOf(slotplay);
+
+    if(voice == CVoiceManager::NoVoice)
+    {
+        voice = mVoices.allocate(slotplay);
+    }
+
+    if(voice == CVoiceManager::NoVoice)
+    {
+        // All virtual channels are busy. The least important sound has to give way,
+        // unless it is more important than the new one.
+        int lowest = CVoiceManager::NoVoice;
+        for( int v = mVoices.firstActive() ; v != CVoiceManager::NoVoice ; v = mVoices.nextActive(v) )
+        {
+            if( lowest == CVoiceManager::NoVoice ||
+                mSndChnlVec[v].getCurrentSoundPtr()->priority < mSndChnlVec[lowest].getCurrentSoundPtr()->priority )
             {
-                sndChnl->setBalance(balance);
+                lowest = v;
             }
+        }
 
-            sndChnl->setupSound(chosenSlot,
-                                (mode==SoundPlayMode::PLAY_FORCE) ? true : false );
-			break;
-		}
-	}
+        if( lowest == CVoiceManager::NoVoice ||
+            chosenSlot.priority < mSndChnlVec[lowest].getCurrentSoundPtr()->priority )
+        {
+            return;
+        }
+
+        voice = lowest;
+        mVoices.reassign(voice, slotplay);
+    }
+
+    CSoundChannel &sndChnl = mSndChnlVec[voice];
+
+    if(mAudioSpec.channels == 2)
+    {
+        sndChnl.setBalance(balance);
+    }
+
+    sndChnl.setupSound(chosenSlot,
+                       (mode==SoundPlayMode::PLAY_FORCE) ? true : false,
+                       startDelay );
 }
 
 void Audio::setupSoundData(const std::map<GameSound, int> &slotMap,
@@ -399,25 +720,70 @@ void Audio::setupSoundData(const std::map<GameSound, int> &slotMap,
 {
     assert(audioResPtr);
 
+    // The channels must not point into the slots which are about to be replaced
+    stopAllSounds();
+
     SDL_LockAudio();
 
-    sndSlotMap = slotMap;
+    int numSounds = 0;
+    for( const auto &entry : slotMap )
+        numSounds = std::max(numSounds, int(entry.first)+1);
+
+    mSlotOfSound.assign(numSounds, -1);
+    for( const auto &entry : slotMap )
+        mSlotOfSound[entry.first] = entry.second;
+
     mpAudioRessources.reset(audioResPtr);
 
+    // The voices keep a list per slot which must fit the new resources.
+    // It's never resized while the audio callback plays the sounds.
+    mVoices.setup(mSndChnlVec.size(), mpAudioRessources->getNumberofSounds());
+
+    // Nothing is queued anymore, stopAllSounds() has dropped it
+    mNumSlotPins = mpAudioRessources->getNumberofSounds();
+    mpSlotPins.reset( new std::atomic<unsigned int>[mNumSlotPins]() );
+
     SDL_UnlockAudio();
 }
 
+void Audio::prefetchSounds(const std::vector<GameSound> &sounds)
+{
+    if( !mpAudioRessources || !mUseSoundBlaster ) return;
+
+    const int speaker_snds_end_off = mpAudioRessources->getNumberofSounds()/2;
+
+    std::vector<unsigned int> slots;
+    for( const auto snd : sounds )
+    {
+        const int slot = slotOfSound(snd);
+        if( slot < 0 || slot >= speaker_snds_end_off )
+            continue;
+
+        slots.push_back(slot + speaker_snds_end_off);
+    }
+
+    mpAudioRessources->prefetchSlots(slots);
+}
+
 void Audio::unloadSoundData()
 {
+    stopAllSounds();
+
     // Wait for callback to finish running...
     while(mCallbackRunning);
 
+    std::unique_ptr<CAudioResources> audioRessources;
+
     SDL_LockAudio();
 
-    mpAudioRessources.release();
+    audioRessources.swap(mpAudioRessources);
     mMixedForm.clear();
 
     SDL_UnlockAudio();
+
+    // Destroyed without the audio lock, because it waits for its workers
+    // and those take the lock when they trim the effect cache.
+    audioRessources.reset();
 }
 
 
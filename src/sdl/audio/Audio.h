@@ -20,10 +20,19 @@
 #include <vector>
 #include <list>
 #include <memory>
+#include <atomic>
+
+#include "CRingBuffer.h"
 
 #include "sound/CSoundChannel.h"
+#include "sound/CVoiceManager.h"
 #include "CAudioResources.h"
 
+// Sounds which can be played at the same time. Only the most important
+// of them are mixed, the others keep playing silently.
+const unsigned int NumVirtualVoices = 64;
+const unsigned int MaxMixedVoices = 16;
+
 class Audio : public GsSingleton<Audio>
 {
 public:
@@ -31,6 +40,19 @@ public:
     ~Audio();
 
 	bool init();
+
+    /**
+     * @brief initNullSink Sets up everything like init, but opens no sound device.
+     *        Nothing calls the callback then, mixNullSink has to be called instead.
+     *        Used by the headless benchmarks.
+     */
+    bool initNullSink();
+
+    /**
+     * @brief mixNullSink Runs the callback for len bytes right away and throws the samples away
+     */
+    void mixNullSink(const Uint32 len);
+
 	void stop();
 
 	void stopAllSounds();
@@ -49,6 +71,27 @@ public:
 	void playSound(	const GameSound snd,
                     const SoundPlayMode mode = SoundPlayMode::PLAY_NOW );
 
+    /**
+     * @brief queueSound Like playSound, but the sound is started by the audio callback.
+     *        No lock is taken, so the game may do this as often as it likes.
+     *        The sound begins at the sample of the next callback which matches the time of the call.
+     *        Only one thread may queue sounds.
+     * @param snd
+     * @param mode
+     */
+    void queueSound( const GameSound snd,
+                     const SoundPlayMode mode = SoundPlayMode::PLAY_NOW );
+
+    /// How long queued sounds waited for the audio callback
+    struct QueueLatency
+    {
+        Uint64 sounds = 0;
+        Uint64 totalMicros = 0;
+        Uint64 maxMicros = 0;
+    };
+
+    QueueLatency getQueueLatency() const;
+
     /**
      * @brief playStereofromCoord  Play one sound
      * @param snd       sound number to play
@@ -80,6 +123,17 @@ public:
                              const short balance);
 
 	bool isPlaying(const GameSound snd);
+
+    /**
+     * @brief isSlotInUse tells whether any channel is playing the given slot or a queued sound
+     *                    is about to. Such a slot must not be unloaded. The audio lock must be held.
+     */
+    bool isSlotInUse(const unsigned int slot) const
+    {
+        return mVoices.isSlotActive(slot) ||
+               (slot < mNumSlotPins && mpSlotPins[slot].load(std::memory_order_acquire) > 0);
+    }
+
 	void stopSound(const GameSound snd);
 	void destroy();
 
@@ -91,7 +145,6 @@ public:
 
 	const SDL_AudioSpec	&getAudioSpec() const  { return const_cast<const SDL_AudioSpec&>(mAudioSpec); }
     bool getSoundBlasterMode() {	return mUseSoundBlaster;	}
-    COPLEmulator &getOPLEmulatorRef() { return m_OPL_Player; }
 
 	void setSettings( const int rate,
 							  const int channels,
@@ -112,6 +165,12 @@ public:
     void setupSoundData(const std::map<GameSound, int> &slotMap,
                                CAudioResources *audioResPtr);
 
+    /**
+     * @brief prefetchSounds Renders the AdLib effects of the given sounds in the background,
+     *        so they don't have to be rendered when they are played for the first time.
+     */
+    void prefetchSounds(const std::vector<GameSound> &sounds);
+
 	void unloadSoundData();
 
 	// Tell whether a sound is played which has to stop the gameplay
@@ -133,8 +192,16 @@ protected:
 
 private:
 
+    /// Slot of the PC Speaker version of snd, or -1 if the game doesn't have that sound
+    int slotOfSound(const GameSound snd) const
+    {   return (size_t(snd) < mSlotOfSound.size()) ? mSlotOfSound[snd] : -1;  }
+
     // Channels of sound which can be played at the same time.
     std::vector<CSoundChannel>	mSndChnlVec;
+
+    // Tells which of the channels are idle and which ones play what slot.
+    // Only changed inside the callback or while holding the audio lock.
+    CVoiceManager mVoices;
     std::unique_ptr<CAudioResources> mpAudioRessources;
 	Uint8 m_MusicVolume;
 	Uint8 m_SoundVolume;
@@ -145,9 +212,69 @@ private:
 	std::vector<Uint8> mMixedForm;	// Mainly used by the callback function. Declared once and allocated
                                     // for the whole runtime
 
-    std::map<GameSound, int> sndSlotMap;
+    std::vector<Uint8> mNullSinkForm;   // Where mixNullSink lets the callback mix into
+
+    /// Creates the channels for the current audio spec
+    void setupChannels();
+
+    /**
+     * @brief startVoice Puts the slot on a channel. The audio lock must be held or it's the callback itself.
+     * @param startDelay bytes of silence before the sound begins
+     */
+    void startVoice(CSoundSlot &chosenSlot,
+                    const unsigned char slotplay,
+                    const SoundPlayMode mode,
+                    const short balance,
+                    const Uint32 startDelay);
+
+    /// Stops every channel. The audio lock must be held or it's the callback itself.
+    void stopAllVoices();
+
+    /**
+     * @brief startQueuedSounds Starts what the game has queued. Called by the callback,
+     *        or with the audio lock held and len 0, which starts everything right away.
+     * @param now   time of the call in microseconds
+     * @param len   bytes of the buffer the sounds are placed into
+     */
+    void startQueuedSounds(const Uint64 now, const Uint32 len);
+
+    /// A sound queued by the game
+    struct SoundCommand
+    {
+        Uint64 micros;          // When the game asked for it
+        CSoundSlot *pSlot;
+        unsigned char slot;
+        SoundPlayMode mode;
+        short balance;
+    };
+
+    // Filled by the game thread, emptied by the callback, so neither waits for the other
+    RingBuffer<SoundCommand> mCommandRing;
+
+    /// Keeps the slot of a queued sound loaded until the callback has taken the command
+    void pinSlot(const unsigned int slot);
+    void unpinSlot(const unsigned int slot);
+
+    // Queued sounds per slot. Raised by the game thread, lowered by whoever takes the command.
+    std::unique_ptr< std::atomic<unsigned int>[] > mpSlotPins;
+    unsigned int mNumSlotPins = 0;
+
+    // Time of the previous callback. Queued sounds keep the spacing they had from there on.
+    Uint64 mLastCallbackMicros = 0;
+
+    std::atomic<Uint64> mQueuedSounds{0};
+    std::atomic<Uint64> mQueueMicros{0};
+    std::atomic<Uint64> mQueueMaxMicros{0};
+
+    /// Ranks a playing channel for the mixer. Forced sounds first, then by priority and audible gain.
+    Uint64 mixRank(const int voice) const;
+
+    // Playing channels of the current callback with their rank, preallocated
+    std::vector< std::pair<Uint64, int> > mMixOrder;
+
+    // Indexed by GameSound, so the lookup is done without searching
+    std::vector<int> mSlotOfSound;
 
-    COPLEmulator m_OPL_Player;
     bool mPauseGameplay;
 };
 
@@ -12,114 +12,560 @@
 #include <base/GsLogging.h>
 #include "Audio.h"
 
-CAudioResources::CAudioResources()
-{}
+#include "fileio/crc.h"
+#include <base/utils/StringUtils.h>
 
-bool CAudioResources::readISFintoWaveForm( CSoundSlot &soundslot, const byte *imfdata, const Uint8 formatsize )
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+
+// Layout of the effect cache file. It is only read on the machine which
+// wrote it, so the values are stored in the native byte order.
+const char EffectCacheMagic[8] = { 'C','G','A','D','L','F','X','\0' };
+const uint32_t EffectCacheFormatVersion = 1;
+
+struct EffectCacheHeader
+{
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t emulatorVersion;
+    uint32_t effectsHash;
+    uint32_t freq;
+    uint32_t format;
+    uint32_t channels;
+    uint32_t numEntries;
+};
+
+struct EffectCacheEntry
+{
+    uint32_t slot;
+    uint32_t offset;
+    uint32_t length;
+};
+
+EffectCacheHeader makeEffectCacheHeader(const SDL_AudioSpec &audioSpec,
+                                        const uint32_t effectsHash,
+                                        const uint32_t numEntries)
+{
+    EffectCacheHeader header;
+    memcpy(header.magic, EffectCacheMagic, sizeof(header.magic));
+    header.formatVersion = EffectCacheFormatVersion;
+    header.emulatorVersion = OPL_EMULATOR_VERSION;
+    header.effectsHash = effectsHash;
+    header.freq = uint32_t(audioSpec.freq);
+    header.format = uint32_t(audioSpec.format);
+    header.channels = uint32_t(audioSpec.channels);
+    header.numEntries = numEntries;
+    return header;
+}
+
+// Every audio format has a cache file of its own
+std::string effectCacheFilename(const std::string &path, const SDL_AudioSpec &audioSpec)
+{
+    const std::string filename = "adlibfx_" + itoa(audioSpec.freq) + "_" +
+                                 itoa(audioSpec.format) + "_" +
+                                 itoa(audioSpec.channels) + ".cache";
+    return GetWriteFullFileName(JoinPaths(path, filename), true);
+}
+
+}
+
+
+/**
+ * Renders a list of AdLib effects in the background
+ */
+class ISFPrefetch : public Action
+{
+public:
+    ISFPrefetch(CAudioResources &resources, const std::vector<unsigned int> &slots) :
+        mResources(resources),
+        mSlots(slots),
+        mAudioSpec(resources.mAudioSpec)
+    {
+        mOPL.setup(mAudioSpec.freq);
+    }
+
+    int handle()
+    {
+        for(const unsigned int slot : mSlots)
+        {
+            std::vector<byte> isf;
+
+            {
+                std::lock_guard<std::mutex> lock(mResources.mCacheMutex);
+
+                if(mResources.mCancelPrefetch)
+                    break;
+
+                if(slot >= mResources.mISFData.size() ||
+                   mResources.mISFData[slot].empty() ||
+                   mResources.m_soundslot[slot].getSoundlength() > 0)
+                {
+                    continue;
+                }
+
+                // Effects of the cache file are only mapped, so that's quick
+                if(mResources.isEffectCached(slot))
+                {
+                    mResources.renderISF(slot);
+                    continue;
+                }
+
+                isf = mResources.mISFData[slot];
+            }
+
+            // Rendered without the lock, so the game doesn't wait for it when it plays a sound
+            CSoundSlot rendered;
+            const bool ok = mResources.readISFintoWaveForm(rendered, isf.data(), mOPL, mAudioSpec);
+
+            std::lock_guard<std::mutex> lock(mResources.mCacheMutex);
+
+            // The game might have rendered it meanwhile
+            if(mResources.m_soundslot[slot].getSoundlength() > 0)
+                continue;
+
+            if(!ok)
+            {
+                gLogging << "Sound " << slot << " could not be rendered!<br>";
+                mResources.mISFData[slot].clear();
+                continue;
+            }
+
+            mResources.addRendered(slot, rendered);
+        }
+        return 0;
+    }
+
+private:
+    CAudioResources &mResources;
+    const std::vector<unsigned int> mSlots;
+    const SDL_AudioSpec mAudioSpec;
+    COPLEmulator mOPL;
+};
+
+
+/**
+ * Renders all stored AdLib effects and writes them into the effect cache file,
+ * so the next launch doesn't have to render them anymore
+ */
+class ISFCacheWriter : public Action
+{
+public:
+    ISFCacheWriter(CAudioResources &resources, const std::string &path) :
+        mResources(resources),
+        mAudioSpec(resources.mAudioSpec),
+        mFilename(effectCacheFilename(path, mAudioSpec))
+    {
+        mOPL.setup(mAudioSpec.freq);
+    }
+
+    int handle()
+    {
+        std::vector<EffectCacheEntry> entries;
+        uint32_t effectsHash;
+
+        {
+            std::lock_guard<std::mutex> lock(mResources.mCacheMutex);
+
+            effectsHash = mResources.effectSetHash();
+
+            for(size_t slot = 0 ; slot < mResources.mISFData.size() ; slot++)
+            {
+                if(!mResources.mISFData[slot].empty())
+                {
+                    EffectCacheEntry entry = { uint32_t(slot), 0, 0 };
+                    entries.push_back(entry);
+                }
+            }
+        }
+
+        // Written under another name first, so a half written file is never used
+        const std::string tempFilename = mFilename + ".tmp";
+        std::ofstream file(tempFilename.c_str(), std::ios::binary | std::ios::trunc);
+
+        if(!file)
+        {
+            gLogging << "Could not write the AdLib effect cache " << mFilename << "<br>";
+            return 1;
+        }
+
+        const EffectCacheHeader header = makeEffectCacheHeader(mAudioSpec, effectsHash,
+                                                               uint32_t(entries.size()));
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()),
+                   std::streamsize(entries.size()*sizeof(EffectCacheEntry)));
+
+        uint32_t offset = uint32_t(sizeof(header) + entries.size()*sizeof(EffectCacheEntry));
+
+        for(auto &entry : entries)
+        {
+            std::vector<byte> isf;
+
+            {
+                std::lock_guard<std::mutex> lock(mResources.mCacheMutex);
+
+                if(mResources.mCancelCacheWriter)
+                {
+                    file.close();
+                    remove(tempFilename.c_str());
+                    return 1;
+                }
+
+                isf = mResources.mISFData[entry.slot];
+            }
+
+            // A broken effect might have been dropped meanwhile
+            CSoundSlot rendered;
+            if(isf.empty() || !mResources.readISFintoWaveForm(rendered, isf.data(), mOPL, mAudioSpec))
+                continue;
+
+            entry.offset = offset;
+            entry.length = rendered.getSoundlength();
+            file.write(reinterpret_cast<const char*>(rendered.getSoundData()), entry.length);
+            offset += entry.length;
+        }
+
+        file.seekp(sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()),
+                   std::streamsize(entries.size()*sizeof(EffectCacheEntry)));
+        file.close();
+
+        if(!file)
+        {
+            remove(tempFilename.c_str());
+            gLogging << "Could not write the AdLib effect cache " << mFilename << "<br>";
+            return 1;
+        }
+
+        remove(mFilename.c_str());
+        rename(tempFilename.c_str(), mFilename.c_str());
+        return 0;
+    }
+
+private:
+    CAudioResources &mResources;
+    const SDL_AudioSpec mAudioSpec;
+    const std::string mFilename;
+    COPLEmulator mOPL;
+};
+
+
+CAudioResources::CAudioResources() :
+    mAudioSpec(gSound.getAudioSpec())
+{
+    mEffectOPL.init(mAudioSpec.freq);
+}
+
+CAudioResources::~CAudioResources()
 {
-	byte *imfdata_ptr = (byte*)imfdata;
-	const longword size = READLONGWORD(imfdata_ptr);
+    stopWorker(mpPrefetchThread, mCancelPrefetch);
+    stopWorker(mpCacheWriterThread, mCancelCacheWriter);
+}
+
+
+bool CAudioResources::storeISF(const unsigned int slot, const byte *imfdata, const size_t size)
+{
+    const size_t headerSize = sizeof(longword)+sizeof(word)+sizeof(AdLibSound);
+
+    if(slot >= m_soundslot.size() || size < headerSize)
+        return false;
+
+    byte *imfdata_ptr = const_cast<byte*>(imfdata);
+    const longword dataSize = READLONGWORD(imfdata_ptr);
 
     // If the size is at largest, the sound is invalid.
-    if(size == 0xFFFFFFFF)
+    if(dataSize == 0xFFFFFFFF)
+        return false;
+
+    const word priority = READWORD(imfdata_ptr);
+
+    AdLibSound AL_Sound;
+    memcpy(&AL_Sound, imfdata_ptr, sizeof(AdLibSound));
+
+    if (!(AL_Sound.inst.mSus | AL_Sound.inst.cSus))
+        return false;
+
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+
+    m_soundslot[slot].priority = priority;
+
+    if(mISFData.size() < m_soundslot.size())
+    {
+        mISFData.resize(m_soundslot.size());
+        mISFCrc.resize(m_soundslot.size(), 0);
+    }
+
+    // Pad broken effects which claim to be longer than they are with silence
+    std::vector<byte> &isf = mISFData[slot];
+    isf.assign(imfdata, imfdata+size);
+    if(isf.size() < headerSize+dataSize)
+        isf.resize(headerSize+dataSize, 0);
+
+    mISFCrc[slot] = getcrc32(isf.data(), int(isf.size()));
+
+    return true;
+}
+
+
+bool CAudioResources::hasSound(const unsigned int slot) const
+{
+    if(slot >= m_soundslot.size())
+        return false;
+
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+
+    if(slot < mISFData.size() && !mISFData[slot].empty())
+        return true;
+
+    return m_soundslot[slot].getSoundlength() > 0;
+}
+
+
+bool CAudioResources::isEffectCached(const unsigned int slot) const
+{
+    return slot < mCachedEffects.size() && mCachedEffects[slot].second > 0;
+}
+
+
+void CAudioResources::renderISF(const unsigned int slot)
+{
+    CSoundSlot rendered;
+
+    if(isEffectCached(slot))
+    {
+        // Rendered by an earlier launch already
+        const auto &cached = mCachedEffects[slot];
+        rendered.setupWaveForm(const_cast<byte*>(mEffectCacheFile.data() + cached.first),
+                               cached.second);
+    }
+    else if(!readISFintoWaveForm(rendered, mISFData[slot].data(), mEffectOPL, mAudioSpec))
+    {
+        gLogging << "Sound " << slot << " could not be rendered!<br>";
+        mISFData[slot].clear();
+        return;
+    }
+
+    addRendered(slot, rendered);
+}
+
+
+void CAudioResources::addRendered(const unsigned int slot, CSoundSlot &rendered)
+{
+    CSoundSlot &sndSlot = m_soundslot[slot];
+
+    // The priority was taken when the effect was stored
+    const word priority = sndSlot.priority;
+    sndSlot = std::move(rendered);
+    sndSlot.priority = priority;
+
+    mRenderedSlots.push_front(slot);
+    mRenderedBytes += sndSlot.getSoundlength();
+
+    // Prefetched effects count as well, so the cache never grows past its budget
+    trimCache(slot);
+}
+
+
+void CAudioResources::trimCache(const unsigned int keepSlot)
+{
+    if(mRenderedBytes <= AdLibCacheBudget)
+        return;
+
+    // The callback must not start or play a slot between the check and the unload
+    SDL_LockAudio();
+
+    auto it = mRenderedSlots.end();
+
+    while(mRenderedBytes > AdLibCacheBudget && it != mRenderedSlots.begin())
+    {
+        it--;
+
+        const unsigned int slot = *it;
+        CSoundSlot &sndSlot = m_soundslot[slot];
+
+        // Sounds which are being played or are queued must stay
+        if(slot == keepSlot || gSound.isSlotInUse(slot))
+            continue;
+
+        mRenderedBytes -= sndSlot.getSoundlength();
+        sndSlot.unload();
+        it = mRenderedSlots.erase(it);
+    }
+
+    SDL_UnlockAudio();
+}
+
+
+CSoundSlot *CAudioResources::prepareSlot(const unsigned int slot)
+{
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+
+    CSoundSlot &sndSlot = m_soundslot[slot];
+
+    if(slot < mISFData.size() && !mISFData[slot].empty())
+    {
+        if(sndSlot.getSoundlength() == 0)
+        {
+            renderISF(slot);
+        }
+        else
+        {
+            // Just played, so it becomes the most recently used one
+            auto it = std::find(mRenderedSlots.begin(), mRenderedSlots.end(), slot);
+            if(it != mRenderedSlots.end())
+                mRenderedSlots.splice(mRenderedSlots.begin(), mRenderedSlots, it);
+        }
+    }
+
+    return &sndSlot;
+}
+
+
+void CAudioResources::prefetchSlots(const std::vector<unsigned int> &slots)
+{
+    stopWorker(mpPrefetchThread, mCancelPrefetch);
+
+    mCancelPrefetch = false;
+    mpPrefetchThread = threadPool->start(new ISFPrefetch(*this, slots),
+                                         "AdLib effect prefetch");
+}
+
+
+void CAudioResources::stopWorker(ThreadPoolItem *&worker, bool &cancel)
+{
+    if(!worker)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mCacheMutex);
+        cancel = true;
+    }
+
+    threadPool->wait(worker, nullptr);
+    worker = nullptr;
+}
+
+
+uint32_t CAudioResources::effectSetHash() const
+{
+    std::vector<uint32_t> ids;
+
+    for(size_t slot = 0 ; slot < mISFData.size() ; slot++)
     {
+        if(!mISFData[slot].empty())
+        {
+            ids.push_back(uint32_t(slot));
+            ids.push_back(mISFCrc[slot]);
+        }
+    }
+
+    if(ids.empty())
+        return 0;
+
+    return getcrc32(reinterpret_cast<unsigned char*>(ids.data()),
+                    int(ids.size()*sizeof(uint32_t)));
+}
+
+
+bool CAudioResources::readEffectCache()
+{
+    const byte *data = mEffectCacheFile.data();
+    const size_t size = mEffectCacheFile.size();
+
+    if(size < sizeof(EffectCacheHeader))
         return false;
+
+    EffectCacheHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    size_t numEntries = 0;
+    for(const auto &isf : mISFData)
+    {
+        if(!isf.empty())
+            numEntries++;
     }
 
-	soundslot.priority = READWORD(imfdata_ptr);
-    COPLEmulator &OPLEmulator = gSound.getOPLEmulatorRef();
+    const EffectCacheHeader expected = makeEffectCacheHeader(mAudioSpec, effectSetHash(),
+                                                             uint32_t(numEntries));
 
-	// It's time make it Adlib Sound structure and read it into the waveform
-	AdLibSound AL_Sound = *((AdLibSound*) imfdata_ptr);
-	imfdata_ptr += sizeof(AdLibSound);
-	const unsigned int data_size = size;
-	const byte *AL_Sounddata_start = imfdata_ptr;
-	const byte *AL_Sounddata_end = AL_Sounddata_start+data_size;
+    if(memcmp(&header, &expected, sizeof(header)) != 0)
+        return false;
 
-	OPLEmulator.ShutAL();
-	Bit8u alBlock = ((AL_Sound.block & 7) << 2) | 0x20;
-	if (!(AL_Sound.inst.mSus | AL_Sound.inst.cSus))
-	{
-		// TODO: Bad instrument. Please tell that also...
-		return false;
-	}
-	OPLEmulator.AlSetFXInst(AL_Sound.inst);
+    const size_t tableEnd = sizeof(header) + numEntries*sizeof(EffectCacheEntry);
+    if(size < tableEnd)
+        return false;
+
+    std::vector< std::pair<uint32_t, uint32_t> > cachedEffects(m_soundslot.size());
 
-    const SDL_AudioSpec &audioSpec = gSound.getAudioSpec();
+    for(size_t i = 0 ; i < numEntries ; i++)
+    {
+        EffectCacheEntry entry;
+        memcpy(&entry, data + sizeof(header) + i*sizeof(EffectCacheEntry), sizeof(entry));
 
+        if(entry.slot >= mISFData.size() || mISFData[entry.slot].empty())
+            return false;
 
-    const unsigned int samplesPerMusicTick = audioSpec.freq/OPLEmulator.getIMFClockRate();
-	const unsigned waittimes = 4;
-    const unsigned int wavesize = (data_size*waittimes*samplesPerMusicTick*audioSpec.channels*formatsize );
-    std::vector<byte> waveform;
-    waveform.resize(wavesize, 0);
+        if(entry.length == 0)   // That one could not be rendered
+            continue;
 
-    std::vector<Bit32s> mix_buffer;
-    mix_buffer.resize(samplesPerMusicTick, 0);
+        if(entry.offset < tableEnd || size_t(entry.offset) + entry.length > size)
+            return false;
 
-	OPLEmulator.ALStopSound();
+        cachedEffects[entry.slot] = std::make_pair(entry.offset, entry.length);
+    }
+
+    mCachedEffects.swap(cachedEffects);
+    return true;
+}
 
-    unsigned long offset = 0;
 
-	for(byte *AL_Sounddata_ptr = (byte*) AL_Sounddata_start ;
-			  AL_Sounddata_ptr < AL_Sounddata_end ;
-			  AL_Sounddata_ptr++ )
-	{
-		if(*AL_Sounddata_ptr)
-		{
-			OPLEmulator.Chip__WriteReg( alFreqL, *AL_Sounddata_ptr );
-			OPLEmulator.Chip__WriteReg( alFreqH, alBlock );
-		}
-		else
+bool CAudioResources::openEffectCache(const std::string &path)
+{
+    const std::string fullpath = effectCacheFilename(path, mAudioSpec);
+
+    stopWorker(mpCacheWriterThread, mCancelCacheWriter);
+
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+
+    mCachedEffects.clear();
+
+    if(mEffectCacheFile.open(fullpath))
+    {
+        if(readEffectCache())
         {
-			OPLEmulator.Chip__WriteReg( alFreqH, 0 );
+            gLogging << "Using the rendered AdLib effects of " << fullpath << "<br>";
+            return true;
         }
 
-   		if(formatsize == 2) // 16-Bit Sound
-   		{
-
-   			for( size_t count=0 ; count<waittimes ; count++ )
-   			{
-                Sint16 *buffer = (Sint16*) (void*) (&waveform[offset]);
-
-                OPLEmulator.Chip__GenerateBlock2( samplesPerMusicTick, mix_buffer.data() );
-
-   				// Mix into the destination buffer, doubling up into stereo.
-   				for (unsigned int i=0; i<samplesPerMusicTick; ++i)
-   				{
-                    for( unsigned int ch=0 ; ch<audioSpec.channels ; ch++ )
-				    {
-                        buffer[i * audioSpec.channels + ch] = (int16_t) (mix_buffer[i]+audioSpec.silence);
-				    }
-   				}
-
-                offset += samplesPerMusicTick*audioSpec.channels*formatsize;
-   			}
-   		}
-   		else // 8-Bit Sound
-   		{
-   			for( unsigned int count=0 ; count<waittimes ; count++ )
-   			{
-                Uint8 *buffer = (Uint8*) (&waveform[offset]);
-
-                OPLEmulator.Chip__GenerateBlock2( samplesPerMusicTick, mix_buffer.data() );
-
-   				// Mix into the destination buffer, doubling up into stereo.
-   				for (unsigned int i=0; i<samplesPerMusicTick; ++i)
-   				{
-                    for( unsigned int ch=0 ; ch<audioSpec.channels ; ch++ )
-				    {
-                    buffer[i * audioSpec.channels + ch] = (Uint8) ((mix_buffer[i]>>8)+audioSpec.silence);
-				    }
-   				}
-
-                offset += samplesPerMusicTick*audioSpec.channels*formatsize;
-   			}
-   		}
-	}
-
-    soundslot.setupWaveForm(waveform.data(), wavesize);
+        mEffectCacheFile.close();
+    }
+
+    mCancelCacheWriter = false;
+    mpCacheWriterThread = threadPool->start(new ISFCacheWriter(*this, path),
+                                            "AdLib effect cache writer");
+    return false;
+}
+
+bool CAudioResources::readISFintoWaveForm( CSoundSlot &soundslot, const byte *imfdata )
+{
+    return readISFintoWaveForm(soundslot, imfdata, mEffectOPL, mAudioSpec);
+}
+
+bool CAudioResources::readISFintoWaveForm( CSoundSlot &soundslot, const byte *imfdata,
+                                           COPLEmulator &opl, const SDL_AudioSpec &audioSpec )
+{
+    std::vector<byte> waveform;
+
+    if(!opl.renderISF(imfdata, audioSpec, waveform, &soundslot.priority))
+    {
+        return false;
+    }
 
+    soundslot.setupWaveForm(waveform.data(), waveform.size());
 
 	return true;
 }
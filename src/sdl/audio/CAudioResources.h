@@ -10,8 +10,12 @@
 
 #include "sdl/audio/sound/CSoundSlot.h"
 #include "sdl/audio/base/COPLEmulator.h"
+#include "fileio/MappedFile.h"
+#include <base/utils/ThreadPool.h>
 #include <string>
 #include <vector>
+#include <list>
+#include <mutex>
 
 /** This is the PC Speaker Volume it will set.
   * When the PC Speaker Emulator generates the Sound slots
@@ -23,11 +27,11 @@ const int PC_Speaker_Volume = 20; // in percent
 
 const Uint64 PCSpeakerTime = 0x1234DD;
 
-typedef struct
-{
-    Instrument      inst;
-    byte            block;
-} AdLibSound;
+/** Upper bound of memory the rendered AdLib sound effects may take.
+  * Effects are rendered when they are played the first time. If the cache gets bigger,
+  * the effects not played for the longest time are dropped and rendered again when needed.
+  */
+const size_t AdLibCacheBudget = 8*1024*1024; // in bytes
 
 // Game Sounds
 enum GameSound
@@ -171,12 +175,56 @@ class CAudioResources
 {
 public:
     CAudioResources();
-	virtual ~CAudioResources() {}
+	virtual ~CAudioResources();
 
     virtual bool loadSoundData(const unsigned int dictOffset) = 0;
 	virtual void unloadSound() = 0;
 
-    bool readISFintoWaveForm(CSoundSlot &soundslot, const byte *imfdata, const Uint8 formatsize );
+    bool readISFintoWaveForm(CSoundSlot &soundslot, const byte *imfdata );
+
+    /**
+     * @brief readISFintoWaveForm   Renders the effect with the given emulator into the given format.
+     *                              The audio resources aren't touched, so it doesn't need the cache mutex.
+     */
+    bool readISFintoWaveForm(CSoundSlot &soundslot, const byte *imfdata,
+                             COPLEmulator &opl, const SDL_AudioSpec &audioSpec);
+
+    /**
+     * @brief storeISF  Keeps the AdLib sound effect for the given slot, so it can be rendered once it is played
+     * @param slot      index of the sound slot
+     * @param imfdata   the effect in ISF format
+     * @param size      size of the effect data in bytes
+     * @return true if the effect is valid, otherwise false
+     */
+    bool storeISF(const unsigned int slot, const byte *imfdata, const size_t size);
+
+    /**
+     * @brief hasSound  Tells if the slot has a sound, be it rendered already or not
+     */
+    bool hasSound(const unsigned int slot) const;
+
+    /**
+     * @brief prepareSlot   Renders the AdLib effect of the slot if it is not in the cache
+     * @return pointer to the slot, ready to be played
+     */
+    CSoundSlot *prepareSlot(const unsigned int slot);
+
+    /**
+     * @brief prefetchSlots Renders the AdLib effects of the given slots in the background,
+     *                      so they are ready when they are played the first time
+     */
+    void prefetchSlots(const std::vector<unsigned int> &slots);
+
+    /**
+     * @brief openEffectCache   Looks for the AdLib effects rendered by an earlier launch in the given path.
+     *                          Those are taken instead of rendering them again. If there are none
+     *                          or they don't match the stored effects and the audio settings,
+     *                          the cache file is written in the background.
+     *                          Call it after all the effects have been stored.
+     * @param path  directory of the game
+     * @return true if the cache could be used, otherwise false
+     */
+    bool openEffectCache(const std::string &path);
 	
 	CSoundSlot *getSlotPtr(){	return &m_soundslot[0];	}
 	CSoundSlot *getSlotPtrAt(const unsigned int idx){	return &m_soundslot[idx];	}
@@ -208,6 +256,59 @@ protected:
 
 private:
 
+    // Renders the stored effect of the slot. The cache mutex must be held.
+    void renderISF(const unsigned int slot);
+
+    // Takes a rendered effect into the slot and the cache and trims the cache if it got too big.
+    // The cache mutex must be held.
+    void addRendered(const unsigned int slot, CSoundSlot &rendered);
+
+    // Tells if the effect of the slot is in the opened cache file. The cache mutex must be held.
+    bool isEffectCached(const unsigned int slot) const;
+
+    // Drops the least recently used effects until the cache fits into its budget again.
+    // Slots which are playing or queued stay. It takes the audio lock for that.
+    void trimCache(const unsigned int keepSlot);
+
+    // Tells the worker to stop and waits until it has finished
+    void stopWorker(ThreadPoolItem *&worker, bool &cancel);
+
+    // Checks the opened effect cache file and takes its entries. The cache mutex must be held.
+    bool readEffectCache();
+
+    // Hash over all stored effects, which identifies the effect cache file
+    uint32_t effectSetHash() const;
+
+    friend class ISFPrefetch;
+    friend class ISFCacheWriter;
+
+    // Unrendered AdLib effects per slot, empty for anything else
+    std::vector< std::vector<byte> > mISFData;
+    std::vector<uint32_t> mISFCrc;
+
+    // Rendered effects, the most recently used one first
+    std::list<unsigned int> mRenderedSlots;
+    size_t mRenderedBytes = 0;
+    mutable std::mutex mCacheMutex;
+    bool mCancelPrefetch = false;
+
+    // Effects are rendered with their own emulator, so they don't interfere with the music.
+    // It is only used with the cache mutex held, the workers have one of their own.
+    COPLEmulator mEffectOPL;
+
+    // Format of the rendered effects, taken when the resources are created.
+    // The workers keep a copy of it, so a new audio format can't mix into their output.
+    SDL_AudioSpec mAudioSpec;
+
+    ThreadPoolItem *mpPrefetchThread = nullptr;
+
+    // Effects rendered by an earlier launch as (offset, length) into the cache file per slot
+    MappedFile mEffectCacheFile;
+    std::vector< std::pair<uint32_t, uint32_t> > mCachedEffects;
+
+    ThreadPoolItem *mpCacheWriterThread = nullptr;
+    bool mCancelCacheWriter = false;
+
     /**
      * @brief generateBeep      Converts a classical PC Speaker Beep into a waveform
      * @param waveform          address of the waveform where in which to generate the beep
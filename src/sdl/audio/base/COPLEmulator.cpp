@@ -11,11 +11,11 @@
  */
 
 #include "COPLEmulator.h"
-#include <sdl/audio/Audio.h>
 
 #include <fstream>
 #include <cstring>
 #include <cstdio>
+#include <algorithm>
 
 const int KEEN_IMF_CLOCK_RATE = 560;
 
@@ -65,24 +65,179 @@ void COPLEmulator::StartOPLforAdlibSound()
     AlSetFXInst(m_alZeroInst);
 }
 
-void COPLEmulator::init()
+void COPLEmulator::init(const int freq)
 {
     DBOPL_InitTables();
-    setup();
+    setup(freq);
 }
 
-void COPLEmulator::setup()
+void COPLEmulator::setup(const int freq)
 {
     m_opl_chip.clear();
     Chip__Chip(&m_opl_chip);
 
-    const SDL_AudioSpec &audioSpec = gSound.getAudioSpec();
-    Chip__Setup(&m_opl_chip, audioSpec.freq);
+    Chip__Setup(&m_opl_chip, freq);
 
     StartOPLforAdlibSound();
 }
 
 
+void COPLEmulator::renderInto( Uint8 *buffer, const unsigned int samples, const SDL_AudioSpec &audioSpec )
+{
+    const unsigned int RENDER_CHUNK = 512;
+    Bit32s mix[RENDER_CHUNK];
+
+    const unsigned int channels = audioSpec.channels;
+
+    for( unsigned int done = 0 ; done < samples ; )
+    {
+        const unsigned int len = std::min(samples-done, RENDER_CHUNK);
+        ::Chip__GenerateBlock2( &m_opl_chip, len, mix );
+
+        if(audioSpec.format == AUDIO_S16)
+        {
+            Sint16 *buf16 = (Sint16*) (void*) buffer;
+
+            for( unsigned int i=0 ; i<len ; i++ )
+            {
+                const Sint16 value = Sint16( std::max(-32768, std::min(32767, int(mix[i]))) + audioSpec.silence );
+
+                for( unsigned int ch=0 ; ch<channels ; ch++ )
+                    buf16[i*channels + ch] = value;
+            }
+
+            buffer += len*channels*sizeof(Sint16);
+        }
+        else if(audioSpec.format == AUDIO_U8)
+        {
+            for( unsigned int i=0 ; i<len ; i++ )
+            {
+                const Uint8 value = Uint8( std::max(0, std::min(255, int(mix[i]>>8))) + audioSpec.silence );
+
+                for( unsigned int ch=0 ; ch<channels ; ch++ )
+                    buffer[i*channels + ch] = value;
+            }
+
+            buffer += len*channels;
+        }
+
+        done += len;
+    }
+}
+
+
+bool COPLEmulator::renderISF( const byte *isf, const SDL_AudioSpec &audioSpec,
+                              std::vector<byte> &waveform, word *priority )
+{
+    longword size;
+    memcpy(&size, isf, sizeof(longword));
+    isf += sizeof(longword);
+
+    // If the size is at largest, the sound is invalid.
+    if(size == 0xFFFFFFFF)
+    {
+        return false;
+    }
+
+    if(priority)
+        memcpy(priority, isf, sizeof(word));
+    isf += sizeof(word);
+
+    // Every effect starts from a freshly set up chip, so it sounds the same
+    // no matter which effects have been rendered before
+    setup(audioSpec.freq);
+
+	// It's time make it Adlib Sound structure and read it into the waveform
+	AdLibSound AL_Sound;
+	memcpy(&AL_Sound, isf, sizeof(AdLibSound));
+	isf += sizeof(AdLibSound);
+
+	const unsigned int data_size = size;
+	const byte *AL_Sounddata_start = isf;
+	const byte *AL_Sounddata_end = AL_Sounddata_start+data_size;
+
+	ShutAL();
+	Bit8u alBlock = ((AL_Sound.block & 7) << 2) | 0x20;
+	if (!(AL_Sound.inst.mSus | AL_Sound.inst.cSus))
+	{
+		// TODO: Bad instrument. Please tell that also...
+		return false;
+	}
+	AlSetFXInst(AL_Sound.inst);
+
+    const unsigned int formatsize = (audioSpec.format == AUDIO_S16) ? 2 : 1;
+    const unsigned int samplesPerMusicTick = audioSpec.freq/getIMFClockRate();
+	const unsigned waittimes = 4;
+    const unsigned int wavesize = (data_size*waittimes*samplesPerMusicTick*audioSpec.channels*formatsize );
+    waveform.assign(wavesize, 0);
+
+    std::vector<Bit32s> mix_buffer;
+    mix_buffer.resize(samplesPerMusicTick, 0);
+
+	ALStopSound();
+
+    unsigned long offset = 0;
+
+	for(const byte *AL_Sounddata_ptr = AL_Sounddata_start ;
+			  AL_Sounddata_ptr < AL_Sounddata_end ;
+			  AL_Sounddata_ptr++ )
+	{
+		if(*AL_Sounddata_ptr)
+		{
+			Chip__WriteReg( alFreqL, *AL_Sounddata_ptr );
+			Chip__WriteReg( alFreqH, alBlock );
+		}
+		else
+        {
+			Chip__WriteReg( alFreqH, 0 );
+        }
+
+   		if(formatsize == 2) // 16-Bit Sound
+   		{
+   			for( size_t count=0 ; count<waittimes ; count++ )
+   			{
+                Sint16 *buffer = (Sint16*) (void*) (&waveform[offset]);
+
+                Chip__GenerateBlock2( samplesPerMusicTick, mix_buffer.data() );
+
+   				// Mix into the destination buffer, doubling up into stereo.
+   				for (unsigned int i=0; i<samplesPerMusicTick; ++i)
+   				{
+                    for( unsigned int ch=0 ; ch<audioSpec.channels ; ch++ )
+				    {
+                        buffer[i * audioSpec.channels + ch] = (int16_t) (mix_buffer[i]+audioSpec.silence);
+				    }
+   				}
+
+                offset += samplesPerMusicTick*audioSpec.channels*formatsize;
+   			}
+   		}
+   		else // 8-Bit Sound
+   		{
+   			for( unsigned int count=0 ; count<waittimes ; count++ )
+   			{
+                Uint8 *buffer = (Uint8*) (&waveform[offset]);
+
+                Chip__GenerateBlock2( samplesPerMusicTick, mix_buffer.data() );
+
+   				// Mix into the destination buffer, doubling up into stereo.
+   				for (unsigned int i=0; i<samplesPerMusicTick; ++i)
+   				{
+                    for( unsigned int ch=0 ; ch<audioSpec.channels ; ch++ )
+				    {
+                        buffer[i * audioSpec.channels + ch] = (Uint8) ((mix_buffer[i]>>8)+audioSpec.silence);
+				    }
+   				}
+
+                offset += samplesPerMusicTick*audioSpec.channels*formatsize;
+   			}
+   		}
+	}
+
+	return true;
+}
+
+
 unsigned int COPLEmulator::getIMFClockRate()
 {
   return m_imf_clock_rate;
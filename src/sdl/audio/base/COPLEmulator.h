@@ -11,6 +11,12 @@
 #include <base/TypeDefinitions.h>
 #include "dbopl.h"
 #include <SDL.h>
+#include <vector>
+
+/** Version of the emulated output. Increase it whenever a change to the emulator
+  * alters the samples it generates, so waveforms rendered before are not used anymore.
+  */
+const unsigned int OPL_EMULATOR_VERSION = 1;
 
 
 //      Register addresses
@@ -43,6 +49,12 @@ typedef struct
     byte    unused[3];
 } Instrument;
 
+typedef struct
+{
+    Instrument      inst;
+    byte            block;
+} AdLibSound;
+
 class COPLEmulator
 {
 public:
@@ -53,12 +65,13 @@ public:
 	/**
 	 * This function takes care of initializing the OPL Emulator.
 	 * It should be called whenever the Sound Device starts or restarts after changing audio settings
+	 * \param freq	rate in Hz at which the chip generates samples
 	 */
-	void init();
+	void init(const int freq);
 
 	// Call this if a new song is loaded or audio settings are changed.
 	// init() calls this as well.
-	void setup();
+	void setup(const int freq);
 
 	void AlSetFXInst(Instrument &inst);
 
@@ -78,6 +91,34 @@ public:
 	}
 
 
+	/**
+	 * Renders samples straight into a buffer in the format of the audio device.
+	 * The mono output of the chip is clipped and written to every channel.
+	 * It works through a small buffer which stays in the cache, so no mix buffer is needed.
+	 */
+	void renderInto( Uint8 *buffer, const unsigned int samples, const SDL_AudioSpec &audioSpec );
+
+	/**
+	 * Plays an AdLib sound effect in the ISF format of the Keen Galaxy games and records it.
+	 * The chip is set up from scratch, so an effect always sounds the same.
+	 * \param isf		the effect, starting with its length
+	 * \param audioSpec	format of the waveform. Only the rate, channels, format and silence are used.
+	 * \param waveform	receives the effect
+	 * \param priority	if not null, receives the priority stored in the effect
+	 * \return false if the effect is not valid
+	 */
+	bool renderISF( const byte *isf, const SDL_AudioSpec &audioSpec,
+	                std::vector<byte> &waveform, word *priority = nullptr );
+
+	/**
+	 * Renders everything sample by sample like the original emulator when enabled.
+	 * The output is the same either way, so it's only there to compare both.
+	 */
+	static void setReferenceMode( const bool enable )
+	{
+		DBOPL_SetReferenceMode( enable ? 1 : 0 );
+	}
+
 	/**
 	 * Wrapper for the original C Emulator function Chip__WriteReg(Chip *self, Bit32u reg, Bit8u val )
 	 */
@@ -8,142 +8,313 @@
  *  different and not of the same base.
  */
 
-#include <SDL.h>
+#include "Sampling.h"
 
-#include <cstdio>
+#include <algorithm>
+#include <cmath>
 #include <cstring>
-#include <cstdlib>
 
-#define WAVE_SILENCE_U8         128
-#define WAVE_SILENCE_S16        0
+namespace
+{
 
-/**
- * \brief This function splits the stereo for one channel so it can be manipulated
- * \param output 	Pointer to output buffer
- * \param input 	Pointer to input buffer
- * \param length 	Length of the stream in bytes,
- * \param channels	Amount of Sound Channels used in the Stream
- * \param chnl		Number of channel to split off
- * \param width		width of the amplitude. In case of U8 it is 1, for 16 bit 2
- */
-void splitChannel(Uint8* output, Uint8* input, size_t length,
-					size_t channels, size_t chnl, size_t width)
+size_t gcd(size_t a, size_t b)
 {
-	input += (width*chnl);
-	for( size_t i=0 ; i<(length/(channels*width)) ; i++ )
-	{
-		memcpy(output, input, width);
-		input += (width*channels);
-		output += width;
-	}
+    while(b != 0)
+    {
+        const size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
 }
 
-/**
- * \brief This function merges a channel into the stereo stream
- * \param output 	Pointer to output buffer
- * \param input 	Pointer to input buffer
- * \param length 	Length of the stream in bytes,
- * \param channels	Amount of Sound Channels used in the Strean
- * \param chnl		Number of channel to merge
- * \param width		width of the amplitude. In case of U8 it is 1, for 16 bit 2
- */
-void mergeChannel(Uint8* output, Uint8* input, size_t length,
-					size_t channels, size_t chnl, size_t width)
+size_t bytesPerSample(const Uint16 format)
 {
-	output += (width*chnl);
-	for( size_t i=0 ; i<(length/(channels*width)) ; i++ )
-	{
-		memcpy(output, input, width);
-		input += width;
-		output += (width*channels);
-	}
+    return (format == AUDIO_S16) ? 2 : 1;
 }
 
 /**
- * \brief This will stretch a sound stream which is wide depending on the size of the used template
- * \param strechedbuf The output buffer which will be stretched
- * \param
- *  Sint16 *buf,
-					size_t input_len, size_t input_len
+ * \brief Dot product of coeffs and input, both taps*channels long and interleaved.
+ *        Four independent sums are kept, so the compiler can put them into one vector register.
+ *        Only for one, two or four channels, where every sum belongs to one channel.
  */
-template <typename T>
-void stretchSound( T *output, T *input,	size_t output_len, size_t input_len )
+inline void dotInterleaved(float *out, const float *coeffs, const float *input,
+                           const size_t len, const size_t channels)
 {
-	const size_t len_a = input_len/sizeof(T);
-	const size_t len_b = output_len/sizeof(T);
-	const float factor = ((float) input_len)/((float) output_len);
-	Sint32 v_a, v_b, value;
-	size_t inter;
-
-	for(size_t i=0, j=0 ; i<len_a && j<len_b ; i++)
-	{
-		output[j] = input[i];
-		j++;
-
-		inter = ((float)j)*factor;
-		// linear interpolation for the gaps we get ;-)
-		while( i >= inter && i<len_a && j<len_b )
-		{
-			v_a = input[i];
-			v_b = ((i+1)<len_a) ? input[i+1] : input[i];
-			value = (v_a + v_b)/2;
-			output[j] = value;
-			j++;
-			inter = ((float)j)*factor;
-		}
-	}
+    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    for(size_t i = 0 ; i < len ; i += 4)
+    {
+        acc[0] += coeffs[i]   * input[i];
+        acc[1] += coeffs[i+1] * input[i+1];
+        acc[2] += coeffs[i+2] * input[i+2];
+        acc[3] += coeffs[i+3] * input[i+3];
+    }
+
+    if(channels == 1)
+    {
+        out[0] = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    }
+    else if(channels == 2)
+    {
+        out[0] = acc[0] + acc[2];
+        out[1] = acc[1] + acc[3];
+    }
+    else
+    {
+        memcpy(out, acc, sizeof(acc));
+    }
 }
 
-/**
- * \brief Adaptation function to the 48 Khz Sound in 16 bit mode
- * \param out 			pointer to the output where the sound will written to
- * \param in		 	pointer to the adress where the sound comes from
- * \param output_len	length of the output buffer
- * \param input_len		length of the input buffer
- * \param channels		number of channels. 1 in mono, 2 in stereo
- */
+}
 
-template <typename T>
-void resampleAnyBits(const T* out, const T *in,
-		unsigned long output_len, unsigned long input_len, size_t channels)
+
+bool Resampler::setup(const int inRate, const int outRate,
+                      const Uint16 format, const size_t channels)
 {
-	Uint8* output_buffer = (Uint8*) out;
-	Uint8 *input_buffer = (Uint8*) in;
-	// Temporary buffer for the stretched stream. Of course it's per channel...
-	T *stretchedbuf = (T*) malloc( output_len/channels );
-
-	// Split the channels so they won't be overlapped during the stretching
-	Uint8 *onechannelbuffer = (Uint8*) malloc( input_len/channels );
-
-	// Now, for all channels do the operation
-	for(size_t ch=0 ; ch<channels ; ch++)
-	{
-		splitChannel( onechannelbuffer, input_buffer, input_len, channels, ch, sizeof(T) );
-		stretchSound( stretchedbuf, (T*) (void *)onechannelbuffer, output_len/channels, input_len/channels );
-		mergeChannel( output_buffer, (Uint8*) stretchedbuf, output_len, channels, ch, sizeof(T) );
-	}
-	free(onechannelbuffer);
-	free(stretchedbuf);
+    if(inRate <= 0 || outRate <= 0 || channels == 0)
+        return false;
+
+    if(format != AUDIO_S16 && format != AUDIO_U8)
+        return false;
+
+    const size_t g = gcd(size_t(inRate), size_t(outRate));
+    mUp = size_t(outRate)/g;
+    mDown = size_t(inRate)/g;
+
+    if(mUp > MaxPhases)
+    {
+        mDown = std::max<size_t>(1, size_t(double(mDown)*MaxPhases/mUp + 0.5));
+        mUp = MaxPhases;
+    }
+
+    mFormat = format;
+    mChannels = channels;
+
+    // When going down, the filter must get wider to cut off above the new Nyquist frequency
+    const double ratio = std::min(1.0, double(mUp)/double(mDown));
+    const double cutoff = ratio*0.97;
+
+    mTaps = size_t(std::ceil(BaseTaps/ratio));
+    mTaps = (mTaps+3) & ~size_t(3);
+
+    const double half = double(mTaps/2);
+    const double pi = 3.14159265358979323846;
+
+    // The coefficients are repeated for every channel, so they line up with the interleaved input
+    mCoeffs.assign(mUp*mTaps*mChannels, 0.0f);
+
+    std::vector<double> phase(mTaps);
+
+    for(size_t p = 0 ; p < mUp ; p++)
+    {
+        const double frac = double(p)/double(mUp);
+        double sum = 0.0;
+
+        for(size_t k = 0 ; k < mTaps ; k++)
+        {
+            // Distance between the input frame of this tap and the output
+            const double t = double(k) - (half-1.0) - frac;
+            const double x = t*cutoff;
+            const double sinc = (std::fabs(x) < 1e-9) ? 1.0 : std::sin(pi*x)/(pi*x);
+
+            // Blackman window
+            const double a = t/half;
+            const double window = (std::fabs(a) < 1.0) ?
+                        (0.42 + 0.5*std::cos(pi*a) + 0.08*std::cos(2.0*pi*a)) : 0.0;
+
+            phase[k] = cutoff*sinc*window;
+            sum += phase[k];
+        }
+
+        // Every phase keeps a constant level as it is
+        for(size_t k = 0 ; k < mTaps ; k++)
+        {
+            const float coeff = float(phase[k]/sum);
+            for(size_t ch = 0 ; ch < mChannels ; ch++)
+                mCoeffs[(p*mTaps + k)*mChannels + ch] = coeff;
+        }
+    }
+
+    mRingFrames = mTaps + BlockFrames;
+    mRing.assign(2*mRingFrames*mChannels, 0.0f);
+    mFrame.assign(std::max<size_t>(mChannels, 4), 0.0f);
+
+    reset();
+    return true;
 }
 
 
+void Resampler::reset()
+{
+    mRead = 0;
+    mWrite = 0;
+    mPos = mTaps/2 - 1;
+    mPhase = 0;
+
+    // Silence in front of the first frame, so the filter can be centered on it
+    writeFrames(nullptr, mPos);
+}
 
-// this fixes the speed of the played songs, when using any frequency
-void resample(const Uint8* output_buffer, const Uint8 *input_buffer,
-		const unsigned long output_len, const unsigned long input_len,
-		const Uint16 format, const size_t channels )
+
+size_t Resampler::maxOutputLen(const size_t inputLen) const
 {
-	if(format == AUDIO_S16)
-	{
-		memset((Uint8*)output_buffer, WAVE_SILENCE_S16, output_len);
-
-        resampleAnyBits( (Sint16*) (void *)output_buffer, (Sint16*) (void *)input_buffer,
-                output_len, input_len, channels);
-	}
-	else if(format == AUDIO_U8)
-	{
-		memset((Uint8*)output_buffer, WAVE_SILENCE_U8, output_len);
-		resampleAnyBits( (Uint8*) output_buffer, (Uint8*) input_buffer,
-				output_len, input_len, channels);
-	}
+    if(mChannels == 0)
+        return 0;
+
+    const size_t frameSize = bytesPerSample(mFormat)*mChannels;
+    const size_t frames = (mWrite - mRead) + inputLen/frameSize + mTaps;
+    return (frames*mUp/mDown + 2)*frameSize;
+}
+
+
+void Resampler::writeFrames(const Uint8 *input, const size_t numFrames)
+{
+    const size_t numSamples = numFrames*mChannels;
+    const size_t mirror = mRingFrames*mChannels;
+    size_t idx = (mWrite % mRingFrames)*mChannels;
+
+    for(size_t i = 0 ; i < numSamples ; i++)
+    {
+        float value = 0.0f;     // Silence
+
+        if(input && mFormat == AUDIO_S16)
+        {
+            Sint16 sample;
+            memcpy(&sample, input + 2*i, sizeof(sample));
+            value = float(sample);
+        }
+        else if(input)
+        {
+            value = float(input[i]) - 128.0f;
+        }
+
+        mRing[idx] = value;
+        mRing[idx + mirror] = value;
+
+        if(++idx == mirror)
+            idx = 0;
+    }
+
+    mWrite += numFrames;
+}
+
+
+void Resampler::feed(const Uint8 *input, const size_t numFrames, std::vector<Uint8> &output)
+{
+    const size_t frameSize = bytesPerSample(mFormat)*mChannels;
+    size_t done = 0;
+
+    while(done < numFrames)
+    {
+        // Converting a block leaves less than mTaps frames, so there is always room
+        const size_t room = mRingFrames - (mWrite - mRead);
+        const size_t len = std::min(room, numFrames - done);
+
+        writeFrames(input ? input + done*frameSize : nullptr, len);
+        convertFrames(output);
+        done += len;
+    }
+}
+
+
+void Resampler::process(const Uint8 *input, const size_t inputLen, std::vector<Uint8> &output)
+{
+    if(mChannels == 0)
+        return;
+
+    feed(input, inputLen/(bytesPerSample(mFormat)*mChannels), output);
+}
+
+
+void Resampler::flush(std::vector<Uint8> &output)
+{
+    if(mChannels == 0)
+        return;
+
+    feed(nullptr, mTaps/2, output);
+    reset();
+}
+
+
+void Resampler::convertFrames(std::vector<Uint8> &output)
+{
+    const size_t half = mTaps/2;
+    const size_t frames = mWrite - mRead;
+    const size_t sampleSize = bytesPerSample(mFormat);
+    const size_t rowLen = mTaps*mChannels;
+    const bool vectorised = (mChannels == 1 || mChannels == 2 || mChannels == 4);
+
+    const size_t oldSize = output.size();
+    output.resize(oldSize + (frames*mUp/mDown + 2)*mChannels*sampleSize);
+    Uint8 *out = output.data() + oldSize;
+
+    float *frame = mFrame.data();
+
+    while(mPos + half < frames)
+    {
+        const float *coeffs = &mCoeffs[mPhase*rowLen];
+        const float *in = &mRing[((mRead + mPos - (half-1)) % mRingFrames)*mChannels];
+
+        if(vectorised)
+        {
+            dotInterleaved(frame, coeffs, in, rowLen, mChannels);
+        }
+        else
+        {
+            std::fill(mFrame.begin(), mFrame.end(), 0.0f);
+            for(size_t i = 0 ; i < rowLen ; i++)
+                frame[i % mChannels] += coeffs[i]*in[i];
+        }
+
+        for(size_t ch = 0 ; ch < mChannels ; ch++)
+        {
+            const float value = std::floor(frame[ch] + 0.5f);
+
+            if(mFormat == AUDIO_S16)
+            {
+                const Sint16 sample = Sint16(std::max(-32768.0f, std::min(32767.0f, value)));
+                memcpy(out, &sample, sizeof(sample));
+                out += sizeof(sample);
+            }
+            else
+            {
+                *out = Uint8(std::max(0.0f, std::min(255.0f, value + 128.0f)));
+                out++;
+            }
+        }
+
+        mPhase += mDown;
+        mPos += mPhase/mUp;
+        mPhase %= mUp;
+    }
+
+    output.resize(size_t(out - output.data()));
+
+    // Only what the next output still needs is kept
+    const size_t drop = std::min(mPos - (half-1), frames);
+    mRead += drop;
+    mPos -= drop;
+}
+
+
+void resample(std::vector<Uint8> &output, const Uint8 *input, const size_t inputLen,
+              const int inRate, const int outRate,
+              const Uint16 format, const size_t channels)
+{
+    output.clear();
+
+    Resampler resampler;
+    if(!resampler.setup(inRate, outRate, format, channels))
+        return;
+
+    output.reserve(resampler.maxOutputLen(inputLen));
+    resampler.process(input, inputLen, output);
+    resampler.flush(output);
+
+    // The filter tail would make the waveform a little longer than it should be
+    const size_t frameSize = bytesPerSample(format)*channels;
+    const size_t inFrames = inputLen/frameSize;
+    const size_t outFrames = size_t((Uint64(inFrames)*Uint64(outRate) + inRate/2)/Uint64(inRate));
+    output.resize(std::min(output.size(), outFrames*frameSize));
 }
@@ -3,15 +3,110 @@
  *
  *  Created on: 05.08.2010
  *      Author: gerstrong
+ *
+ *  Resampling of Sound and Music in case the frequencies are
+ *  different and not of the same base.
  */
 
 #ifndef SAMPLING_H_
 #define SAMPLING_H_
 
 #include <SDL.h>
+#include <vector>
+
+/**
+ * \brief Polyphase resampler for interleaved U8 or S16 waveforms.
+ *
+ * The rates are reduced to a ratio L/M (e.g. 44100 -> 48000 is 160/147).
+ * For every one of the L phases a windowed sinc filter is computed once in setup(),
+ * so converting a sample is a single dot product. Ratios which need more phases
+ * than MaxPhases are approximated, which changes the pitch by less than 0.1 %.
+ *
+ * The resampler keeps the last input samples between calls of process(),
+ * so a stream can be converted in chunks of any size without clicks at their borders.
+ * They are kept in a ring of fixed size, so process() doesn't allocate anything
+ * once the output has grown big enough.
+ */
+class Resampler
+{
+public:
+
+    /**
+     * \brief Computes the filter for the given conversion and clears the history
+     * \param inRate    frequency of the input in Hz
+     * \param outRate   frequency of the output in Hz
+     * \param format    AUDIO_S16 or AUDIO_U8
+     * \param channels  number of interleaved channels
+     * \return true if the conversion is supported
+     */
+    bool setup(const int inRate, const int outRate,
+               const Uint16 format, const size_t channels);
+
+    /// Forgets the input of previous process() calls
+    void reset();
+
+    /**
+     * \brief Converts the input and appends the result to output.
+     *        The last few input frames are only used by the next call or by flush().
+     * \param input     waveform in the format given to setup()
+     * \param inputLen  length of the input in bytes
+     * \param output    the converted waveform is appended here
+     */
+    void process(const Uint8 *input, const size_t inputLen, std::vector<Uint8> &output);
+
+    /// Converts what is still held back, as if the input was followed by silence
+    void flush(std::vector<Uint8> &output);
+
+    /// Upper bound of bytes process() appends for inputLen bytes of input
+    size_t maxOutputLen(const size_t inputLen) const;
 
-void resample(const Uint8* output_buffer, const Uint8 *input_buffer,
-		const unsigned long output_len, const unsigned long input_len,
-		const Uint16 format, const size_t channels );
+private:
+
+    static const size_t MaxPhases = 1024;
+    static const size_t BaseTaps = 16;
+    static const size_t BlockFrames = 1024;  // Input frames taken into the ring at once
+
+    // Converts and appends numFrames frames to the ring, silence if input is null.
+    // There must be room for them.
+    void writeFrames(const Uint8 *input, const size_t numFrames);
+
+    // Puts the input into the ring block by block and converts every block
+    void feed(const Uint8 *input, const size_t numFrames, std::vector<Uint8> &output);
+
+    void convertFrames(std::vector<Uint8> &output);
+
+    size_t mUp = 1;         // L
+    size_t mDown = 1;       // M
+    size_t mTaps = 0;       // Filter length of one phase, multiple of four
+    size_t mChannels = 0;
+    Uint16 mFormat = 0;
+
+    std::vector<float> mCoeffs;     // mUp phases of mTaps coefficients
+
+    // Ring of mRingFrames interleaved input frames. Every frame is stored twice,
+    // mRingFrames apart, so the frames under the filter are always contiguous.
+    std::vector<float> mRing;
+    size_t mRingFrames = 0;
+    size_t mRead = 0;       // Oldest frame still needed, counted since reset()
+    size_t mWrite = 0;      // Frames written since reset()
+    size_t mPos = 0;        // Frame after mRead the next output is centered at
+    size_t mPhase = 0;      // 0 ... mUp-1
+
+    std::vector<float> mFrame;  // One output frame before it's converted to the format
+};
+
+/**
+ * \brief Converts a whole waveform from one frequency to another
+ * \param output    receives the converted waveform
+ * \param input     the waveform to convert
+ * \param inputLen  length of input in bytes
+ * \param inRate    frequency of the input in Hz
+ * \param outRate   frequency the output should have in Hz
+ * \param format    AUDIO_S16 or AUDIO_U8
+ * \param channels  number of interleaved channels
+ */
+void resample(std::vector<Uint8> &output, const Uint8 *input, const size_t inputLen,
+              const int inRate, const int outRate,
+              const Uint16 format, const size_t channels);
 
 #endif /* SAMPLING_H_ */
@@ -687,6 +687,84 @@ static inline Bits Operator__GetSample(Operator *self, Bits modulation ) {
 	}
 }
 
+/*
+	Block helpers. Within one LFO block the vibrato and tremolo values don't change.
+	If an operator's envelope doesn't move either, the whole block can be worked out
+	in advance. The output is exactly the same as calling Operator__GetSample for every sample.
+*/
+
+//Set with DBOPL_SetReferenceMode, to render every operator sample by sample like before
+static int ReferenceMode = FALSE;
+
+void DBOPL_SetReferenceMode( int enable ) {
+	ReferenceMode = enable;
+}
+
+enum OperatorBlockKind {
+	OPB_NORMAL = 0,	//Envelope moves, every sample is computed as usual
+	OPB_FIXED,		//Envelope stays at one volume for the block
+	OPB_IDLE,		//Envelope stays silent for the block, only the phase moves on
+};
+
+typedef struct {
+	Bit8u kind;
+	Bitu vol;
+} OperatorBlock;
+
+//True if the volume handler would return self->volume and change nothing for this block
+static inline int Operator__EnvelopeSteady(const Operator *self) {
+	switch ( self->state ) {
+	case OPS_ATTACK:
+		return self->attackAdd == 0;
+	case OPS_DECAY:
+		return self->decayAdd == 0 && self->volume < self->sustainLevel;
+	case OPS_SUSTAIN:
+		if ( self->reg20 & MASK_SUSTAIN )
+			return TRUE;
+		return self->releaseAdd == 0 && self->volume < ENV_MAX;
+	case OPS_RELEASE:
+		return self->releaseAdd == 0 && self->volume < ENV_MAX;
+	default:
+		return FALSE;
+	}
+}
+
+//Call after Operator__Prepare
+static inline void Operator__PrepareBlock(const Operator *self, OperatorBlock *block) {
+	block->kind = OPB_NORMAL;
+	block->vol = 0;
+	if ( ReferenceMode )
+		return;
+	if ( self->state == OPS_OFF ) {
+		block->kind = OPB_IDLE;
+		return;
+	}
+	if ( !Operator__EnvelopeSteady( self ) )
+		return;
+	block->vol = self->currentLevel + self->volume;
+	block->kind = ENV_SILENT( block->vol ) ? OPB_IDLE : OPB_FIXED;
+}
+
+static inline Bits Operator__GetBlockSample(Operator *self, const OperatorBlock *block, Bits modulation ) {
+	switch ( block->kind ) {
+	case OPB_IDLE:
+		//Phase is moved on for the whole block afterwards
+		return 0;
+	case OPB_FIXED: {
+		Bitu index = Operator__ForwardWave(self);
+		index += modulation;
+		return Operator__GetWave( self, index, block->vol );
+	}
+	default:
+		return Operator__GetSample( self, modulation );
+	}
+}
+
+static inline void Operator__FinishBlock(Operator *self, const OperatorBlock *block, Bit32u samples ) {
+	if ( block->kind == OPB_IDLE )
+		self->waveIndex += samples * self->waveCurrent;
+}
+
 static void Operator__Operator(Operator *self) {
 	self->chanData = 0;
 	self->freqMul = 0;
@@ -1005,6 +1083,17 @@ Channel* Channel__BlockTemplate(Channel *self, Chip* chip,
                 Operator__Prepare( Channel__Op( self, 4 ), chip );
                 Operator__Prepare( Channel__Op( self, 5 ), chip );
 	}
+
+	//Percussion keeps the per sample path, everything else may skip work for the block
+	OperatorBlock blk[4];
+	const int numBlockOps = ( mode > sm6Start ) ? 0 : ( ( mode > sm4Start ) ? 4 : 2 );
+	for ( int o = 0; o < 4; o++ ) {
+		blk[o].kind = OPB_NORMAL;
+		blk[o].vol = 0;
+		if ( o < numBlockOps )
+			Operator__PrepareBlock( Channel__Op( self, o ), &blk[o] );
+	}
+
 	for ( i = 0; i < samples; i++ ) {
 		//Early out for percussion handlers
 		if ( mode == sm2Percussion ) {
@@ -1018,31 +1107,31 @@ Channel* Channel__BlockTemplate(Channel *self, Chip* chip,
 		//Do unsigned shift so we can shift out all bits but still stay in 10 bit range otherwise
 		Bit32s mod = (Bit32u)((self->old[0] + self->old[1])) >> self->feedback;
 		self->old[0] = self->old[1];
-		self->old[1] = Operator__GetSample( Channel__Op(self, 0), mod );
+		self->old[1] = Operator__GetBlockSample( Channel__Op(self, 0), &blk[0], mod );
 		Bit32s sample = 0;
 		Bit32s out0 = self->old[0];
 		if ( mode == sm2AM || mode == sm3AM ) {
-			sample = out0 + Operator__GetSample( Channel__Op(self, 1), 0 );
+			sample = out0 + Operator__GetBlockSample( Channel__Op(self, 1), &blk[1], 0 );
 		} else if ( mode == sm2FM || mode == sm3FM ) {
-			sample = Operator__GetSample( Channel__Op(self, 1), out0 );
+			sample = Operator__GetBlockSample( Channel__Op(self, 1), &blk[1], out0 );
 		} else if ( mode == sm3FMFM ) {
-			Bits next = Operator__GetSample( Channel__Op(self, 1), out0 );
-			next = Operator__GetSample( Channel__Op(self, 2), next );
-			sample = Operator__GetSample( Channel__Op(self, 3), next );
+			Bits next = Operator__GetBlockSample( Channel__Op(self, 1), &blk[1], out0 );
+			next = Operator__GetBlockSample( Channel__Op(self, 2), &blk[2], next );
+			sample = Operator__GetBlockSample( Channel__Op(self, 3), &blk[3], next );
 		} else if ( mode == sm3AMFM ) {
 			sample = out0;
-			Bits next = Operator__GetSample( Channel__Op(self, 1), 0 );
-			next = Operator__GetSample( Channel__Op(self, 2), next );
-			sample += Operator__GetSample( Channel__Op(self, 3), next );
+			Bits next = Operator__GetBlockSample( Channel__Op(self, 1), &blk[1], 0 );
+			next = Operator__GetBlockSample( Channel__Op(self, 2), &blk[2], next );
+			sample += Operator__GetBlockSample( Channel__Op(self, 3), &blk[3], next );
 		} else if ( mode == sm3FMAM ) {
-			sample = Operator__GetSample( Channel__Op(self, 1), out0 );
-			Bits next = Operator__GetSample( Channel__Op(self, 2), 0 );
-			sample += Operator__GetSample( Channel__Op(self, 3), next );
+			sample = Operator__GetBlockSample( Channel__Op(self, 1), &blk[1], out0 );
+			Bits next = Operator__GetBlockSample( Channel__Op(self, 2), &blk[2], 0 );
+			sample += Operator__GetBlockSample( Channel__Op(self, 3), &blk[3], next );
 		} else if ( mode == sm3AMAM ) {
 			sample = out0;
-			Bits next = Operator__GetSample( Channel__Op(self, 1), 0 );
-			sample += Operator__GetSample( Channel__Op(self, 2), next );
-			sample += Operator__GetSample( Channel__Op(self, 3), 0 );
+			Bits next = Operator__GetBlockSample( Channel__Op(self, 1), &blk[1], 0 );
+			sample += Operator__GetBlockSample( Channel__Op(self, 2), &blk[2], next );
+			sample += Operator__GetBlockSample( Channel__Op(self, 3), &blk[3], 0 );
 		}
 
 		sample *= SCALE_VOL;
@@ -1068,6 +1157,9 @@ Channel* Channel__BlockTemplate(Channel *self, Chip* chip,
 
 		}
 	}
+	for ( int o = 0; o < numBlockOps; o++ ) {
+		Operator__FinishBlock( Channel__Op( self, o ), &blk[o], samples );
+	}
 	switch( mode ) {
 	case sm2AM:
 	case sm2FM:
@@ -193,4 +193,8 @@ void Chip__Chip(Chip *self);
 void Chip__WriteReg(Chip *self, Bit32u reg, Bit8u val );
 void Chip__GenerateBlock2(Chip *self, uintptr_t total, Bit32s* output );
 
+// Operators whose envelope doesn't move are rendered a whole block at once. The output is the same.
+// With reference mode enabled every operator is rendered sample by sample again, e.g. to compare both.
+void DBOPL_SetReferenceMode( int enable );
+
 
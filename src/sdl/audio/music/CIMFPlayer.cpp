@@ -16,14 +16,45 @@
 #include <fstream>
 #include <string>
 #include <cassert>
+#include <chrono>
+#include <thread>
 
 
-CIMFPlayer::CIMFPlayer( COPLEmulator& opl_emulator ) :
-m_opl_emulator(opl_emulator),
-m_numreadysamples(0),
-m_IMFDelay(0)
+/**
+ * Synthesizes the music ahead of the audio callback
+ */
+class IMFRenderer : public Action
 {
-    m_samplesPerMusicTick = gSound.getAudioSpec().freq / m_opl_emulator.getIMFClockRate();
+public:
+    IMFRenderer(CIMFPlayer &player) :
+        mPlayer(player) {}
+
+    int handle()
+    {
+        while(!mPlayer.mStopRender)
+        {
+            if(!mPlayer.renderChunk())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(mPlayer.mIdleTime));
+            }
+        }
+        return 0;
+    }
+
+private:
+    CIMFPlayer &mPlayer;
+};
+
+
+CIMFPlayer::CIMFPlayer()
+{
+    memset(&mAudioSpec, 0, sizeof(mAudioSpec));
+}
+
+
+CIMFPlayer::~CIMFPlayer()
+{
+    stopRendering();
 }
 
 
@@ -53,15 +84,14 @@ bool CIMFPlayer::loadMusicFromFile(const std::string& filename)
         fseek(fp, 0, SEEK_SET);
     }
     
-    SDL_LockAudio();
-    
-    if(!m_IMF_Data.empty())
-        m_IMF_Data.clear();
+    // The callback only reads the synthesized waveform, so the song can be replaced without locking it
+    stopRendering();
 
     const word imf_chunks = (data_size/sizeof(IMFChunkType));
-    m_IMF_Data.reserve(imf_chunks);
+    mSequencer.clear();
+    mSequencer.song().resize(imf_chunks);
     
-    if( imf_chunks != fread( m_IMF_Data.getStartPtr(), sizeof(IMFChunkType), imf_chunks, fp ) )
+    if( imf_chunks != fread( mSequencer.song().data(), sizeof(IMFChunkType), imf_chunks, fp ) )
     {
         gLogging.textOut("The IMF-File seems to be corrupt.");
     }
@@ -72,53 +102,82 @@ bool CIMFPlayer::loadMusicFromFile(const std::string& filename)
     
     fclose(fp);
 
-    SDL_UnlockAudio();
-    
     return ok;
 }
 
 
 bool CIMFPlayer::loadMusicTrack(const int track)
 {
-    SDL_LockAudio();
-
-    if( m_IMF_Data.empty() )
-        m_IMF_Data.clear();
-
-    if(!gKeenFiles.exeFile.loadMusicTrack(m_IMF_Data, track))
-    {
-        SDL_UnlockAudio();
-        return false;
-    }
+    stopRendering();
 
-    SDL_UnlockAudio();
+    mSequencer.clear();
 
-    return true;
+    return gKeenFiles.exeFile.loadMusicTrack(mSequencer.song(), track);
 }
 
 
 
 bool CIMFPlayer::open(const bool lock)
 {
+    stopRendering();
+
+    // Make sure the callback is not reading while the ring is set up
     if(lock)  SDL_LockAudio();
+    mStreamReady = false;
+    if(lock) SDL_UnlockAudio();
+
+    // A copy, so a change of the audio settings can't alter the sizes the render thread works with
+    mAudioSpec = gSound.getAudioSpec();
+    const SDL_AudioSpec &audioSpec = mAudioSpec;
 
-	m_numreadysamples = m_IMFDelay = 0;
-    m_samplesPerMusicTick = gSound.getAudioSpec().freq / m_opl_emulator.getIMFClockRate();
+    mSequencer.rewind(audioSpec.freq, m_opl_emulator.getIMFClockRate());
 	
-	m_opl_emulator.setup();
+	m_opl_emulator.init(audioSpec.freq);
 
-    if(lock) SDL_UnlockAudio();
+    if(mSequencer.empty())
+        return false;
+
+    mFrameSize = audioSpec.channels*((audioSpec.format == AUDIO_S16) ? 2 : 1);
+    const size_t bytesPerSecond = size_t(audioSpec.freq)*mFrameSize;
+
+    mChunkSize = size_t(audioSpec.samples)*mFrameSize;
+    mIdleTime = std::max(1u, unsigned((mChunkSize*1000/bytesPerSecond)/2));
+
+    // Whole frames only, so the parts of the ring never split one
+    size_t leadSize = std::max(2*mChunkSize, (bytesPerSecond*IMFDefaultLeadTime)/1000);
+    leadSize -= leadSize % mFrameSize;
+    mPCMRing.reserve(leadSize);
 
-	return !m_IMF_Data.empty();
+    // Synthesize the start of the song right away, so the callback has something to play at once
+    while(renderChunk());
+
+    mStreamReady = true;
+
+    mStopRender = false;
+    mpRenderThread = threadPool->start(new IMFRenderer(*this), "IMF renderer");
+
+	return true;
+}
+
+void CIMFPlayer::stopRendering()
+{
+    if(!mpRenderThread)
+        return;
+
+    mStopRender = true;
+    threadPool->wait(mpRenderThread, nullptr);
+    mpRenderThread = nullptr;
 }
 
 void CIMFPlayer::close(const bool lock)
 {
+    stopRendering();
+
     if(lock)  SDL_LockAudio();
 
+    mStreamReady = false;
 	play(false);
-	m_IMF_Data.gotoStart();	
-	m_numreadysamples = m_IMFDelay = 0;	
+    mSequencer.rewind(mAudioSpec.freq, m_opl_emulator.getIMFClockRate());
 	m_opl_emulator.ShutAL();
 	m_opl_emulator.shutdown();
 
@@ -129,100 +188,33 @@ void CIMFPlayer::close(const bool lock)
 
 
 
-void CIMFPlayer::OPLUpdate(byte *buffer, const unsigned int length)
-{    
-    auto &audioSpec = gSound.getAudioSpec();
+void CIMFPlayer::readBuffer(Uint8* buffer, Uint32 length)
+{
+    if(!m_playing || !mStreamReady)
+        return;
+
+    const size_t got = mPCMRing.pop(buffer, length);
 
-    if(mMixBuffer.empty())
+    // The render thread did not keep up, better a short silence than a stall
+    if(got < length)
     {
-        gLogging.textOut("Creating enough Audio Buffer for the IMF-Player");
-        mMixBuffer.assign(audioSpec.samples, 0);
+        memset(buffer+got, mAudioSpec.silence, length-got);
     }
-
-    m_opl_emulator.Chip__GenerateBlock2( length, mMixBuffer.data() );
-
-    // Mix into the destination buffer, doubling up into stereo.
-    if(audioSpec.format == AUDIO_S16)
-	{
-		Sint16 *buf16 = (Sint16*) (void*) buffer;
-		for (unsigned int i=0; i<length; ++i)
-		{
-		    Sint32 mix = mMixBuffer[i];
-		    
-		    if(mix > 32767)
-			    mix = 32767;
-		    else if(mix < -32768)
-			    mix = -32768;
-		    
-            for (unsigned int j=0; j<audioSpec.channels; j++)
-			{
-                *buf16 = mix + audioSpec.silence;
-				buf16++;
-			}
-		}
-	}
-    else if(audioSpec.format == AUDIO_U8)
-	{
-		for (unsigned int i=0; i<length; ++i)
-		{
-		    Sint32 mix = mMixBuffer[i]>>8;
-		    
-		    if(mix > 255)
-			    mix = 255;
-		    else if(mix < 0)
-			    mix = 0;
-		    
-            for (unsigned int j=0; j<audioSpec.channels; j++)
-			{
-                *buffer = mix + audioSpec.silence;
-				buffer++;
-			}
-		}
-	}
 }
 
-void CIMFPlayer::readBuffer(Uint8* buffer, Uint32 length)
+bool CIMFPlayer::renderChunk()
 {
-    if(!m_playing)
-        return;
+    // The OPL emulator writes right into the ring
+    const auto spans = mPCMRing.writeSpans(mChunkSize);
 
-    auto &audioSpec = gSound.getAudioSpec();
+    if(spans.size() < mChunkSize)
+        return false;
 
-    
-    /// if a delay of the instruments is pending, play it
-    Uint32 sampleslen = audioSpec.samples;
-    Uint32 sample_mult = audioSpec.channels;
-    sample_mult = (audioSpec.format == AUDIO_S16) ? sample_mult*sizeof(Sint16) : sample_mult*sizeof(Uint8) ;
-	
-	// while the waveform is not filled
-    while(1)
-    {
-        while( m_IMFDelay == 0 )
-        {
-            //read next IMF event
-            const IMFChunkType Chunk = m_IMF_Data.getNextElement();
-            m_IMFDelay = Chunk.Delay;
+    mSequencer.render(m_opl_emulator, spans.first.data, spans.first.size/mFrameSize, mAudioSpec);
 
-            //write reg+val to opl chip
-            m_opl_emulator.Chip__WriteReg( Chunk.al_reg, Chunk.al_dat );
-            m_numreadysamples = m_samplesPerMusicTick*m_IMFDelay;
-        }
+    if(spans.second.size > 0)
+        mSequencer.render(m_opl_emulator, spans.second.data, spans.second.size/mFrameSize, mAudioSpec);
 
-        //generate <delay> ticks of audio
-        if(m_numreadysamples < sampleslen)
-        {
-            // Every time a tune has been played call this.
-            OPLUpdate( buffer, m_numreadysamples );
-            buffer += m_numreadysamples*sample_mult;
-            sampleslen -= m_numreadysamples;
-            m_IMFDelay = 0;
-        }
-        else
-        {
-            // Read the last stuff left in the emulators buffer. At this point the stream buffer is nearly full
-            OPLUpdate( buffer, sampleslen );
-            m_numreadysamples -= sampleslen;
-            break;
-        }
-    }
+    mPCMRing.commitWrite(spans.size());
+    return true;
 }
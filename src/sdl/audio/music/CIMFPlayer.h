@@ -12,20 +12,22 @@
 #include <base/TypeDefinitions.h>
 #include "sdl/audio/Audio.h"
 #include "CRingBuffer.h"
+#include "IMFSequencer.h"
+#include <base/utils/ThreadPool.h>
 #include <SDL.h>
 #include <string>
+#include <atomic>
+#include <vector>
 
-struct IMFChunkType
-{
-	byte al_reg;
-	byte al_dat;
-	word Delay;
-};
+/** How much IMF music is synthesized ahead of the audio callback (in ms).
+  */
+const unsigned int IMFDefaultLeadTime = 100;
 
 class CIMFPlayer : public CMusicPlayer
 {
 public:
-    CIMFPlayer( COPLEmulator& opl_emulator = gSound.getOPLEmulatorRef());
+    CIMFPlayer();
+    virtual ~CIMFPlayer();
 
 
 	/**
@@ -35,30 +37,52 @@ public:
 	 */
     bool loadMusicFromFile(const std::string& filename);
 
-	void OPLUpdate(byte *buffer, const unsigned int length);
-
+    /**
+     * @brief open  Resets the OPL chip, synthesizes the lead of the song and starts the render thread.
+     *              The audio format is taken from the sound driver now and kept until the next open.
+     */
     bool open(const bool lock);
     void close(const bool lock);
+
+    /**
+     * @brief readBuffer Called by the audio callback. It only copies what the render thread has synthesized.
+     */
 	void readBuffer(Uint8* buffer, Uint32 length);
 
+    void stopRendering() override;
+
 
     bool loadMusicTrack(const int track) override;
 
 private:
 
-		
+    friend class IMFRenderer;
+
+    // Synthesizes the next chunk into the ring. Returns false if the ring has no room for it.
+    bool renderChunk();
+
     bool unpackAudioInterval(const std::string &dataPath,
                 const std::vector<uint8_t> &AudioCompFileData,
                 const int start,
                 const int end);
 
-	RingBuffer<IMFChunkType> m_IMF_Data;
-    COPLEmulator &m_opl_emulator;
+    IMFSequencer mSequencer;
+
+    // Only the render thread clocks it, so nothing else may reset it while the music plays
+    COPLEmulator m_opl_emulator;
+
+    // Format the song is synthesized in, as it was when the player was opened
+    SDL_AudioSpec mAudioSpec;
+
+    // Synthesized waveform waiting for the callback
+    RingBuffer<Uint8> mPCMRing;
+    size_t mChunkSize = 0;    // in bytes
+    size_t mFrameSize = 0;
+    unsigned int mIdleTime = 1;   // ms the render thread sleeps while the ring is full
 
-    Uint32 m_numreadysamples = 0;
-    Uint32 m_samplesPerMusicTick =0;
-    unsigned int m_IMFDelay = 0;
-    std::vector<Sint32> mMixBuffer;
+    ThreadPoolItem *mpRenderThread = nullptr;
+    std::atomic<bool> mStopRender{false};
+    std::atomic<bool> mStreamReady{false};
 };
 
 #endif /* CIMFPLAYER_H_ */
@@ -19,40 +19,54 @@
 #include <limits>
 
 
-bool CMusic::loadTrack(const int track)
+void CMusic::takeOver(std::unique_ptr<CMusicPlayer> &newPlayer)
 {
+    // The callback keeps playing the old player until here, so the switch has no gap
+    SDL_LockAudio();
+    mpPlayer.swap(newPlayer);
+    SDL_UnlockAudio();
 
-    gSound.pauseAudio();
+    // The old one is destroyed outside of the lock
+    newPlayer.reset();
+}
 
+
+bool CMusic::loadTrack(const int track)
+{
     gLogging.textOut("Load track number " + itoa(track) + "");
 
 #if defined(OGG) || defined(TREMOR)
-    mpPlayer.reset( new COGGPlayer );
-
-    if(mpPlayer->loadMusicTrack(track))
     {
-        gSound.resumeAudio();
-        return true;
+        std::unique_ptr<CMusicPlayer> oggPlayer( new COGGPlayer );
+
+        if(oggPlayer->loadMusicTrack(track))
+        {
+            takeOver(oggPlayer);
+            return true;
+        }
     }
 #endif
 
-    mpPlayer.reset( new CIMFPlayer );
-    if(!mpPlayer->loadMusicTrack(track))
+    std::unique_ptr<CMusicPlayer> imfPlayer( new CIMFPlayer );
+    if(!imfPlayer->loadMusicTrack(track))
     {
         gLogging.textOut("No music to be loaded for Track" + itoa(track) + ".");
     }
 
-    gSound.resumeAudio();
+    imfPlayer->open(false);
+    takeOver(imfPlayer);
 	return true;
 }
 
 
 bool CMusic::load(const std::string &musicfile)
 {        
-	mpPlayer.reset();
-
 	if(musicfile == "")
+	{
+	    std::unique_ptr<CMusicPlayer> none;
+	    takeOver(none);
 		return false;
+	}
 
 	const SDL_AudioSpec &audioSpec = gSound.getAudioSpec();
 
@@ -60,46 +74,51 @@ bool CMusic::load(const std::string &musicfile)
 	{
 		std::string extension = GetFileExtension(musicfile);
 
-        gSound.pauseAudio();
-
 		stringlwr(extension);
 
+        std::unique_ptr<CMusicPlayer> newPlayer;
+
 		if( extension == "imf" )
 		{
-            mpPlayer.reset( new CIMFPlayer );
+            newPlayer.reset( new CIMFPlayer );
 
-            if(!mpPlayer->loadMusicFromFile(musicfile))
+            if(!newPlayer->loadMusicFromFile(musicfile))
             {
+                newPlayer.reset();
+                takeOver(newPlayer);
                 return false;
             }
 		}
 		else if( extension == "ogg" )
 		{
 #if defined(OGG) || defined(TREMOR)
-            mpPlayer.reset( new COGGPlayer );
-            mpPlayer->loadMusicFromFile(musicfile);
+            newPlayer.reset( new COGGPlayer );
+            newPlayer->loadMusicFromFile(musicfile);
 #else
 		    gLogging.ftextOut("Music Manager: Neither OGG bor TREMOR-Support are enabled! Please use another build<br>");
-            gSound.resumeAudio();
+		    std::unique_ptr<CMusicPlayer> none;
+		    takeOver(none);
 		    return false;
 #endif
 		}
 
-        if(!mpPlayer->open(true))
+        // Opening prepares the start of the tune while the old one is still playing
+        if(!newPlayer || !newPlayer->open(false))
 		{
-		    mpPlayer.reset();
+		    newPlayer.reset();
+		    takeOver(newPlayer);
 		    gLogging.textOut(FONTCOLORS::PURPLE,"Music Manager: File could not be opened: \"%s\". File is damaged or something is wrong with your soundcard!<br>", musicfile.c_str());
-
-            gSound.resumeAudio();
 		    return false;
         }
 
-        gSound.resumeAudio();
+        takeOver(newPlayer);
 		return true;
 
 	}
 	else
 	{
+		std::unique_ptr<CMusicPlayer> none;
+		takeOver(none);
 		gLogging.textOut(FONTCOLORS::PURPLE,"Music Manager: I would like to open the music for you. But your Soundcard seems to be disabled!!<br>");
 	}
 
@@ -122,6 +141,14 @@ void CMusic::reload()
     gSound.resumeAudio();
 }
 
+void CMusic::stopRendering()
+{
+    if(!mpPlayer)
+        return;
+
+    mpPlayer->stopRendering();
+}
+
 void CMusic::play()
 {
 	if(!mpPlayer)
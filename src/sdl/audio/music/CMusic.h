@@ -38,6 +38,13 @@ public:
     bool load(const std::string &musicfile);
 
 	void reload();
+
+    /**
+     * Stops the thread which produces the music ahead of time. Call it before the audio
+     * format changes, reload() starts it again with the new one.
+     */
+    void stopRendering();
+
 	void play();
 	void pause();
 	void stop();
@@ -64,6 +71,13 @@ public:
 
 private:
 
+    /**
+     * Makes newPlayer the one the audio callback reads from. The lock is only held for the swap,
+     * so the new player should be opened (and prefilled) before. newPlayer receives the old player,
+     * which is destroyed right away.
+     */
+    void takeOver(std::unique_ptr<CMusicPlayer> &newPlayer);
+
 	std::unique_ptr<CMusicPlayer> mpPlayer;
 
 };
@@ -29,6 +29,12 @@ public:
 	void play(const bool value);
     virtual void close(const bool lock) = 0;
 
+    /**
+     * Stops producing samples ahead of time. Whatever has been produced already can still be played.
+     * Must be called before the audio device is set up with another format.
+     */
+    virtual void stopRendering() {}
+
 	bool playing() const { return m_playing; }
 
 protected:
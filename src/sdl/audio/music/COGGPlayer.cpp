@@ -16,6 +16,36 @@
 
 #include "fileio/KeenFiles.h"
 
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+
+/**
+ * Keeps the ring of the player filled, so decoding never happens in the audio callback
+ */
+class OGGDecoder : public Action
+{
+public:
+    OGGDecoder(COGGPlayer &player) :
+        mPlayer(player) {}
+
+    int handle()
+    {
+        while(!mPlayer.mStopDecoder)
+        {
+            if(mPlayer.mPCMRing.writeAvailable() >= mPlayer.mMaxChunkSize)
+                mPlayer.decodeChunk();
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(mPlayer.mIdleTime));
+        }
+        return 0;
+    }
+
+private:
+    COGGPlayer &mPlayer;
+};
+
 
 COGGPlayer::COGGPlayer() :
 m_pcm_size(0),
@@ -79,9 +109,6 @@ bool COGGPlayer::open(const bool lock)
         close(lock);
     }
 
-    if(lock) SDL_LockAudio();
-
-
     auto &audioSpec = gSound.getAudioSpec();
 
 	// If Ogg detected, decode it into the stream psound->sound_buffer.
@@ -90,7 +117,6 @@ bool COGGPlayer::open(const bool lock)
 
     if(ov_fopen((char*)GetFullFileName(m_filename).c_str(), &m_oggStream) != 0)
     {
-        if(lock) SDL_UnlockAudio();
         return false;
     }
 
@@ -118,6 +144,7 @@ bool COGGPlayer::open(const bool lock)
     m_pcm_size = ov_pcm_total(&m_oggStream,-1);
     m_pcm_size *= (mVorbisInfo->channels*sizeof(Sint16));
     m_music_pos = 0;
+    mDeviceFreq = audioSpec.freq;
 
 
     gLogging.ftextOut("OGG-Player: File \"%s\" has been opened successfully!<br>", m_filename.c_str());
@@ -127,24 +154,67 @@ bool COGGPlayer::open(const bool lock)
 
 	if(ret == -1)
     {
-        if(lock) SDL_UnlockAudio();
+        ov_clear(&m_oggStream);
 		return false;
     }
 
     const size_t length = audioSpec.size;
-    #if SDL_VERSION_ATLEAST(2, 0, 0)
-    #else
-        m_Audio_cvt.len_cvt = 0;
-    #endif
 
     m_Audio_cvt.len = (length)/m_Audio_cvt.len_ratio;
 
     m_Audio_cvt.len = (m_Audio_cvt.len>>2)<<2;
 
-    m_Audio_cvt.buf = new Uint8[m_Audio_cvt.len*m_Audio_cvt.len_mult];
+    mChunkLen = m_Audio_cvt.len;
+    size_t bufferLen = mChunkLen;
+
+    if( !mHasCommonFreqBase )
+    {
+        // Read about as much as gives one chunk at the rate of the device
+        const size_t frameSize = m_AudioFileSpec.channels*sizeof(Sint16);
+        mResampleInLen = ((size_t(mChunkLen)*mVorbisInfo->rate)/audioSpec.freq/frameSize + 1)*frameSize;
+
+        if(!mResampler.setup(mVorbisInfo->rate, audioSpec.freq,
+                             m_AudioFileSpec.format, m_AudioFileSpec.channels))
+        {
+            ov_clear(&m_oggStream);
+            return false;
+        }
+
+        bufferLen = std::max(bufferLen, mResampler.maxOutputLen(mResampleInLen));
+    }
+
+    mBufferLen = bufferLen;
+    m_Audio_cvt.buf = new Uint8[mBufferLen*m_Audio_cvt.len_mult];
+
+    // That is the most one chunk can become after the conversion
+    mMaxChunkSize = size_t(std::ceil(mBufferLen*m_Audio_cvt.len_ratio));
+
+    // Size the ring for the lead time, but at least for two chunks
+    const size_t bytesPerSecond = size_t(audioSpec.freq)*audioSpec.channels*
+                                  ((audioSpec.format == AUDIO_S16) ? 2 : 1);
+    const size_t leadSize = std::max(2*mMaxChunkSize, (bytesPerSecond*mLeadTime)/1000);
 
+    mIdleTime = std::max(1u, unsigned((mChunkLen*m_Audio_cvt.len_ratio*1000/bytesPerSecond)/2));
+
+    // Make sure the callback is not reading while the ring is set up
+    if(lock) SDL_LockAudio();
+    mStreamReady = false;
     if(lock) SDL_UnlockAudio();
 
+    mPCMRing.reserve(leadSize);
+
+    // Decode the start of the track right away, so a song change never
+    // leaves the callback without anything to play
+    while(mPCMRing.writeAvailable() >= mMaxChunkSize)
+    {
+        decodeChunk();
+    }
+
+    mStreamReady = true;
+
+    mStopDecoder = false;
+    mpDecoderThread = threadPool->start(new OGGDecoder(*this), "OGG decoder");
+
     return true;
 }
 
@@ -190,87 +260,79 @@ bool COGGPlayer::readOGGStream(char *buffer, const size_t &size, const SDL_Audio
 	return false;
 }
 
-bool COGGPlayer::readOGGStreamAndResample( Uint8 *buffer,
-                                           const int output_size,
-                                           const size_t input_size,
-                                           const SDL_AudioSpec &OGGAudioSpec )
+void COGGPlayer::decodeChunk()
 {
-    mResampleBuf.resize(input_size);
-
-    // In case format has not been converted yet...
-    if(output_size<0)
-        return false;
-
-    bool eof = readOGGStream( reinterpret_cast<char*>(mResampleBuf.data()), input_size, OGGAudioSpec );
-
-    resample( buffer, mResampleBuf.data(), output_size, input_size, OGGAudioSpec.format, OGGAudioSpec.channels);
-
-	return eof;
-}
-
-void COGGPlayer::readBuffer(Uint8* buffer, Uint32 length)
-{
-	if(!m_playing || !m_Audio_cvt.buf)
-		return;
-
-    auto &audioSpec = gSound.getAudioSpec();
-    auto freq = audioSpec.freq;
-
 	bool rewind = false;
 
 	// read the ogg stream
     if( !mHasCommonFreqBase )
 	{
-        Uint64 insize = (m_Audio_cvt.len*mVorbisInfo->rate)/freq;
-		Uint8 mult = m_AudioFileSpec.channels;
-
-		if(m_AudioFileSpec.format == AUDIO_S16)
-			mult <<= 1;
-
-		insize /= mult;
-		insize++;
-		insize *= mult;
+        mResampleBuf.resize(mResampleInLen);
+        rewind = readOGGStream(reinterpret_cast<char*>(mResampleBuf.data()),
+                               mResampleInLen,
+                               m_AudioFileSpec);
 
+        // The resampler keeps its history over chunks and loops, so there are no clicks in between
+        mResampledBuf.clear();
+        mResampler.process(mResampleBuf.data(), mResampleInLen, mResampledBuf);
 
-        rewind = readOGGStreamAndResample(m_Audio_cvt.buf,
-                                          m_Audio_cvt.len_cvt,
-                                          insize,
-                                          m_AudioFileSpec);
+        const size_t len = std::min(mResampledBuf.size(), mBufferLen);
+        memcpy(m_Audio_cvt.buf, mResampledBuf.data(), len);
+        m_Audio_cvt.len = int(len);
     }
     else
 	{
+        m_Audio_cvt.len = int(mChunkLen);
         rewind = readOGGStream(reinterpret_cast<char*>(m_Audio_cvt.buf),
                                m_Audio_cvt.len,
                                m_AudioFileSpec);
     }
 
-    if(m_Audio_cvt.buf == nullptr)
-    {
-        close(false);
-        open(false);
-        play(true);
-        return;
-    }    
-
 	// then convert it into SDL Audio buffer
 	// Conversion to SDL Format
 	SDL_ConvertAudio(&m_Audio_cvt);
 
-	memcpy(buffer, m_Audio_cvt.buf, length);
+    mPCMRing.push(m_Audio_cvt.buf, m_Audio_cvt.len_cvt);
 
 	if(rewind)
 	{
-        close(false);
-        open(false);
-		play(true);
+        // Loop the track without closing and reopening the file
+        ov_pcm_seek(&m_oggStream, 0);
 	}
+}
 
+void COGGPlayer::readBuffer(Uint8* buffer, Uint32 length)
+{
+	if(!m_playing || !mStreamReady)
+		return;
+
+    const size_t got = mPCMRing.pop(buffer, length);
+
+    // The decoder did not keep up, better a short silence than a stall
+    if(got < length)
+    {
+        memset(buffer+got, gSound.getAudioSpec().silence, length-got);
+    }
+}
+
+void COGGPlayer::stopDecoder()
+{
+    if(!mpDecoderThread)
+        return;
+
+    mStopDecoder = true;
+    threadPool->wait(mpDecoderThread, nullptr);
+    mpDecoderThread = nullptr;
 }
 
 void COGGPlayer::close(const bool lock)
 {
+    stopDecoder();
+
     if(lock)  SDL_LockAudio();
 
+    mStreamReady = false;
+
  	if(m_Audio_cvt.buf)
     {
 		delete [] m_Audio_cvt.buf;
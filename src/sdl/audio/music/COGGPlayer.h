@@ -24,7 +24,16 @@
 
 #include <SDL.h>
 #include <string>
+#include <atomic>
 #include <fileio/CExeFile.h>
+#include <base/utils/ThreadPool.h>
+#include "CRingBuffer.h"
+#include "sdl/audio/base/Sampling.h"
+
+/** How much music is decoded ahead of the audio callback by default (in ms).
+  * More lead survives longer hiccups of the decoder thread at the cost of memory.
+  */
+const unsigned int OGGDefaultLeadTime = 250;
 
 
 class COGGPlayer : public CMusicPlayer
@@ -40,14 +49,35 @@ public:
 
     bool open(const bool lock);
 
+    /**
+     * @brief readBuffer Called by the audio callback. It only copies what the decoder thread
+     *                   has prepared and plays silence if that ran dry.
+     */
 	void readBuffer(Uint8* buffer, Uint32 length);
 
     void close(const bool lock);
 
+    void stopRendering() override
+    {   stopDecoder();  }
+
+    /**
+     * @brief setLeadTime Sets how much music is decoded ahead. Applies when the stream is opened next time.
+     * @param ms    lead time in milliseconds
+     */
+    void setLeadTime(const unsigned int ms)
+    {   mLeadTime = ms;  }
+
 private:
 
+    friend class OGGDecoder;
+
+    // Decodes, resamples and converts the next chunk of the stream into the ring.
+    // Only the decoder thread (or open() before it starts) may call this.
+    void decodeChunk();
+
+    void stopDecoder();
+
     bool readOGGStream(char *buffer, const size_t &size, const SDL_AudioSpec &OGGAudioSpec );
-    bool readOGGStreamAndResample(Uint8 *buffer, const int output_size, const size_t input_size, const SDL_AudioSpec &OGGAudioSpec );
 
 	OggVorbis_File  m_oggStream;
 	std::string m_filename;
@@ -59,7 +89,25 @@ private:
     vorbis_info*    mVorbisInfo;    // some formatting data
     bool mHasCommonFreqBase;
 
+    // Used if the frequencies don't share a base
+    Resampler mResampler;
     std::vector<Uint8> mResampleBuf;
+    std::vector<Uint8> mResampledBuf;
+    size_t mResampleInLen = 0;
+
+    size_t mChunkLen = 0;       // bytes read from the stream per chunk
+    size_t mBufferLen = 0;      // size of the conversion buffer before conversion
+    size_t mMaxChunkSize = 0;   // most bytes one chunk adds to the ring
+
+    // Decoded waveform in the format of the audio device, waiting to be played
+    RingBuffer<Uint8> mPCMRing;
+    unsigned int mLeadTime = OGGDefaultLeadTime;
+    unsigned int mIdleTime = 1;   // ms the decoder sleeps while the ring is full
+    int mDeviceFreq = 0;
+
+    ThreadPoolItem *mpDecoderThread = nullptr;
+    std::atomic<bool> mStopDecoder{false};
+    std::atomic<bool> mStreamReady{false};
 };
 
 #if defined(TREMOR)
@@ -0,0 +1,68 @@
+/*
+ * IMFSequencer.cpp
+ *
+ *  Created on: 18.10.2026
+ */
+
+#include "IMFSequencer.h"
+
+
+void IMFSequencer::clear()
+{
+    mSong.clear();
+    mPos = 0;
+    mReadySamples = mDelay = 0;
+}
+
+
+void IMFSequencer::rewind(const unsigned int sampleRate, const unsigned int imfClockRate)
+{
+    mPos = 0;
+    mReadySamples = mDelay = 0;
+    mSamplesPerTick = sampleRate / imfClockRate;
+}
+
+
+void IMFSequencer::render(COPLEmulator &opl, Uint8 *buffer, Uint32 samples, const SDL_AudioSpec &audioSpec)
+{
+    if(mSong.empty())
+        return;
+
+    Uint32 sample_mult = audioSpec.channels;
+    sample_mult = (audioSpec.format == AUDIO_S16) ? sample_mult*sizeof(Sint16) : sample_mult*sizeof(Uint8) ;
+
+	// while the waveform is not filled
+    while(1)
+    {
+        while( mDelay == 0 )
+        {
+            //read next IMF event
+            const IMFChunkType &Chunk = mSong[mPos];
+
+            if(++mPos == mSong.size())
+                mPos = 0;
+
+            mDelay = Chunk.Delay;
+
+            //write reg+val to opl chip
+            opl.Chip__WriteReg( Chunk.al_reg, Chunk.al_dat );
+            mReadySamples = mSamplesPerTick*mDelay;
+        }
+
+        //generate <delay> ticks of audio
+        if(mReadySamples < samples)
+        {
+            opl.renderInto( buffer, mReadySamples, audioSpec );
+            buffer += mReadySamples*sample_mult;
+            samples -= mReadySamples;
+            mDelay = 0;
+        }
+        else
+        {
+            // Read the last stuff left in the emulators buffer. At this point the stream buffer is nearly full
+            opl.renderInto( buffer, samples, audioSpec );
+            mReadySamples -= samples;
+            break;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * IMFSequencer.h
+ *
+ *  Created on: 18.10.2026
+ *
+ *  Plays IMF songs on an OPL emulator. It only knows the song, the chip and
+ *  the format it renders to, so the engine's player and the offline tools
+ *  run exactly the same code.
+ */
+
+#ifndef IMFSEQUENCER_H_
+#define IMFSEQUENCER_H_
+
+#include <base/TypeDefinitions.h>
+#include "sdl/audio/base/COPLEmulator.h"
+#include <SDL.h>
+#include <vector>
+
+struct IMFChunkType
+{
+	byte al_reg;
+	byte al_dat;
+	word Delay;
+};
+
+class IMFSequencer
+{
+public:
+
+    /// The register writes of the song. Call rewind() after changing them.
+    std::vector<IMFChunkType> &song()
+    {   return mSong;   }
+
+    bool empty() const
+    {   return mSong.empty();   }
+
+    void clear();
+
+    /**
+     * @brief rewind    Starts the song from the beginning
+     * @param sampleRate    rate at which the chip generates samples
+     * @param imfClockRate  rate of the delays in the song (560 Hz in Keen)
+     */
+    void rewind(const unsigned int sampleRate, const unsigned int imfClockRate);
+
+    /**
+     * @brief render    Plays the song on the chip until buffer holds the given number of frames.
+     *                  At the end the song goes on with its start without a gap.
+     */
+    void render(COPLEmulator &opl, Uint8 *buffer, Uint32 samples, const SDL_AudioSpec &audioSpec);
+
+private:
+
+	std::vector<IMFChunkType> mSong;
+    size_t mPos = 0;     // Next chunk to be played
+
+    Uint32 mReadySamples = 0;
+    Uint32 mSamplesPerTick = 0;
+    unsigned int mDelay = 0;
+};
+
+#endif /* IMFSEQUENCER_H_ */
@@ -27,6 +27,7 @@ void CSoundChannel::stopSound()
     mpCurrentSndSlot = nullptr;
     mBalance = 0;
     mSoundPtr = 0;
+    mStartDelay = 0;
     mSoundPaused = true;
     mSoundPlaying = false;
 
@@ -34,7 +35,8 @@ void CSoundChannel::stopSound()
 }
 
 void CSoundChannel::setupSound( CSoundSlot &SndSlottoPlay,
-								const bool sound_forced )
+								const bool sound_forced,
+								const Uint32 startDelay )
 {
     SDL_LockAudio();
 
@@ -42,10 +44,36 @@ void CSoundChannel::setupSound( CSoundSlot &SndSlottoPlay,
     mSoundPlaying = true;
     mSoundPtr = 0;
     mSoundForced = sound_forced;
+    mStartDelay = startDelay;
 
     SDL_UnlockAudio();
 }
 
+Uint32 CSoundChannel::audibleGain() const
+{
+    if(mBalance == 0 || m_AudioSpec.channels != 2)
+        return 256;
+
+    // Same amounts as in transintoStereoChannels
+    Sint32 leftamt = -mBalance;
+    Sint32 rightamt = mBalance;
+
+    if(leftamt > 127)
+    {
+        leftamt = 254 - leftamt;
+        rightamt = 0;
+    }
+
+    if(rightamt > 127)
+    {
+        rightamt = 254 - rightamt;
+        leftamt = 0;
+    }
+
+    const Sint32 louder = (leftamt > rightamt) ? leftamt : rightamt;
+    return Uint32(129 + louder);
+}
+
 /** \brief This program reads the balance information and balances the stereo sound
  * 	\param waveform	pass it as 8-bit or 16-bit Waveform pointer depeding on what depth you have
  *  \param len 		length in bytes of the waveform
@@ -99,19 +127,31 @@ void CSoundChannel::readWaveform( Uint8 * const waveform, const Uint32 len )
     auto snddata = mpCurrentSndSlot->getSoundData();
     const Uint32 sndlength = mpCurrentSndSlot->getSoundlength();
 
-    if ((mSoundPtr + len) >= sndlength)
+    // A queued sound may begin somewhere inside this buffer
+    const Uint32 delay = (mStartDelay < len) ? mStartDelay : len;
+    memset(waveform, m_AudioSpec.silence, delay);
+    mStartDelay -= delay;
+
+    Uint8 * const sndwave = waveform + delay;
+    const Uint32 sndlen = len - delay;
+
+    if(sndlen == 0)
+    {
+        // Still waiting for its start
+    }
+    else if ((mSoundPtr + sndlen) >= sndlength)
 	{
 		// Fill up the buffer and the rest with silence
         const Uint32 len_left = sndlength-mSoundPtr;
-        memcpy(waveform, snddata + mSoundPtr, len_left );
-		memset(waveform+len_left, m_AudioSpec.silence, len-len_left );
+        memcpy(sndwave, snddata + mSoundPtr, len_left );
+		memset(sndwave+len_left, m_AudioSpec.silence, sndlen-len_left );
         mSoundPtr = 0;
         mSoundPlaying = false;
 	}
 	else
 	{
-        memcpy(waveform, snddata + mSoundPtr, len );
-        mSoundPtr += len;
+        memcpy(sndwave, snddata + mSoundPtr, sndlen );
+        mSoundPtr += sndlen;
 	}
 
 	if(m_AudioSpec.channels == 2)
@@ -126,3 +166,27 @@ void CSoundChannel::readWaveform( Uint8 * const waveform, const Uint32 len )
         }
 	}
 }
+
+void CSoundChannel::skipWaveform( const Uint32 len )
+{
+    const Uint32 sndlength = mpCurrentSndSlot->getSoundlength();
+
+    const Uint32 delay = (mStartDelay < len) ? mStartDelay : len;
+    mStartDelay -= delay;
+
+    const Uint32 sndlen = len - delay;
+
+    if(sndlen == 0)
+    {
+        // Still waiting for its start
+    }
+    else if ((mSoundPtr + sndlen) >= sndlength)
+	{
+        mSoundPtr = 0;
+        mSoundPlaying = false;
+	}
+	else
+	{
+        mSoundPtr += sndlen;
+	}
+}
@@ -50,9 +50,9 @@ public:
     CSoundChannel(const SDL_AudioSpec &AudioSpec);
 
 	void stopSound();
-    bool isPlaying() { return mSoundPlaying; }
-    bool isForcedPlaying() { return (mSoundPlaying && mSoundForced); }
-    CSoundSlot *getCurrentSoundPtr() { return mpCurrentSndSlot; }
+    bool isPlaying() const { return mSoundPlaying; }
+    bool isForcedPlaying() const { return (mSoundPlaying && mSoundForced); }
+    CSoundSlot *getCurrentSoundPtr() const { return mpCurrentSndSlot; }
 
 	/**
 	 * \brief	Reads the sound of a specified slot into the waveform which normally is mixed
@@ -62,6 +62,18 @@ public:
 	 * 			It might crash. Call setupSound first before you call this one!
 	 */
 	void readWaveform( Uint8 * const waveform, const Uint32 len );
+
+	/**
+	 * \brief	Advances the sound like readWaveform does, but without producing any samples.
+	 * 			Used for channels which are not important enough to be mixed right now.
+	 * \param	len	length in bytes that would have been read
+	 */
+	void skipWaveform( const Uint32 len );
+
+	/**
+	 * \brief	How loud the sound gets through its balance on the louder speaker. 256 means unchanged.
+	 */
+	Uint32 audibleGain() const;
 	template <typename T>
 	void transintoStereoChannels(T* waveform, const Uint32 len);
 
@@ -72,9 +84,11 @@ public:
 	 * \brief	Sets up the slot to play a sound
 	 * \param	SndSlottoPlay	Reference to the slot that has to be played
 	 * \param	sound_forced	This will play a sound again even if it's already playing. Use this one wise
+	 * \param	startDelay		bytes of silence before the sound begins, so it can start in the middle of a buffer
 	 */
 	void setupSound(CSoundSlot &SndSlottoPlay,
-					const bool sound_forced );
+					const bool sound_forced,
+					const Uint32 startDelay = 0 );
 
 private:
     bool mSoundPlaying;           	// true = a sound is currently playing
@@ -82,6 +96,7 @@ private:
     Uint32 mSoundPtr;               	// position within sound that we're at
     bool mSoundPaused;             	// true = pause playback
     bool mSoundForced;
+    Uint32 mStartDelay;             	// bytes of silence left before the sound begins
 
     short mBalance;					// This variable is used for stereo sound, and to calculate where the sound must be played!
 
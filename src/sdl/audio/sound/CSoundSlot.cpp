@@ -109,7 +109,7 @@ void CSoundSlot::setupWaveForm( const std::vector<Uint8>& waveform )
 {
 	m_soundlength = waveform.size();
     mSounddata.resize(m_soundlength);
-    memcpy(mSounddata.data(), &waveform[0], m_soundlength);
+    memcpy(mSounddata.data(), waveform.data(), m_soundlength);
 }
 
 bool CSoundSlot::HQSndLoad(const std::string& gamepath, const std::string& soundname)
@@ -197,29 +197,18 @@ bool CSoundSlot::HQSndLoad(const std::string& gamepath, const std::string& sound
 	SDL_ConvertAudio(&Audio_cvt);
 
 	// copy the converted stuff to the original soundbuffer
-    Uint8 *buffer;
     if( !mHasCommonFreqBase )
 	{
-        const float factor = float(audioSpec.freq)/mOggFreq;
-		length = Audio_cvt.len_cvt;
-		const unsigned long out_len = (float)length*factor;        
-        buffer = (Uint8*) malloc(out_len);
-
-        resample(buffer, Audio_cvt.buf,
-                out_len, length, audioSpec.format, audioSpec.channels);
-		length = out_len;
+        std::vector<Uint8> resampled;
+        resample(resampled, Audio_cvt.buf, Audio_cvt.len_cvt,
+                 mOggFreq, audioSpec.freq, audioSpec.format, audioSpec.channels);
+        setupWaveForm(resampled);
 	}
 	else
 	{
-		length = Audio_cvt.len_cvt;
-        buffer = (Uint8*) malloc(length);
-        memcpy(buffer, Audio_cvt.buf, length);
+        setupWaveForm(Audio_cvt.buf, Audio_cvt.len_cvt);
 	}
 
-    setupWaveForm(buffer, length);
-
-    free(buffer);
-
 	// Structure Audio_cvt must be freed!
 	free(Audio_cvt.buf);
 
@@ -231,6 +220,8 @@ void CSoundSlot::unload()
 {
     if(!mSounddata.empty())
         mSounddata.clear();
+
+    m_soundlength = 0;
 }
 
 
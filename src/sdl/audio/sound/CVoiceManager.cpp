@@ -0,0 +1,146 @@
+/*
+ * CVoiceManager.cpp
+ *
+ *  Created on: 18.10.2026
+ */
+
+#include "CVoiceManager.h"
+
+#include <algorithm>
+#include <cassert>
+
+const int CVoiceManager::NoVoice;
+
+
+void CVoiceManager::setup(const unsigned int numVoices, const unsigned int numSlots)
+{
+    mVoices.assign(numVoices, Voice());
+    mSlotHead.assign(numSlots, NoVoice);
+    releaseAll();
+}
+
+
+void CVoiceManager::releaseAll()
+{
+    std::fill(mSlotHead.begin(), mSlotHead.end(), NoVoice);
+
+    const int numVoices = int(mVoices.size());
+
+    for(int v = 0 ; v < numVoices ; v++)
+    {
+        Voice &voice = mVoices[v];
+        voice.slot = -1;
+        voice.prev = NoVoice;
+        voice.next = (v+1 < numVoices) ? v+1 : NoVoice;
+        voice.prevOfSlot = voice.nextOfSlot = NoVoice;
+    }
+
+    mFreeHead = (numVoices > 0) ? 0 : NoVoice;
+    mActiveHead = mActiveTail = NoVoice;
+    mNumActive = 0;
+}
+
+
+bool CVoiceManager::linkToSlot(const int voice, const unsigned int slot)
+{
+    if(slot >= mSlotHead.size())
+        return false;
+
+    Voice &v = mVoices[voice];
+    v.slot = int(slot);
+    v.prevOfSlot = NoVoice;
+    v.nextOfSlot = mSlotHead[slot];
+
+    if(v.nextOfSlot != NoVoice)
+        mVoices[v.nextOfSlot].prevOfSlot = voice;
+
+    mSlotHead[slot] = voice;
+    return true;
+}
+
+
+void CVoiceManager::unlinkFromSlot(const int voice)
+{
+    Voice &v = mVoices[voice];
+
+    if(v.prevOfSlot != NoVoice)
+        mVoices[v.prevOfSlot].nextOfSlot = v.nextOfSlot;
+    else
+        mSlotHead[v.slot] = v.nextOfSlot;
+
+    if(v.nextOfSlot != NoVoice)
+        mVoices[v.nextOfSlot].prevOfSlot = v.prevOfSlot;
+
+    v.prevOfSlot = v.nextOfSlot = NoVoice;
+}
+
+
+int CVoiceManager::allocate(const unsigned int slot)
+{
+    const int voice = mFreeHead;
+
+    if(voice == NoVoice || !linkToSlot(voice, slot))
+        return NoVoice;
+
+    Voice &v = mVoices[voice];
+    mFreeHead = v.next;
+
+    // Append to the active ones
+    v.prev = mActiveTail;
+    v.next = NoVoice;
+
+    if(mActiveTail != NoVoice)
+        mVoices[mActiveTail].next = voice;
+    else
+        mActiveHead = voice;
+
+    mActiveTail = voice;
+    mNumActive++;
+
+    return voice;
+}
+
+
+void CVoiceManager::reassign(const int voice, const unsigned int slot)
+{
+    assert(isActive(voice));
+
+    if(mVoices[voice].slot == int(slot))
+        return;
+
+    if(slot >= mSlotHead.size())
+    {
+        release(voice);
+        return;
+    }
+
+    unlinkFromSlot(voice);
+    linkToSlot(voice, slot);
+}
+
+
+void CVoiceManager::release(const int voice)
+{
+    Voice &v = mVoices[voice];
+
+    if(v.slot < 0)
+        return;
+
+    unlinkFromSlot(voice);
+
+    if(v.prev != NoVoice)
+        mVoices[v.prev].next = v.next;
+    else
+        mActiveHead = v.next;
+
+    if(v.next != NoVoice)
+        mVoices[v.next].prev = v.prev;
+    else
+        mActiveTail = v.prev;
+
+    v.slot = -1;
+    v.prev = NoVoice;
+    v.next = mFreeHead;
+    mFreeHead = voice;
+    mNumActive--;
+}
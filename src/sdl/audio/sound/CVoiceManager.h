@@ -0,0 +1,112 @@
+/*
+ * CVoiceManager.h
+ *
+ *  Created on: 18.10.2026
+ *
+ *  Bookkeeping of the sound channels (voices). Idle voices are kept in a
+ *  free list and every sound slot has a list of the voices playing it,
+ *  so starting, stopping and querying a sound never walks over all channels.
+ *  The lists are linked through arrays indexed by voice, nothing is allocated
+ *  after setup().
+ */
+
+#ifndef CVOICEMANAGER_H_
+#define CVOICEMANAGER_H_
+
+#include <vector>
+
+class CVoiceManager
+{
+public:
+
+    static const int NoVoice = -1;
+
+    /**
+     * @brief setup Makes all voices idle
+     * @param numVoices number of channels which can play at the same time
+     * @param numSlots  number of sound slots which can be played
+     */
+    void setup(const unsigned int numVoices, const unsigned int numSlots);
+
+    /**
+     * @brief allocate  Takes an idle voice for playing the given slot
+     * @return the voice or NoVoice if all of them are busy or the slot is not known
+     */
+    int allocate(const unsigned int slot);
+
+    /**
+     * @brief reassign  Lets a busy voice play another slot. If the slot is not known, the voice is released.
+     */
+    void reassign(const int voice, const unsigned int slot);
+
+    /**
+     * @brief release   Makes the voice idle again
+     */
+    void release(const int voice);
+
+    void releaseAll();
+
+    /// First voice playing the slot or NoVoice
+    int firstVoiceOf(const unsigned int slot) const
+    {   return (slot < mSlotHead.size()) ? mSlotHead[slot] : NoVoice;  }
+
+    /// Next voice playing the same slot or NoVoice
+    int nextVoiceOfSlot(const int voice) const
+    {   return mVoices[voice].nextOfSlot;  }
+
+    bool isSlotActive(const unsigned int slot) const
+    {   return firstVoiceOf(slot) != NoVoice;  }
+
+    /// First busy voice or NoVoice. Busy voices are visited in the order they were allocated.
+    int firstActive() const
+    {   return mActiveHead;  }
+
+    int nextActive(const int voice) const
+    {   return mVoices[voice].next;  }
+
+    bool isActive(const int voice) const
+    {   return mVoices[voice].slot >= 0;  }
+
+    int slotOf(const int voice) const
+    {   return mVoices[voice].slot;  }
+
+    unsigned int numActive() const
+    {   return mNumActive;  }
+
+    bool hasFreeVoice() const
+    {   return mFreeHead != NoVoice;  }
+
+    /// Number of slots given to setup(). Other slots can't be played.
+    unsigned int numSlots() const
+    {   return mSlotHead.size();  }
+
+private:
+
+    struct Voice
+    {
+        int slot = -1;          // -1 while idle
+
+        // Free list while idle, list of active voices while busy
+        int prev = NoVoice;
+        int next = NoVoice;
+
+        // Voices playing the same slot
+        int prevOfSlot = NoVoice;
+        int nextOfSlot = NoVoice;
+    };
+
+    // Fails if the slot is out of range. The slot table is never resized,
+    // since this is called from the audio callback.
+    bool linkToSlot(const int voice, const unsigned int slot);
+    void unlinkFromSlot(const int voice);
+
+    std::vector<Voice> mVoices;
+    std::vector<int> mSlotHead;
+
+    int mFreeHead = NoVoice;
+    int mActiveHead = NoVoice;
+    int mActiveTail = NoVoice;
+    unsigned int mNumActive = 0;
+};
+
+#endif /* CVOICEMANAGER_H_ */
@@ -0,0 +1,378 @@
+/*
+ * PlanarBench.cpp
+ *
+ *  Created on: 18.10.2026
+ *
+ *  Converts synthetic EGA bitplanes with the kernels of engine/core/EGAPlanar
+ *  and with the bit by bit CPlanes::getbit() loops they replaced.
+ *  Tells how fast each of them is and checks that both give the same pixels.
+ */
+
+#include "CPlanes.h"
+#include "EGAPlanar.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Colour planes and the mask plane of the masked stages
+const unsigned int NUM_PLANES = 5;
+
+// Vorticon tiles are 16 pixels wide, 12 makes most rows start inside a byte
+const unsigned int TILE_SIZE = 12;
+const unsigned int TILE_COLUMNS = 8;
+
+const uint8_t MASK_INDEX = 16;
+
+void printUsage(const char *program)
+{
+    printf("Usage: %s [options]\n\n", program);
+    printf("Options:\n");
+    printf("  -w <pixels>       width of the synthetic image, a multiple of 8 (default: 320)\n");
+    printf("  -h <pixels>       height of the synthetic image (default: 200)\n");
+    printf("  -n <images>       images converted per pass (default: 64)\n");
+    printf("  -p <passes>       passes per stage, the fastest counts (default: 5)\n");
+    printf("  --seed <number>   seed of the synthetic planes (default: 1)\n");
+}
+
+struct StageResult
+{
+    std::string name;
+    size_t pixels = 0;
+    double bestSeconds = 0.0;
+};
+
+StageResult runStage(const std::string &name, const size_t pixels,
+                     const unsigned int passes, const std::function<void()> &convert)
+{
+    StageResult result;
+    result.name = name;
+    result.pixels = pixels;
+
+    for(unsigned int pass = 0 ; pass < passes ; pass++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        convert();
+        const auto stop = std::chrono::steady_clock::now();
+
+        const double seconds = std::chrono::duration<double>(stop - start).count();
+        if(pass == 0 || seconds < result.bestSeconds)
+            result.bestSeconds = seconds;
+    }
+
+    return result;
+}
+
+void printResult(const StageResult &result)
+{
+    const double perSecond = (result.bestSeconds > 0.0) ? result.pixels/result.bestSeconds : 0.0;
+
+    printf("%-12s %12lu %12.3f %14.1f\n",
+           result.name.c_str(),
+           static_cast<unsigned long>(result.pixels),
+           result.bestSeconds*1000.0,
+           perSecond/1e6);
+}
+
+template <typename T>
+bool sameOutput(const char *what, const std::vector<T> &expected, const std::vector<T> &output)
+{
+    if(expected.size() != output.size() ||
+       memcmp(expected.data(), output.data(), expected.size()*sizeof(T)) != 0)
+    {
+        printf("%s: the kernel differs from the getbit() path!\n", what);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Planes of images in the way the game data has them. Runs of equal bytes like
+ * in real graphics alternate with noise.
+ */
+std::vector<uint8_t> makeSyntheticPlanes(const size_t bytes, unsigned int seed)
+{
+    std::vector<uint8_t> data(bytes);
+    unsigned int state = seed*2654435761u + 1;
+
+    size_t pos = 0;
+    while(pos < bytes)
+    {
+        state = state*1103515245u + 12345u;
+        const unsigned int rnd = state >> 8;
+        const size_t run = 1 + (rnd % 24);
+        const bool solid = ((rnd >> 5) % 2) == 0;
+        const uint8_t value = uint8_t(rnd >> 10);
+
+        for(size_t i = 0 ; i < run && pos < bytes ; i++, pos++)
+        {
+            if(!solid)
+            {
+                state = state*1103515245u + 12345u;
+                data[pos] = uint8_t(state >> 16);
+            }
+            else
+            {
+                data[pos] = value;
+            }
+        }
+    }
+
+    return data;
+}
+
+}
+
+
+int main(int argc, char *argv[])
+{
+    unsigned int width = 320;
+    unsigned int height = 200;
+    unsigned int images = 64;
+    unsigned int passes = 5;
+    unsigned int seed = 1;
+
+    for(int i = 1 ; i < argc ; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = (i+1 < argc);
+
+        if(arg == "--help")
+        {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else if(arg == "-w" && hasValue)
+            width = unsigned(atoi(argv[++i]));
+        else if(arg == "-h" && hasValue)
+            height = unsigned(atoi(argv[++i]));
+        else if(arg == "-n" && hasValue)
+            images = unsigned(atoi(argv[++i]));
+        else if(arg == "-p" && hasValue)
+            passes = unsigned(atoi(argv[++i]));
+        else if(arg == "--seed" && hasValue)
+            seed = unsigned(atoi(argv[++i]));
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(width == 0 || width%8 != 0 || height == 0 || images == 0 || passes == 0)
+    {
+        printf("The width must be a multiple of 8, the other values greater than zero.\n");
+        return 1;
+    }
+
+    const size_t rowBytes = width/8;
+    const size_t planeSize = rowBytes*height;
+    const size_t imageSize = planeSize*NUM_PLANES;
+    const size_t imagePixels = size_t(width)*height;
+    const size_t pixels = imagePixels*images;
+
+    // CPlanes only reads, but takes a non-const pointer
+    std::vector<uint8_t> data = makeSyntheticPlanes(imageSize*images, seed);
+
+    const size_t numTiles = (imagePixels/(TILE_SIZE*TILE_SIZE))/TILE_COLUMNS*TILE_COLUMNS;
+    const size_t tilePixels = numTiles*TILE_SIZE*TILE_SIZE*images;
+
+    uint32_t palette[16];
+    for(unsigned int c = 0 ; c < 16 ; c++)
+        palette[c] = 0xFF000000u | (c*0x0F0F0Fu) | (c << 20);
+
+    printf("Synthetic planes: %u images of %ux%u pixels, %lu tiles of %ux%u per image\n\n",
+           images, width, height, static_cast<unsigned long>(numTiles), TILE_SIZE, TILE_SIZE);
+
+    std::vector<uint8_t> expected(pixels), output(pixels);
+    std::vector<uint32_t> expected32(pixels), output32(pixels);
+    std::vector<uint8_t> expectedTiles(tilePixels), outputTiles(tilePixels);
+    std::vector<StageResult> results;
+    bool same = true;
+
+    auto planesOf = [&](const size_t image, const uint8_t *p[NUM_PLANES])
+    {
+        for(unsigned int plane = 0 ; plane < NUM_PLANES ; plane++)
+            p[plane] = data.data() + image*imageSize + plane*planeSize;
+    };
+
+    auto setOffsetsOf = [&](CPlanes &planes, const size_t image)
+    {
+        const size_t base = image*imageSize;
+        planes.setOffsets(base, base+planeSize, base+2*planeSize,
+                          base+3*planeSize, base+4*planeSize);
+    };
+
+    // The old readPlane, one plane after another
+    results.push_back(runStage("getbit", pixels, passes, [&]
+    {
+        memset(expected.data(), 0, pixels);
+        for(size_t image = 0 ; image < images ; image++)
+        {
+            CPlanes planes(data.data());
+            setOffsetsOf(planes, image);
+            uint8_t *dst = expected.data() + image*imagePixels;
+
+            for(unsigned int p = 0 ; p < 4 ; p++)
+                for(size_t i = 0 ; i < imagePixels ; i++)
+                    dst[i] |= (planes.getbit(p) << p);
+        }
+    }));
+
+    results.push_back(runStage("planes", pixels, passes, [&]
+    {
+        memset(output.data(), 0, pixels);
+        for(size_t image = 0 ; image < images ; image++)
+        {
+            CPlanes planes(data.data());
+            setOffsetsOf(planes, image);
+            planes.readPlanes(output.data() + image*imagePixels, width, height);
+        }
+    }));
+    same &= sameOutput("planes", expected, output);
+
+    results.push_back(runStage("chunky", pixels, passes, [&]
+    {
+        for(size_t image = 0 ; image < images ; image++)
+        {
+            const uint8_t *p[NUM_PLANES];
+            planesOf(image, p);
+
+            for(size_t y = 0 ; y < height ; y++)
+            {
+                const uint8_t * const row[4] = { p[0]+y*rowBytes, p[1]+y*rowBytes,
+                                                 p[2]+y*rowBytes, p[3]+y*rowBytes };
+                planar::toChunky(output.data() + image*imagePixels + y*width, row, rowBytes);
+            }
+        }
+    }));
+    same &= sameOutput("chunky", expected, output);
+
+    // The Galaxy sprites went through getbit() for every plane, then for the mask
+    results.push_back(runStage("masked-ref", pixels, passes, [&]
+    {
+        memset(expected.data(), 0, pixels);
+        for(size_t image = 0 ; image < images ; image++)
+        {
+            CPlanes planes(data.data());
+            setOffsetsOf(planes, image);
+            uint8_t *dst = expected.data() + image*imagePixels;
+
+            for(unsigned int p = 0 ; p < 4 ; p++)
+                for(size_t i = 0 ; i < imagePixels ; i++)
+                    dst[i] |= (planes.getbit(p) << p);
+
+            for(size_t i = 0 ; i < imagePixels ; i++)
+                if(planes.getbit(4))
+                    dst[i] = MASK_INDEX;
+        }
+    }));
+
+    results.push_back(runStage("masked", pixels, passes, [&]
+    {
+        for(size_t image = 0 ; image < images ; image++)
+        {
+            const uint8_t *p[NUM_PLANES];
+            planesOf(image, p);
+
+            for(size_t y = 0 ; y < height ; y++)
+            {
+                const uint8_t * const row[4] = { p[0]+y*rowBytes, p[1]+y*rowBytes,
+                                                 p[2]+y*rowBytes, p[3]+y*rowBytes };
+                planar::toChunkyMasked(output.data() + image*imagePixels + y*width, row,
+                                       p[4]+y*rowBytes, rowBytes, MASK_INDEX);
+            }
+        }
+    }));
+    same &= sameOutput("masked", expected, output);
+
+    // RefKeen looked up every pixel of the EGA memory in the palette
+    results.push_back(runStage("pal-ref", pixels, passes, [&]
+    {
+        for(size_t image = 0 ; image < images ; image++)
+        {
+            CPlanes planes(data.data());
+            setOffsetsOf(planes, image);
+            uint32_t *dst = expected32.data() + image*imagePixels;
+
+            // Every plane has its own position, so the pixels can go one by one
+            for(size_t i = 0 ; i < imagePixels ; i++)
+            {
+                uint8_t colour = 0;
+                for(unsigned int p = 0 ; p < 4 ; p++)
+                    colour |= (planes.getbit(p) << p);
+                dst[i] = palette[colour];
+            }
+        }
+    }));
+
+    results.push_back(runStage("pal", pixels, passes, [&]
+    {
+        for(size_t image = 0 ; image < images ; image++)
+        {
+            const uint8_t *p[NUM_PLANES];
+            planesOf(image, p);
+
+            for(size_t y = 0 ; y < height ; y++)
+            {
+                const uint8_t * const row[4] = { p[0]+y*rowBytes, p[1]+y*rowBytes,
+                                                 p[2]+y*rowBytes, p[3]+y*rowBytes };
+                planar::toPalettised(output32.data() + image*imagePixels + y*width,
+                                     row, rowBytes, palette);
+            }
+        }
+    }));
+    same &= sameOutput("pal", expected32, output32);
+
+    // The old readPlaneofTiles, for tile rows which do not start at a byte
+    results.push_back(runStage("tiles-ref", tilePixels, passes, [&]
+    {
+        memset(expectedTiles.data(), 0, tilePixels);
+        for(size_t image = 0 ; image < images ; image++)
+        {
+            CPlanes planes(data.data());
+            setOffsetsOf(planes, image);
+            uint8_t *dst = expectedTiles.data() + image*numTiles*TILE_SIZE*TILE_SIZE;
+
+            for(unsigned int p = 0 ; p < 4 ; p++)
+                for(size_t t = 0 ; t < numTiles ; t++)
+                    for(size_t y = 0 ; y < TILE_SIZE ; y++)
+                        for(size_t x = 0 ; x < TILE_SIZE ; x++)
+                        {
+                            uint8_t *pixel = dst +
+                                             TILE_SIZE*TILE_SIZE*TILE_COLUMNS*(t/TILE_COLUMNS) +
+                                             TILE_SIZE*(t%TILE_COLUMNS) +
+                                             TILE_SIZE*TILE_COLUMNS*y + x;
+                            *pixel |= (planes.getbit(p) << p);
+                        }
+        }
+    }));
+
+    results.push_back(runStage("tiles", tilePixels, passes, [&]
+    {
+        memset(outputTiles.data(), 0, tilePixels);
+        for(size_t image = 0 ; image < images ; image++)
+        {
+            CPlanes planes(data.data());
+            setOffsetsOf(planes, image);
+            planes.readPlanesofTiles(outputTiles.data() + image*numTiles*TILE_SIZE*TILE_SIZE,
+                                     TILE_COLUMNS, TILE_SIZE, uint16_t(numTiles));
+        }
+    }));
+    same &= sameOutput("tiles", expectedTiles, outputTiles);
+
+    printf("%-12s %12s %12s %14s\n", "stage", "pixels", "best ms", "Mpixels/s");
+    for(const auto &result : results)
+        printResult(result);
+
+    printf("\n%s\n", same ? "The outputs are the same." : "The outputs differ!");
+    return same ? 0 : 1;
+}
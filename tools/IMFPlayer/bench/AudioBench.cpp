@@ -0,0 +1,254 @@
+/*
+ * AudioBench.cpp
+ *
+ *  Created on: 18.10.2026
+ *
+ *  Renders music and sound effects through the audio code of Commander Genius
+ *  as fast as possible and tells how many samples per second every stage manages.
+ *  No sound device is opened, the result goes into a wave file.
+ */
+
+#include "BenchStages.h"
+#include "SynthStreams.h"
+#include "WaveFile.h"
+#include "sdl/audio/base/COPLEmulator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace
+{
+
+void printUsage(const char *program)
+{
+    printf("Usage: %s [options] [input]\n\n", program);
+    printf("input is an .imf song, an .isf effect or an .ogg file.\n");
+    printf("Without it a synthetic song and synthetic effects are rendered.\n\n");
+    printf("Options:\n");
+    printf("  -o <file.wav>     write the mixed output (default: audiobench.wav)\n");
+    printf("  -r <rate>         output rate in Hz (default: 44100)\n");
+    printf("  -l <seconds>      length of the music (default: 60)\n");
+    printf("  -v <voices>       effects mixed on top of the music (default: 8)\n");
+    printf("  -p <passes>       passes per stage, the fastest counts (default: 5)\n");
+    printf("  --opl-rate <rate> rate of the emulated chip in Hz (default: 49716)\n");
+    printf("  --imf-rate <rate> clock rate of the IMF song in Hz (default: 560)\n");
+    printf("  --reference       run the emulator sample by sample like the original\n\n");
+    printf("Example:\n");
+    printf("  %s -r 48000 -l 120 K4T01.imf\n", program);
+}
+
+std::string extensionOf(const std::string &filename)
+{
+    const size_t dot = filename.rfind('.');
+    if(dot == std::string::npos)
+        return "";
+
+    std::string ext = filename.substr(dot+1);
+    for(auto &c : ext)
+        c = char(tolower(c));
+    return ext;
+}
+
+bool readFile(const std::string &filename, std::vector<byte> &data)
+{
+    FILE *fp = fopen(filename.c_str(), "rb");
+    if(!fp)
+        return false;
+
+    fseek(fp, 0, SEEK_END);
+    const long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    data.resize(size > 0 ? size_t(size) : 0);
+    const bool ok = (fread(data.data(), 1, data.size(), fp) == data.size());
+    fclose(fp);
+    return ok && !data.empty();
+}
+
+// Same as CIMFPlayer::loadMusicFromFile(). Type-0 files have no length at their start.
+bool readIMF(const std::string &filename, std::vector<IMFChunkType> &song)
+{
+    std::vector<byte> data;
+    if(!readFile(filename, data) || data.size() < sizeof(word))
+        return false;
+
+    word dataSize;
+    memcpy(&dataSize, data.data(), sizeof(word));
+
+    size_t offset = sizeof(word);
+    size_t size = dataSize;
+
+    if(dataSize == 0)
+    {
+        offset = 0;
+        size = data.size();
+    }
+
+    size = std::min(size, data.size()-offset);
+    song.resize(size/sizeof(IMFChunkType));
+    memcpy(song.data(), data.data()+offset, song.size()*sizeof(IMFChunkType));
+    return !song.empty();
+}
+
+void printResult(const StageResult &result, const int rate)
+{
+    if(!result.ran)
+    {
+        printf("%-10s %14s\n", result.name.c_str(), "skipped");
+        return;
+    }
+
+    const double perSecond = (result.bestSeconds > 0.0) ? result.frames/result.bestSeconds : 0.0;
+
+    printf("%-10s %14lu %12.3f %16.0f %12.1f\n",
+           result.name.c_str(),
+           static_cast<unsigned long>(result.frames),
+           result.bestSeconds*1000.0,
+           perSecond,
+           perSecond/rate);
+}
+
+}
+
+
+int main(int argc, char *argv[])
+{
+    BenchSettings settings;
+    std::string input;
+    std::string output = "audiobench.wav";
+    bool reference = false;
+
+    for(int i = 1 ; i < argc ; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = (i+1 < argc);
+
+        if(arg == "-h" || arg == "--help")
+        {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else if(arg == "-o" && hasValue)
+            output = argv[++i];
+        else if(arg == "-r" && hasValue)
+            settings.outRate = atoi(argv[++i]);
+        else if(arg == "-l" && hasValue)
+            settings.seconds = atof(argv[++i]);
+        else if(arg == "-v" && hasValue)
+            settings.voices = unsigned(atoi(argv[++i]));
+        else if(arg == "-p" && hasValue)
+            settings.passes = unsigned(atoi(argv[++i]));
+        else if(arg == "--opl-rate" && hasValue)
+            settings.oplRate = atoi(argv[++i]);
+        else if(arg == "--imf-rate" && hasValue)
+            settings.imfRate = unsigned(atoi(argv[++i]));
+        else if(arg == "--reference")
+            reference = true;
+        else if(arg[0] != '-' && input.empty())
+            input = arg;
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(settings.outRate <= 0 || settings.oplRate <= 0 ||
+       settings.imfRate == 0 || settings.seconds <= 0.0)
+    {
+        printf("The rates and the length must be greater than zero.\n");
+        return 1;
+    }
+
+    COPLEmulator::setReferenceMode(reference);
+
+    std::vector<IMFChunkType> song;
+    std::vector< std::vector<byte> > effects;
+    std::string oggFile;
+
+    const std::string ext = extensionOf(input);
+
+    if(input.empty())
+    {
+        song = makeSyntheticSong(unsigned(settings.seconds*settings.imfRate));
+        effects = makeSyntheticEffects(16);
+    }
+    else if(ext == "ogg")
+    {
+        oggFile = input;
+        effects = makeSyntheticEffects(16);
+    }
+    else if(ext == "isf")
+    {
+        std::vector<byte> isf;
+        if(!readFile(input, isf))
+        {
+            printf("%s could not be read.\n", input.c_str());
+            return 1;
+        }
+
+        // An effect alone has no music under it
+        effects.push_back(isf);
+        song = makeSyntheticSong(unsigned(settings.seconds*settings.imfRate));
+    }
+    else
+    {
+        if(!readIMF(input, song))
+        {
+            printf("%s could not be read as IMF song.\n", input.c_str());
+            return 1;
+        }
+
+        effects = makeSyntheticEffects(16);
+    }
+
+    printf("Input: %s\n", input.empty() ? "synthetic" : input.c_str());
+    printf("Output: %d Hz, %u channels, S16, OPL at %d Hz, IMF at %u Hz%s\n",
+           settings.outRate, unsigned(settings.channels), settings.oplRate, settings.imfRate,
+           reference ? ", reference emulator" : "");
+    printf("%.1f seconds of music, %u voices, best of %u passes\n\n",
+           settings.seconds, settings.voices, settings.passes);
+
+    printf("%-10s %14s %12s %16s %12s\n", "stage", "frames", "best ms", "frames/s", "x realtime");
+
+    std::vector<Uint8> source;
+    int sourceRate = settings.oplRate;
+
+    if(!oggFile.empty())
+    {
+        const StageResult ogg = benchOGG(oggFile, settings, source, sourceRate);
+        printResult(ogg, sourceRate);
+
+        if(!ogg.ran)
+        {
+            printf("\n%s could not be decoded. Was the benchmark built with OGG?\n", oggFile.c_str());
+            return 1;
+        }
+    }
+    else
+    {
+        printResult(benchOPL(song, settings, source), settings.oplRate);
+    }
+
+    std::vector<Uint8> music;
+    printResult(benchResample(source, sourceRate, settings, music), settings.outRate);
+
+    std::vector< std::vector<Uint8> > waveforms;
+    printResult(benchISF(effects, settings, waveforms), settings.outRate);
+
+    std::vector<Uint8> mixed;
+    printResult(benchMix(music, waveforms, settings, mixed), settings.outRate);
+
+    if(!writeWaveFile(output, mixed, makeSpec(settings.outRate, settings)))
+    {
+        printf("\n%s could not be written.\n", output.c_str());
+        return 1;
+    }
+
+    printf("\nWrote %s\n", output.c_str());
+    return 0;
+}
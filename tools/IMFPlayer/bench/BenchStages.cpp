@@ -0,0 +1,292 @@
+/*
+ * BenchStages.cpp
+ *
+ *  Created on: 18.10.2026
+ */
+
+#include "BenchStages.h"
+#include "sdl/audio/base/COPLEmulator.h"
+#include "sdl/audio/base/Sampling.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(OGG)
+#include <vorbis/vorbisfile.h>
+#endif
+
+// Lives in Mixer.cpp of the engine
+void mixAudioSigned16(Uint8 *dst, const Uint8 *src, Uint32 len, Uint32 volume);
+
+namespace
+{
+
+template <typename Pass>
+double bestOf(const unsigned int passes, Pass pass)
+{
+    double best = 0.0;
+
+    for(unsigned int p = 0 ; p < std::max(passes, 1u) ; p++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        pass();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if(p == 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+
+    return best;
+}
+
+size_t frameSize(const BenchSettings &settings)
+{
+    return settings.channels*sizeof(Sint16);
+}
+
+}
+
+
+SDL_AudioSpec makeSpec(const int rate, const BenchSettings &settings)
+{
+    SDL_AudioSpec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.freq = rate;
+    spec.format = AUDIO_S16;
+    spec.channels = settings.channels;
+    spec.silence = 0;
+    spec.samples = Uint16(settings.deviceFrames);
+    return spec;
+}
+
+
+StageResult benchOPL(const std::vector<IMFChunkType> &song, const BenchSettings &settings,
+                     std::vector<Uint8> &music)
+{
+    StageResult result;
+    result.name = "opl";
+
+    if(song.empty())
+        return result;
+
+    const SDL_AudioSpec spec = makeSpec(settings.oplRate, settings);
+    const size_t frames = size_t(settings.seconds*settings.oplRate);
+
+    // The music thread of the engine renders one callback of the device per chunk
+    const size_t chunkFrames = spec.samples;
+
+    COPLEmulator opl;
+    opl.setIMFClockrate(settings.imfRate);
+    opl.init(settings.oplRate);
+
+    IMFSequencer sequencer;
+    sequencer.song() = song;
+
+    music.assign(frames*frameSize(settings), 0);
+
+    result.bestSeconds = bestOf(settings.passes, [&]()
+    {
+        opl.setup(settings.oplRate);
+        sequencer.rewind(settings.oplRate, opl.getIMFClockRate());
+
+        for(size_t done = 0 ; done < frames ; done += chunkFrames)
+        {
+            const size_t len = std::min(chunkFrames, frames-done);
+            sequencer.render(opl, &music[done*frameSize(settings)], Uint32(len), spec);
+        }
+    });
+
+    result.frames = frames;
+    result.ran = true;
+    return result;
+}
+
+
+StageResult benchResample(const std::vector<Uint8> &input, const int inRate,
+                          const BenchSettings &settings, std::vector<Uint8> &output)
+{
+    StageResult result;
+    result.name = "resample";
+
+    if(input.empty() || inRate == settings.outRate)
+    {
+        output = input;
+        return result;
+    }
+
+    Resampler resampler;
+    if(!resampler.setup(inRate, settings.outRate, AUDIO_S16, settings.channels))
+        return result;
+
+    const size_t chunkLen = settings.deviceFrames*frameSize(settings);
+
+    result.bestSeconds = bestOf(settings.passes, [&]()
+    {
+        resampler.reset();
+        output.clear();
+        output.reserve(resampler.maxOutputLen(input.size()));
+
+        for(size_t pos = 0 ; pos < input.size() ; pos += chunkLen)
+        {
+            const size_t len = std::min(chunkLen, input.size()-pos);
+            resampler.process(&input[pos], len, output);
+        }
+
+        resampler.flush(output);
+    });
+
+    result.frames = output.size()/frameSize(settings);
+    result.ran = true;
+    return result;
+}
+
+
+StageResult benchISF(const std::vector< std::vector<byte> > &effects, const BenchSettings &settings,
+                     std::vector< std::vector<Uint8> > &waveforms)
+{
+    StageResult result;
+    result.name = "isf";
+
+    if(effects.empty())
+        return result;
+
+    const SDL_AudioSpec spec = makeSpec(settings.outRate, settings);
+
+    COPLEmulator opl;
+    opl.setIMFClockrate(settings.imfRate);
+    opl.init(settings.outRate);
+
+    result.bestSeconds = bestOf(settings.passes, [&]()
+    {
+        waveforms.assign(effects.size(), std::vector<Uint8>());
+
+        for(size_t e = 0 ; e < effects.size() ; e++)
+            opl.renderISF(effects[e].data(), spec, waveforms[e]);
+    });
+
+    for(const auto &waveform : waveforms)
+        result.frames += waveform.size()/frameSize(settings);
+
+    result.ran = true;
+    return result;
+}
+
+
+StageResult benchOGG(const std::string &filename, const BenchSettings &settings,
+                     std::vector<Uint8> &pcm, int &rate)
+{
+    StageResult result;
+    result.name = "ogg";
+
+#if defined(OGG)
+    OggVorbis_File oggStream;
+    if(ov_fopen(filename.c_str(), &oggStream) != 0)
+        return result;
+
+    vorbis_info *info = ov_info(&oggStream, -1);
+    rate = int(info->rate);
+    const int channels = info->channels;
+    const int bigEndian = (SDL_BYTEORDER == SDL_BIG_ENDIAN) ? 1 : 0;
+
+    std::vector<Uint8> decoded;
+
+    result.bestSeconds = bestOf(settings.passes, [&]()
+    {
+        ov_pcm_seek(&oggStream, 0);
+        decoded.clear();
+
+        char buffer[4096];
+        int bitStream = 0;
+        long bytes;
+
+        while( (bytes = ov_read(&oggStream, buffer, sizeof(buffer), bigEndian, 2, 1, &bitStream)) > 0 )
+            decoded.insert(decoded.end(), buffer, buffer+bytes);
+    });
+
+    ov_clear(&oggStream);
+
+    // Bring it to the channels of the device. Mono is doubled, more than stereo is cut.
+    const size_t inFrames = decoded.size()/(channels*sizeof(Sint16));
+    const Sint16 *in = reinterpret_cast<const Sint16*>(static_cast<const void*>(decoded.data()));
+
+    pcm.resize(inFrames*frameSize(settings));
+    Sint16 *out = reinterpret_cast<Sint16*>(static_cast<void*>(pcm.data()));
+
+    for(size_t f = 0 ; f < inFrames ; f++)
+    {
+        for(int ch = 0 ; ch < settings.channels ; ch++)
+            out[f*settings.channels + ch] = in[f*channels + std::min(ch, channels-1)];
+    }
+
+    result.frames = inFrames;
+    result.ran = true;
+#else
+    (void) filename;
+    (void) settings;
+    (void) pcm;
+    (void) rate;
+#endif
+
+    return result;
+}
+
+
+StageResult benchMix(const std::vector<Uint8> &music, const std::vector< std::vector<Uint8> > &effects,
+                     const BenchSettings &settings, std::vector<Uint8> &output)
+{
+    StageResult result;
+    result.name = "mix";
+
+    const size_t chunkLen = settings.deviceFrames*frameSize(settings);
+    const size_t len = music.size() - (music.size() % frameSize(settings));
+
+    if(len == 0)
+        return result;
+
+    output.assign(len, 0);
+
+    // Every voice plays its effect over and over, each one starting somewhere else
+    std::vector<size_t> voicePos(settings.voices, 0);
+
+    result.bestSeconds = bestOf(settings.passes, [&]()
+    {
+        for(size_t v = 0 ; v < voicePos.size() ; v++)
+            voicePos[v] = v*frameSize(settings)*331;
+
+        for(size_t pos = 0 ; pos < len ; pos += chunkLen)
+        {
+            const Uint32 chunk = Uint32(std::min(chunkLen, len-pos));
+            Uint8 *dst = &output[pos];
+
+            memset(dst, 0, chunk);
+            mixAudioSigned16(dst, &music[pos], chunk, SDL_MIX_MAXVOLUME);
+
+            if(effects.empty())
+                continue;
+
+            for(size_t v = 0 ; v < voicePos.size() ; v++)
+            {
+                const std::vector<Uint8> &effect = effects[v % effects.size()];
+                if(effect.empty())
+                    continue;
+
+                // Wrap the effect around, so it fills the whole chunk
+                for(Uint32 done = 0 ; done < chunk ; )
+                {
+                    size_t &effectPos = voicePos[v];
+                    effectPos %= effect.size();
+                    const Uint32 part = Uint32(std::min<size_t>(chunk-done, effect.size()-effectPos));
+
+                    mixAudioSigned16(dst+done, &effect[effectPos], part, SDL_MIX_MAXVOLUME/4);
+                    done += part;
+                    effectPos += part;
+                }
+            }
+        }
+    });
+
+    result.frames = len/frameSize(settings);
+    result.ran = true;
+    return result;
+}
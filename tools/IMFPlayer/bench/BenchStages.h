@@ -0,0 +1,62 @@
+/*
+ * BenchStages.h
+ *
+ *  Created on: 18.10.2026
+ *
+ *  The stages of the audio path of the engine, each one measured alone.
+ *  Every stage is run several times and the fastest pass counts,
+ *  so other processes on the machine disturb the result as little as possible.
+ */
+
+#ifndef BENCHSTAGES_H_
+#define BENCHSTAGES_H_
+
+#include "sdl/audio/music/IMFSequencer.h"
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+struct BenchSettings
+{
+    int outRate = 44100;        // Rate of the audio device
+    int oplRate = 49716;        // Rate the chip is emulated at
+    unsigned int imfRate = 560;
+    Uint8 channels = 2;
+    double seconds = 60.0;      // Length of the music to render
+    unsigned int voices = 8;    // Effects mixed on top of the music
+    unsigned int passes = 5;
+    unsigned int deviceFrames = 512;    // Size of one callback
+};
+
+struct StageResult
+{
+    std::string name;
+    size_t frames = 0;          // Output frames of one pass
+    double bestSeconds = 0.0;   // Time of the fastest pass
+    bool ran = false;
+};
+
+/// S16 format at the given rate, as the engine uses it
+SDL_AudioSpec makeSpec(const int rate, const BenchSettings &settings);
+
+/// Plays the song on the emulated chip at the OPL rate
+StageResult benchOPL(const std::vector<IMFChunkType> &song, const BenchSettings &settings,
+                     std::vector<Uint8> &music);
+
+/// Converts a waveform to the output rate in device sized chunks
+StageResult benchResample(const std::vector<Uint8> &input, const int inRate,
+                          const BenchSettings &settings, std::vector<Uint8> &output);
+
+/// Renders every AdLib effect into a waveform at the output rate
+StageResult benchISF(const std::vector< std::vector<byte> > &effects, const BenchSettings &settings,
+                     std::vector< std::vector<Uint8> > &waveforms);
+
+/// Decodes an Ogg/Vorbis file. Only available if built with OGG.
+StageResult benchOGG(const std::string &filename, const BenchSettings &settings,
+                     std::vector<Uint8> &pcm, int &rate);
+
+/// Mixes the music and the effects chunk by chunk like the audio callback does
+StageResult benchMix(const std::vector<Uint8> &music, const std::vector< std::vector<Uint8> > &effects,
+                     const BenchSettings &settings, std::vector<Uint8> &output);
+
+#endif /* BENCHSTAGES_H_ */
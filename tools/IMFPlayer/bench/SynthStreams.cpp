@@ -0,0 +1,163 @@
+/*
+ * SynthStreams.cpp
+ *
+ *  Created on: 18.10.2026
+ */
+
+#include "SynthStreams.h"
+
+#include <cstring>
+
+namespace
+{
+
+// F-numbers of the notes C to B in one octave at 49716 Hz
+const word noteFNum[12] =
+{ 0x157, 0x16B, 0x181, 0x198, 0x1B0, 0x1CA, 0x1E5, 0x202, 0x220, 0x241, 0x263, 0x287 };
+
+// The first operator of every melodic channel. The second one is three cells further.
+const byte channelOperator[9] = { 0, 1, 2, 8, 9, 10, 16, 17, 18 };
+
+// Same numbers on every machine, unlike rand()
+class LCG
+{
+public:
+    explicit LCG(const unsigned int seed) : mState(seed) {}
+
+    unsigned int next(const unsigned int range)
+    {
+        mState = mState*1664525u + 1013904223u;
+        return (mState >> 16) % range;
+    }
+
+private:
+    unsigned int mState;
+};
+
+
+void write(std::vector<IMFChunkType> &song, const byte reg, const byte val, const word delay = 0)
+{
+    IMFChunkType chunk;
+    chunk.al_reg = reg;
+    chunk.al_dat = val;
+    chunk.Delay = delay;
+    song.push_back(chunk);
+}
+
+}
+
+
+std::vector<IMFChunkType> makeSyntheticSong(const unsigned int ticks, const unsigned int seed)
+{
+    std::vector<IMFChunkType> song;
+    LCG lcg(seed);
+
+    // Allow other waveforms than the sine
+    write(song, 0x01, 0x20);
+
+    for(unsigned int ch = 0 ; ch < 9 ; ch++)
+    {
+        const byte m = channelOperator[ch];
+        const byte c = m + 3;
+
+        write(song, alChar+m, byte(0x21 + lcg.next(2)));
+        write(song, alScale+m, byte(0x10 + lcg.next(0x18)));
+        write(song, alAttack+m, byte(0xF0 | (lcg.next(8)+2)));
+        write(song, alSus+m, byte(0x40 | lcg.next(16)));
+        write(song, alWave+m, byte(lcg.next(4)));
+
+        write(song, alChar+c, 0x21);
+        write(song, alScale+c, 0x00);
+        write(song, alAttack+c, byte(0xF0 | (lcg.next(6)+1)));
+        write(song, alSus+c, byte(0x20 | lcg.next(16)));
+        write(song, alWave+c, byte(lcg.next(2)));
+
+        write(song, byte(alFeedCon+ch), byte((lcg.next(8) << 1)));
+    }
+
+    // Eighth notes at 120 bpm with 560 Hz are 140 ticks, sixteenth are 70
+    const word step = 70;
+    byte keyOn[9] = { 0 };
+
+    for(unsigned int t = 0 ; t < ticks ; t += step)
+    {
+        for(unsigned int ch = 0 ; ch < 9 ; ch++)
+        {
+            // The bass channels play more often, so there is always something going on
+            if(lcg.next(9) > 2 + ch/2)
+                continue;
+
+            const word fnum = noteFNum[lcg.next(12)];
+            const byte block = byte(2 + lcg.next(4));
+
+            write(song, byte(alFreqH+ch), byte(keyOn[ch] & ~0x20));
+            write(song, byte(alFreqL+ch), byte(fnum & 0xFF));
+            keyOn[ch] = byte(0x20 | (block << 2) | (fnum >> 8));
+            write(song, byte(alFreqH+ch), keyOn[ch]);
+        }
+
+        write(song, 0, 0, step);
+    }
+
+    // Silence everything before the song starts over
+    for(unsigned int ch = 0 ; ch < 9 ; ch++)
+        write(song, byte(alFreqH+ch), byte(keyOn[ch] & ~0x20));
+
+    write(song, 0, 0, step);
+
+    return song;
+}
+
+
+std::vector< std::vector<byte> > makeSyntheticEffects(const unsigned int count)
+{
+    std::vector< std::vector<byte> > effects;
+    LCG lcg(count);
+
+    for(unsigned int e = 0 ; e < count ; e++)
+    {
+        AdLibSound sound;
+        memset(&sound, 0, sizeof(sound));
+
+        sound.inst.mChar = byte(0x20 | lcg.next(16));
+        sound.inst.cChar = byte(0x20 | lcg.next(16));
+        sound.inst.mScale = byte(lcg.next(0x30));
+        sound.inst.mAttack = byte(0xF0 | lcg.next(16));
+        sound.inst.cAttack = byte(0xF0 | lcg.next(16));
+        sound.inst.mSus = byte(0x10 | lcg.next(0xF0));
+        sound.inst.cSus = byte(0x10 | lcg.next(0xF0));
+        sound.inst.mWave = byte(lcg.next(4));
+        sound.inst.cWave = byte(lcg.next(4));
+        sound.block = byte(2 + lcg.next(4));
+
+        // Effects are short frequency sweeps, one byte per tick of 140 Hz
+        const longword length = 20 + lcg.next(120);
+        const word priority = word(lcg.next(100));
+
+        std::vector<byte> isf(sizeof(longword) + sizeof(word) + sizeof(AdLibSound) + length);
+        byte *ptr = isf.data();
+
+        memcpy(ptr, &length, sizeof(longword));
+        ptr += sizeof(longword);
+        memcpy(ptr, &priority, sizeof(word));
+        ptr += sizeof(word);
+        memcpy(ptr, &sound, sizeof(AdLibSound));
+        ptr += sizeof(AdLibSound);
+
+        int freq = int(0x40 + lcg.next(0x80));
+        const int slope = int(lcg.next(9)) - 4;
+
+        for(longword i = 0 ; i < length ; i++)
+        {
+            // Some gaps like in the original effects
+            ptr[i] = (lcg.next(16) == 0) ? 0 : byte(freq & 0xFF);
+            freq += slope;
+            if(freq < 1 || freq > 0xFF)
+                freq = 0x80;
+        }
+
+        effects.push_back(isf);
+    }
+
+    return effects;
+}
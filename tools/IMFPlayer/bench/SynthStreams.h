@@ -0,0 +1,29 @@
+/*
+ * SynthStreams.h
+ *
+ *  Created on: 18.10.2026
+ *
+ *  Register streams which are generated instead of read from game data,
+ *  so the benchmark runs anywhere and always renders the same.
+ */
+
+#ifndef SYNTHSTREAMS_H_
+#define SYNTHSTREAMS_H_
+
+#include "sdl/audio/music/IMFSequencer.h"
+#include <vector>
+
+/**
+ * \brief Makes an IMF song which keeps all nine melodic channels of the chip busy
+ * \param ticks     length of the song in IMF ticks. It loops after that.
+ * \param seed      different seeds give different, but always the same notes
+ */
+std::vector<IMFChunkType> makeSyntheticSong(const unsigned int ticks, const unsigned int seed = 1);
+
+/**
+ * \brief Makes AdLib effects in the ISF format of the Keen Galaxy games
+ * \param count     number of effects. They differ in their instrument and length.
+ */
+std::vector< std::vector<byte> > makeSyntheticEffects(const unsigned int count);
+
+#endif /* SYNTHSTREAMS_H_ */
@@ -0,0 +1,80 @@
+/*
+ * WaveFile.cpp
+ *
+ *  Created on: 18.10.2026
+ */
+
+#include "WaveFile.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+
+// Wave files are always little endian, no matter what the machine is
+void putLE(std::vector<Uint8> &header, const Uint32 value, const size_t bytes)
+{
+    for(size_t i = 0 ; i < bytes ; i++)
+        header.push_back(Uint8(value >> (8*i)));
+}
+
+void putTag(std::vector<Uint8> &header, const char *tag)
+{
+    header.insert(header.end(), tag, tag+4);
+}
+
+}
+
+
+bool writeWaveFile(const std::string &filename, const std::vector<Uint8> &data,
+                   const SDL_AudioSpec &spec)
+{
+    const Uint32 bytesPerSample = (spec.format == AUDIO_S16) ? 2 : 1;
+    const Uint32 blockAlign = bytesPerSample*spec.channels;
+    const Uint32 dataSize = Uint32(data.size());
+
+    std::vector<Uint8> header;
+    putTag(header, "RIFF");
+    putLE(header, 36 + dataSize, 4);
+    putTag(header, "WAVE");
+
+    putTag(header, "fmt ");
+    putLE(header, 16, 4);
+    putLE(header, 1, 2);    // PCM
+    putLE(header, spec.channels, 2);
+    putLE(header, Uint32(spec.freq), 4);
+    putLE(header, Uint32(spec.freq)*blockAlign, 4);
+    putLE(header, blockAlign, 2);
+    putLE(header, 8*bytesPerSample, 2);
+
+    putTag(header, "data");
+    putLE(header, dataSize, 4);
+
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if(!fp)
+        return false;
+
+    bool ok = (fwrite(header.data(), 1, header.size(), fp) == header.size());
+
+    // The samples of the engine are in the byte order of the machine
+    if(bytesPerSample == 2)
+    {
+        std::vector<Uint8> le(data.size());
+        for(size_t i = 0 ; i+1 < data.size() ; i += 2)
+        {
+            Sint16 value;
+            memcpy(&value, &data[i], sizeof(value));
+            le[i] = Uint8(Uint16(value) & 0xFF);
+            le[i+1] = Uint8(Uint16(value) >> 8);
+        }
+        ok = ok && (fwrite(le.data(), 1, le.size(), fp) == le.size());
+    }
+    else
+    {
+        ok = ok && (fwrite(data.data(), 1, data.size(), fp) == data.size());
+    }
+
+    fclose(fp);
+    return ok;
+}
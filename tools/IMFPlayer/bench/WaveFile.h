@@ -0,0 +1,24 @@
+/*
+ * WaveFile.h
+ *
+ *  Created on: 18.10.2026
+ */
+
+#ifndef WAVEFILE_H_
+#define WAVEFILE_H_
+
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Writes a waveform as PCM wave file
+ * \param filename  name of the file to write
+ * \param data      interleaved samples in the format of spec
+ * \param spec      only the rate, the format and the channels are used
+ * \return true if the file was written
+ */
+bool writeWaveFile(const std::string &filename, const std::vector<Uint8> &data,
+                   const SDL_AudioSpec &spec);
+
+#endif /* WAVEFILE_H_ */
@@ -0,0 +1,211 @@
+/*
+ * DecodeBench.cpp
+ *
+ *  Created on: 18.10.2026
+ *
+ *  Decodes synthetic Keen Dreams style data with the Huffman and LZHUF decoders
+ *  of the RefKeen engine and with copies of the original bit by bit decoders.
+ *  Tells how fast each of them is and checks that both give the same bytes.
+ */
+
+#include "ReferenceDecoders.h"
+#include "SynthData.h"
+
+extern "C"
+{
+#include "id_heads.h"
+#include "lzhuff.h"
+#include "jam_io.h"
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+static_assert(sizeof(huffnode) == sizeof(RefHuffNode), "huffnode and RefHuffNode must have the same layout");
+
+// lzhuf.cpp reads and writes through these. The benchmark only has data in memory.
+extern "C" id0_int_t ReadPtr(void **infile, id0_unsigned_t PtrType)
+{
+    (void)PtrType;
+    id0_byte_t **ptrptr = (id0_byte_t **)infile;
+    return *((*ptrptr)++);
+}
+
+extern "C" id0_char_t WritePtr(void **outfile, id0_unsigned_char_t data, id0_unsigned_t PtrType)
+{
+    (void)PtrType;
+    id0_byte_t **ptrptr = (id0_byte_t **)outfile;
+    *((*ptrptr)++) = data;
+    return 0;
+}
+
+namespace
+{
+
+// The LZHUF decoder may write up to a whole match more than asked for
+const size_t DEST_SLACK = 64;
+
+void printUsage(const char *program)
+{
+    printf("Usage: %s [options]\n\n", program);
+    printf("Options:\n");
+    printf("  -s <kbytes>       size of the synthetic data (default: 1024)\n");
+    printf("  -p <passes>       passes per stage, the fastest counts (default: 5)\n");
+    printf("  --seed <number>   seed of the synthetic data (default: 1)\n");
+}
+
+struct StageResult
+{
+    std::string name;
+    size_t bytes = 0;
+    double bestSeconds = 0.0;
+};
+
+StageResult runStage(const std::string &name, const size_t bytes,
+                     const unsigned int passes, const std::function<void()> &decode)
+{
+    StageResult result;
+    result.name = name;
+    result.bytes = bytes;
+
+    for(unsigned int pass = 0 ; pass < passes ; pass++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        decode();
+        const auto stop = std::chrono::steady_clock::now();
+
+        const double seconds = std::chrono::duration<double>(stop - start).count();
+        if(pass == 0 || seconds < result.bestSeconds)
+            result.bestSeconds = seconds;
+    }
+
+    return result;
+}
+
+void printResult(const StageResult &result)
+{
+    const double perSecond = (result.bestSeconds > 0.0) ? result.bytes/result.bestSeconds : 0.0;
+
+    printf("%-10s %12lu %12.3f %12.1f\n",
+           result.name.c_str(),
+           static_cast<unsigned long>(result.bytes),
+           result.bestSeconds*1000.0,
+           perSecond/(1024.0*1024.0));
+}
+
+bool sameOutput(const char *what, const std::vector<uint8_t> &expected,
+                const std::vector<uint8_t> &output, const std::vector<uint8_t> &original)
+{
+    if(memcmp(expected.data(), output.data(), original.size()) != 0)
+    {
+        printf("%s: the engine decoder differs from the reference!\n", what);
+        return false;
+    }
+
+    if(memcmp(original.data(), output.data(), original.size()) != 0)
+    {
+        printf("%s: the decoded data differs from the original!\n", what);
+        return false;
+    }
+
+    return true;
+}
+
+}
+
+
+int main(int argc, char *argv[])
+{
+    size_t size = 1024*1024;
+    unsigned int passes = 5;
+    unsigned int seed = 1;
+
+    for(int i = 1 ; i < argc ; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = (i+1 < argc);
+
+        if(arg == "-h" || arg == "--help")
+        {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else if(arg == "-s" && hasValue)
+            size = size_t(atol(argv[++i]))*1024;
+        else if(arg == "-p" && hasValue)
+            passes = unsigned(atoi(argv[++i]));
+        else if(arg == "--seed" && hasValue)
+            seed = unsigned(atoi(argv[++i]));
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(size == 0 || passes == 0)
+    {
+        printf("The size and the passes must be greater than zero.\n");
+        return 1;
+    }
+
+    const std::vector<uint8_t> original = makeSyntheticAsset(size, seed);
+
+    // Huffman, the way CA_CacheGrChunk gets its data
+    std::vector<RefHuffNode> dict = makeHuffDict(original);
+    std::vector<uint8_t> huffed = huffCompress(original, dict);
+    huffnode *engineDict = reinterpret_cast<huffnode*>(dict.data());
+    CAL_OptimizeNodes(engineDict);
+
+    // LZHUF, the way the Softlib archives of the loading screens are packed
+    std::vector<uint8_t> lzhed(size + size/8 + 1024);
+    {
+        void *src = const_cast<uint8_t*>(original.data());
+        void *dst = lzhed.data();
+        const id0_long_t packedSize = lzhCompress(src, dst, id0_unsigned_long_t(size), SRC_MEM|DEST_MEM);
+        lzhed.resize(size_t(packedSize));
+    }
+
+    printf("Synthetic data: %lu bytes, huffman %lu bytes, lzhuf %lu bytes\n\n",
+           static_cast<unsigned long>(size),
+           static_cast<unsigned long>(huffed.size()),
+           static_cast<unsigned long>(lzhed.size()));
+
+    std::vector<uint8_t> expected(size + DEST_SLACK);
+    std::vector<uint8_t> output(size + DEST_SLACK);
+    std::vector<StageResult> results;
+    bool same = true;
+
+    results.push_back(runStage("huff-ref", size, passes, [&]
+    {
+        refHuffExpand(huffed.data(), expected.data(), int32_t(size), dict.data());
+    }));
+    results.push_back(runStage("huff", size, passes, [&]
+    {
+        CAL_HuffExpand(huffed.data(), output.data(), id0_long_t(size), engineDict);
+    }));
+    same &= sameOutput("huff", expected, output, original);
+
+    results.push_back(runStage("lzh-ref", size, passes, [&]
+    {
+        refLzhDecompress(lzhed.data(), expected.data(), uint32_t(size), uint32_t(lzhed.size()));
+    }));
+    results.push_back(runStage("lzh", size, passes, [&]
+    {
+        lzhDecompress(lzhed.data(), output.data(), id0_unsigned_long_t(size),
+                      id0_unsigned_long_t(lzhed.size()), SRC_MEM|DEST_MEM);
+    }));
+    same &= sameOutput("lzh", expected, output, original);
+
+    printf("%-10s %12s %12s %12s\n", "stage", "bytes", "best ms", "MB/s");
+    for(const auto &result : results)
+        printResult(result);
+
+    printf("\n%s\n", same ? "The outputs are the same." : "The outputs differ!");
+    return same ? 0 : 1;
+}
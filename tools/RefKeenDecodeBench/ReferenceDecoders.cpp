@@ -0,0 +1,300 @@
+/*
+ * ReferenceDecoders.cpp
+ *
+ *  Created on: 18.10.2026
+ */
+
+#include "ReferenceDecoders.h"
+
+#include <cstring>
+
+// The position tables are the same for both decoders, so they are taken from lzhuf.cpp
+extern "C" uint8_t d_code[256];
+extern "C" uint8_t d_len[256];
+
+void refHuffExpand(const uint8_t *source, uint8_t *dest,
+                   const int32_t length, const RefHuffNode *hufftable)
+{
+    const RefHuffNode *headptr = hufftable+254; // head node is always node 254
+    const RefHuffNode *nodeon = headptr;
+
+    const uint8_t *srcptr = source;
+    uint8_t *dstptr = dest;
+    uint8_t *dstendptr = dest+length;
+    uint8_t byteval = *(srcptr++); // load first byte
+    uint8_t bitmask = 1;
+
+    do
+    {
+        // take bit0 or bit1 path from node
+        const uint16_t code = (byteval & bitmask) ? nodeon->bit1 : nodeon->bit0;
+        if(bitmask & 0x80)
+        {
+            byteval = *(srcptr++); // load next byte
+            bitmask = 1; // back to first bit
+        }
+        else
+        {
+            bitmask <<= 1; // advance to next bit position
+        }
+
+        // if < 256 it's a byte, else move node
+        if(code >= 256)
+        {
+            nodeon = hufftable + (code-256);
+            continue;
+        }
+
+        *(dstptr++) = uint8_t(code); // write a decompressed byte out
+        nodeon = headptr; // back to the head node for next bit
+    } while(dstptr != dstendptr);
+}
+
+
+namespace
+{
+
+// LZSS and Huffman parameters of lzhuf.cpp
+const int N = 4096;
+const int F = 30;
+const int THRESHOLD = 2;
+const int N_CHAR = (256 - THRESHOLD + F);
+const int T = (N_CHAR * 2 - 1);
+const int R = (T - 1);
+const unsigned MAX_FREQ = 0x8000;
+
+// The types are those of the engine (id0_int_t and id0_unsigned_t), so the tree behaves the same
+int16_t son[T];
+int16_t prnt[T + N_CHAR];
+uint16_t freq[T + 1];
+uint8_t text_buf[N + F - 1];
+
+uint16_t getbuf;
+uint8_t getlen;
+
+const uint8_t *inptr;
+uint32_t inleft;
+
+void StartHuff()
+{
+    int16_t i, j;
+
+    for(i = 0; i < N_CHAR; i++)
+    {
+        freq[i] = 1;
+        son[i] = i + T;
+        prnt[i + T] = i;
+    }
+    i = 0; j = N_CHAR;
+    while(j <= R)
+    {
+        freq[j] = freq[i] + freq[i + 1];
+        son[j] = i;
+        prnt[i] = prnt[i + 1] = j;
+        i += 2; j++;
+    }
+    freq[T] = 0xffff;
+    prnt[R] = 0;
+}
+
+void reconst()
+{
+    int16_t i, j, k;
+    uint16_t f, l;
+
+    j = 0;
+    for(i = 0; i < T; i++)
+    {
+        if(son[i] >= T)
+        {
+            freq[j] = (freq[i] + 1) / 2;
+            son[j] = son[i];
+            j++;
+        }
+    }
+
+    for(i = 0, j = N_CHAR; j < T; i += 2, j++)
+    {
+        k = i + 1;
+        f = freq[j] = freq[i] + freq[k];
+
+        for(k = j - 1; f < freq[k]; k--);
+
+        k++;
+        l = (j - k) * 2;
+
+        memmove(&freq[k + 1], &freq[k], l);
+        freq[k] = f;
+
+        memmove(&son[k + 1], &son[k], l);
+        son[k] = i;
+    }
+
+    for(i = 0; i < T; i++)
+    {
+        if((k = son[i]) >= T)
+            prnt[k] = i;
+        else
+            prnt[k] = prnt[k + 1] = i;
+    }
+}
+
+void update(int16_t c)
+{
+    int16_t i, j, k, l;
+
+    if(freq[R] == MAX_FREQ)
+        reconst();
+
+    c = prnt[c + T];
+
+    do {
+        k = ++freq[c];
+
+        if(k > freq[l = c + 1])
+        {
+            while(k > freq[++l]);
+
+            l--;
+            freq[c] = freq[l];
+            freq[l] = k;
+
+            i = son[c];
+            prnt[i] = l;
+            if(i < T)
+                prnt[i + 1] = l;
+
+            j = son[l];
+            son[l] = i;
+
+            prnt[j] = c;
+            if(j < T)
+                prnt[j + 1] = c;
+
+            son[c] = j;
+
+            c = l;
+        }
+    } while((c = prnt[c]) != 0);
+}
+
+void refill()
+{
+    while(getlen <= 8)
+    {
+        uint16_t i = 0;
+        if(inleft)
+        {
+            i = *(inptr++);
+            inleft--;
+        }
+
+        getbuf |= i << (8 - getlen);
+        getlen += 8;
+    }
+}
+
+int16_t GetByte()
+{
+    refill();
+
+    const uint16_t i = getbuf;
+    getbuf <<= 8;
+    getlen -= 8;
+    return i>>8;
+}
+
+int16_t GetBit()
+{
+    refill();
+
+    const int16_t i = int16_t(getbuf);
+    getbuf <<= 1;
+    getlen--;
+    return (i < 0);
+}
+
+int16_t DecodeChar()
+{
+    uint16_t c = son[R];
+
+    while(c < T)
+    {
+        c += GetBit();
+        c = son[c];
+    }
+
+    c -= T;
+    update(c);
+    return c;
+}
+
+int16_t DecodePosition()
+{
+    uint16_t i, j, c;
+
+    i = GetByte();
+    c = unsigned(d_code[i]) << 6;
+    j = d_len[i];
+
+    j -= 2;
+    while(j--)
+        i = (i << 1) + GetBit();
+
+    return c | (i & 0x3f);
+}
+
+}
+
+
+int32_t refLzhDecompress(const uint8_t *source, uint8_t *dest,
+                         const uint32_t originalLength, uint32_t compressLength)
+{
+    int16_t i, j, k, r, c;
+    uint32_t count;
+
+    inptr = source;
+    inleft = compressLength;
+    getbuf = 0;
+    getlen = 0;
+
+    if(originalLength == 0)
+        return 0;
+
+    StartHuff();
+    for(i = 0; i < N - F; i++)
+        text_buf[i] = ' ';
+
+    r = N - F;
+
+    for(count = 0; count < originalLength; )
+    {
+        c = DecodeChar();
+
+        if(c < 256)
+        {
+            *(dest++) = uint8_t(c);
+
+            text_buf[r++] = uint8_t(c);
+            r &= (N - 1);
+            count++;
+        }
+        else
+        {
+            i = (r - DecodePosition() - 1) & (N - 1);
+            j = c - 255 + THRESHOLD;
+
+            for(k = 0; k < j; k++)
+            {
+                c = text_buf[(i + k) & (N - 1)];
+                *(dest++) = uint8_t(c);
+
+                text_buf[r++] = uint8_t(c);
+                r &= (N - 1);
+                count++;
+            }
+        }
+    }
+
+    return int32_t(count);
+}
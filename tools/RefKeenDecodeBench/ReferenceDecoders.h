@@ -0,0 +1,37 @@
+/*
+ * ReferenceDecoders.h
+ *
+ *  Created on: 18.10.2026
+ *
+ *  The Huffman and LZHUF decoders of Keen Dreams as they were before they got
+ *  their lookup tables and bit buffers: one bit at a time. They are only here
+ *  to check the engine decoders against them and to have something to compare
+ *  the speed with.
+ */
+
+#ifndef REFERENCEDECODERS_H_
+#define REFERENCEDECODERS_H_
+
+#include <cstdint>
+
+/// Same layout as huffnode of id_ca.h
+struct RefHuffNode
+{
+    uint16_t bit0, bit1;    // 0-255 is a character, > is 256 + the number of a node
+};
+
+/**
+ * \brief Expands length bytes out of a huffman compressed source.
+ *        The head node is always node 254 of hufftable.
+ */
+void refHuffExpand(const uint8_t *source, uint8_t *dest,
+                   const int32_t length, const RefHuffNode *hufftable);
+
+/**
+ * \brief Expands LZHUF compressed data which is in memory
+ * \return number of bytes written, which is originalLength
+ */
+int32_t refLzhDecompress(const uint8_t *source, uint8_t *dest,
+                         const uint32_t originalLength, uint32_t compressLength);
+
+#endif /* REFERENCEDECODERS_H_ */
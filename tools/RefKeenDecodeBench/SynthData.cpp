@@ -0,0 +1,160 @@
+/*
+ * SynthData.cpp
+ *
+ *  Created on: 18.10.2026
+ */
+
+#include "SynthData.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace
+{
+
+// Small LCG, so the data is the same with every compiler and library
+struct Random
+{
+    explicit Random(const unsigned int seed) : state(seed*2654435761u + 1) {}
+
+    unsigned int next(const unsigned int range)
+    {
+        state = state*1103515245u + 12345u;
+        return (state >> 8) % range;
+    }
+
+    unsigned int state;
+};
+
+// Mostly a few common values, rarely anything else
+uint8_t commonValue(Random &rnd)
+{
+    static const uint8_t common[] = { 0x00, 0xFF, 0x11, 0x22, 0x44, 0x88, 0x0F, 0xF0 };
+
+    if(rnd.next(64) != 0)
+        return common[rnd.next(sizeof(common))];
+
+    return uint8_t(rnd.next(256));
+}
+
+void collectCodes(const std::vector<RefHuffNode> &dict, const uint16_t node,
+                  std::vector<uint8_t> &path, std::vector< std::vector<uint8_t> > &codes)
+{
+    for(uint8_t bit = 0 ; bit < 2 ; bit++)
+    {
+        const uint16_t code = bit ? dict[node].bit1 : dict[node].bit0;
+
+        path.push_back(bit);
+        if(code < 256)
+            codes[code] = path;
+        else
+            collectCodes(dict, code-256, path, codes);
+        path.pop_back();
+    }
+}
+
+}
+
+
+std::vector<uint8_t> makeSyntheticAsset(const size_t size, const unsigned int seed)
+{
+    Random rnd(seed);
+    std::vector<uint8_t> data;
+    data.reserve(size);
+
+    while(data.size() < size)
+    {
+        const unsigned int mode = rnd.next(8);
+
+        if(mode < 3)            // run of one value
+        {
+            const uint8_t value = commonValue(rnd);
+            for(unsigned int i = 4 + rnd.next(60) ; i > 0 ; i--)
+                data.push_back(value);
+        }
+        else if(mode < 6 && data.size() > 64)   // repeat an earlier piece
+        {
+            const size_t back = 1 + rnd.next(unsigned(std::min<size_t>(data.size(), 4000)));
+            const size_t from = data.size() - back;
+            for(unsigned int i = 0, len = 3 + rnd.next(30) ; i < len ; i++)
+                data.push_back(data[from + i]);
+        }
+        else                    // noise
+        {
+            for(unsigned int i = 1 + rnd.next(16) ; i > 0 ; i--)
+                data.push_back(commonValue(rnd));
+        }
+    }
+
+    data.resize(size);
+    return data;
+}
+
+
+std::vector<RefHuffNode> makeHuffDict(const std::vector<uint8_t> &data)
+{
+    unsigned long counts[256];
+    for(auto &count : counts)
+        count = 1;
+    for(const auto value : data)
+        counts[value]++;
+
+    // (count, code) with the smallest on top. Equal counts are taken by code, so the tree is always the same.
+    typedef std::pair<unsigned long, uint16_t> Weight;
+    std::priority_queue< Weight, std::vector<Weight>, std::greater<Weight> > queue;
+
+    for(uint16_t value = 0 ; value < 256 ; value++)
+        queue.push(Weight(counts[value], value));
+
+    std::vector<RefHuffNode> dict(255);
+
+    for(uint16_t node = 0 ; node < 255 ; node++)
+    {
+        const Weight first = queue.top();
+        queue.pop();
+        const Weight second = queue.top();
+        queue.pop();
+
+        dict[node].bit0 = first.second;
+        dict[node].bit1 = second.second;
+        queue.push(Weight(first.first + second.first, uint16_t(256 + node)));
+    }
+
+    return dict;
+}
+
+
+std::vector<uint8_t> huffCompress(const std::vector<uint8_t> &data,
+                                  const std::vector<RefHuffNode> &dict)
+{
+    std::vector< std::vector<uint8_t> > codes(256);
+    std::vector<uint8_t> path;
+    collectCodes(dict, 254, path, codes);
+
+    std::vector<uint8_t> packed;
+    uint8_t byteval = 0;
+    uint8_t bitmask = 1;
+
+    for(const auto value : data)
+    {
+        for(const auto bit : codes[value])
+        {
+            if(bit)
+                byteval |= bitmask;
+
+            bitmask <<= 1;
+            if(!bitmask)
+            {
+                packed.push_back(byteval);
+                byteval = 0;
+                bitmask = 1;
+            }
+        }
+    }
+
+    packed.push_back(byteval);
+    packed.insert(packed.end(), 4, 0);
+    return packed;
+}
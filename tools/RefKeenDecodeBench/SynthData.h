@@ -0,0 +1,41 @@
+/*
+ * SynthData.h
+ *
+ *  Created on: 18.10.2026
+ *
+ *  Game-like data which is generated instead of read from the Keen Dreams files,
+ *  so the benchmark runs without them and always decodes the same.
+ */
+
+#ifndef SYNTHDATA_H_
+#define SYNTHDATA_H_
+
+#include "ReferenceDecoders.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * \brief Makes data which looks a bit like graphics: runs of one color,
+ *        repeated pieces and some noise over a small set of common values.
+ *        Rare values get huffman codes longer than eight bits.
+ * \param size      bytes to make
+ * \param seed      different seeds give different, but always the same data
+ */
+std::vector<uint8_t> makeSyntheticAsset(const size_t size, const unsigned int seed = 1);
+
+/**
+ * \brief Builds a huffman dictionary for data the way the id tools do:
+ *        255 nodes, the head node is node 254 and every byte value has a code.
+ */
+std::vector<RefHuffNode> makeHuffDict(const std::vector<uint8_t> &data);
+
+/**
+ * \brief Compresses data with the dictionary. The bits of every byte are used
+ *        from the lowest one up. A few padding bytes follow, since the original
+ *        decoder may read one byte more than it needs.
+ */
+std::vector<uint8_t> huffCompress(const std::vector<uint8_t> &data,
+                                  const std::vector<RefHuffNode> &dict);
+
+#endif /* SYNTHDATA_H_ */
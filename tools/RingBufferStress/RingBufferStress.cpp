@@ -0,0 +1,253 @@
+/*
+ * RingBufferStress.cpp
+ *
+ *  Created on: 18.10.2026
+ *
+ *  A producer and a consumer thread pass sequence numbers through the RingBuffer
+ *  in chunks of random size. The consumer checks that every number arrives
+ *  exactly once and in order.
+ */
+
+#include "CRingBuffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+void printUsage(const char *program)
+{
+    printf("Usage: %s [options]\n\n", program);
+    printf("Options:\n");
+    printf("  -n <elements>     sequence numbers passed per capacity (default: 2000000)\n");
+    printf("  -c <capacity>     only test this capacity (default: 1, 2, 3, 7, 64, 1000, 4096 and 44100)\n");
+    printf("  --seed <number>   seed of the chunk sizes (default: 1)\n");
+}
+
+// Small xorshift generator, so the chunk sizes are the same on every platform
+class Random
+{
+public:
+    explicit Random(const uint32_t seed) :
+        mState(seed ? seed : 1) {}
+
+    uint32_t next()
+    {
+        mState ^= mState << 13;
+        mState ^= mState >> 17;
+        mState ^= mState << 5;
+        return mState;
+    }
+
+private:
+    uint32_t mState;
+};
+
+// Chunks up to twice the capacity, so full and partial transfers both happen
+size_t chunkSize(Random &random, const size_t capacity)
+{
+    return 1 + random.next() % (2*capacity);
+}
+
+void produce(RingBuffer<uint32_t> &ring, const uint32_t total,
+             const uint32_t seed, const std::atomic<bool> &failed)
+{
+    Random random(seed);
+    std::vector<uint32_t> chunk(2*ring.capacity());
+    uint32_t next = 0;
+
+    while(next < total && !failed.load(std::memory_order_relaxed))
+    {
+        const size_t wanted = std::min<size_t>(chunkSize(random, ring.capacity()), total - next);
+        size_t written;
+
+        if(random.next() & 1)
+        {
+            for(size_t i = 0 ; i < wanted ; i++)
+                chunk[i] = next + uint32_t(i);
+
+            written = ring.push(chunk.data(), wanted);
+        }
+        else
+        {
+            const auto spans = ring.writeSpans(wanted);
+
+            for(size_t i = 0 ; i < spans.first.size ; i++)
+                spans.first.data[i] = next + uint32_t(i);
+            for(size_t i = 0 ; i < spans.second.size ; i++)
+                spans.second.data[i] = next + uint32_t(spans.first.size + i);
+
+            ring.commitWrite(spans.size());
+            written = spans.size();
+        }
+
+        next += uint32_t(written);
+
+        if(written == 0)
+            std::this_thread::yield();
+    }
+}
+
+// Returns false at the first number which was not expected
+bool consume(RingBuffer<uint32_t> &ring, const uint32_t total,
+             const uint32_t seed, std::atomic<bool> &failed)
+{
+    Random random(seed);
+    std::vector<uint32_t> chunk(2*ring.capacity());
+    uint32_t expected = 0;
+
+    auto check = [&](const uint32_t value) -> bool
+    {
+        if(value == expected)
+        {
+            expected++;
+            return true;
+        }
+
+        printf("  Got %u where %u was expected!\n", value, expected);
+        failed = true;
+        return false;
+    };
+
+    while(expected < total)
+    {
+        const size_t available = ring.readAvailable();
+        if(available > ring.capacity())
+        {
+            printf("  %zu elements are available in a ring of %zu!\n", available, ring.capacity());
+            failed = true;
+            return false;
+        }
+
+        const size_t wanted = chunkSize(random, ring.capacity());
+        size_t read;
+
+        if(random.next() & 1)
+        {
+            read = ring.pop(chunk.data(), wanted);
+
+            for(size_t i = 0 ; i < read ; i++)
+            {
+                if(!check(chunk[i]))
+                    return false;
+            }
+        }
+        else
+        {
+            const auto spans = ring.readSpans(wanted);
+
+            for(size_t i = 0 ; i < spans.first.size ; i++)
+            {
+                if(!check(spans.first.data[i]))
+                    return false;
+            }
+            for(size_t i = 0 ; i < spans.second.size ; i++)
+            {
+                if(!check(spans.second.data[i]))
+                    return false;
+            }
+
+            ring.commitRead(spans.size());
+            read = spans.size();
+        }
+
+        if(read == 0)
+            std::this_thread::yield();
+    }
+
+    if(ring.readAvailable() != 0)
+    {
+        printf("  The ring has more elements than were written!\n");
+        failed = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool runCapacity(const size_t capacity, const uint32_t total, const uint32_t seed)
+{
+    RingBuffer<uint32_t> ring(capacity);
+    std::atomic<bool> failed(false);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::thread producer(produce, std::ref(ring), total, seed, std::cref(failed));
+    const bool ok = consume(ring, total, seed*2654435761u + 1, failed);
+    producer.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("capacity %-8zu %s  %8.2f M elements/s\n", capacity,
+           ok ? "ok    " : "FAILED", (seconds > 0.0) ? total/seconds/1e6 : 0.0);
+
+    return ok;
+}
+
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint32_t total = 2000000;
+    uint32_t seed = 1;
+    std::vector<size_t> capacities;
+
+    for(int i = 1 ; i < argc ; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = (i+1 < argc);
+
+        if(arg == "--help")
+        {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else if(arg == "-n" && hasValue)
+            total = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else if(arg == "-c" && hasValue)
+            capacities.push_back(size_t(strtoul(argv[++i], nullptr, 10)));
+        else if(arg == "--seed" && hasValue)
+            seed = uint32_t(strtoul(argv[++i], nullptr, 10));
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(capacities.empty())
+        capacities = { 1, 2, 3, 7, 64, 1000, 4096, 44100 };
+
+    for(const size_t capacity : capacities)
+    {
+        if(capacity == 0)
+        {
+            printf("The capacity must be greater than zero.\n");
+            return 1;
+        }
+    }
+
+    bool ok = true;
+
+    for(const size_t capacity : capacities)
+    {
+        if(!runCapacity(capacity, total, seed))
+            ok = false;
+    }
+
+    if(!ok)
+    {
+        printf("\nThe ring buffer lost, doubled or reordered elements!\n");
+        return 1;
+    }
+
+    return 0;
+}